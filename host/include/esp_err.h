@@ -0,0 +1,46 @@
+/*!
+ * @brief Host stand-in for the ESP-IDF error codes
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_HOST_ESP_ERR_H_
+#define _UNIT_ENV_III_HOST_ESP_ERR_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK                      0
+#define ESP_FAIL                    -1
+#define ESP_ERR_NO_MEM              0x101
+#define ESP_ERR_INVALID_ARG         0x102
+#define ESP_ERR_INVALID_STATE       0x103
+#define ESP_ERR_INVALID_SIZE        0x104
+#define ESP_ERR_NOT_FOUND           0x105
+#define ESP_ERR_NOT_SUPPORTED       0x106
+#define ESP_ERR_TIMEOUT             0x107
+#define ESP_ERR_INVALID_RESPONSE    0x108
+#define ESP_ERR_INVALID_CRC         0x109
+#define ESP_ERR_INVALID_VERSION     0x10A
+
+#define ESP_ERROR_CHECK( x ) do { esp_err_t __ = ( x ); if ( __ != ESP_OK ) abort(); } while ( 0 )
+
+#endif
@@ -0,0 +1,36 @@
+/*!
+ * @brief Host stand-in for the ESP-IDF log macros, debug output is dropped
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_HOST_ESP_LOG_H_
+#define _UNIT_ENV_III_HOST_ESP_LOG_H_
+
+#include <stdio.h>
+#include "esp_err.h"
+
+#define _HOST_LOG( level, tag, ... ) do { fprintf( stderr, level " (%s) ", tag ); fprintf( stderr, __VA_ARGS__ ); fputc( '\n', stderr ); } while ( 0 )
+
+#define ESP_LOGE( tag, ... )    _HOST_LOG( "E", tag, __VA_ARGS__ )
+#define ESP_LOGW( tag, ... )    _HOST_LOG( "W", tag, __VA_ARGS__ )
+#define ESP_LOGI( tag, ... )    _HOST_LOG( "I", tag, __VA_ARGS__ )
+#define ESP_LOGD( tag, ... )    do { ( void )( tag ); } while ( 0 )
+
+#endif
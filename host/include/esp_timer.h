@@ -0,0 +1,30 @@
+/*!
+ * @brief Host stand-in for the ESP-IDF high resolution timer
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_HOST_ESP_TIMER_H_
+#define _UNIT_ENV_III_HOST_ESP_TIMER_H_
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time( void );
+
+#endif
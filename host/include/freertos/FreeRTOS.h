@@ -0,0 +1,63 @@
+/*!
+ * @brief Host stand-in for the FreeRTOS base types, single threaded
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_HOST_FREERTOS_H_
+#define _UNIT_ENV_III_HOST_FREERTOS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define pdTRUE                          1
+#define pdFALSE                         0
+#define pdPASS                          pdTRUE
+#define pdFAIL                          pdFALSE
+#define portMAX_DELAY                   ( ( TickType_t )0xffffffffUL )
+#define portTICK_PERIOD_MS              10
+#define pdMS_TO_TICKS( ms )             ( ( TickType_t )( ( ms ) / portTICK_PERIOD_MS ) )
+
+// the host tools run on one thread, critical sections only have to compile
+typedef struct
+{
+    int owner;
+    int count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0, 0 }
+#define portENTER_CRITICAL( mux )       do { ( mux )->count++; } while ( 0 )
+#define portEXIT_CRITICAL( mux )        do { ( mux )->count--; } while ( 0 )
+
+typedef struct
+{
+    UBaseType_t count;
+    UBaseType_t max;
+} StaticSemaphore_t;
+
+typedef StaticSemaphore_t *SemaphoreHandle_t;
+typedef struct host_queue *QueueHandle_t;
+typedef struct host_task *TaskHandle_t;
+
+#endif
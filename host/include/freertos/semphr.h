@@ -0,0 +1,34 @@
+/*!
+ * @brief Host stand-in for the FreeRTOS semaphores, a take never blocks
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_HOST_SEMPHR_H_
+#define _UNIT_ENV_III_HOST_SEMPHR_H_
+
+#include "freertos/FreeRTOS.h"
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic( StaticSemaphore_t *buffer );
+SemaphoreHandle_t xSemaphoreCreateMutexStatic( StaticSemaphore_t *buffer );
+SemaphoreHandle_t xSemaphoreCreateCountingStatic( UBaseType_t max_count, UBaseType_t initial_count, StaticSemaphore_t *buffer );
+BaseType_t xSemaphoreTake( SemaphoreHandle_t semaphore, TickType_t ticks_to_wait );
+BaseType_t xSemaphoreGive( SemaphoreHandle_t semaphore );
+
+#endif
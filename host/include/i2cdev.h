@@ -0,0 +1,54 @@
+/*!
+ * @brief Host stand-in for the esp-idf-lib I2C device layer, every transfer fails
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_HOST_I2CDEV_H_
+#define _UNIT_ENV_III_HOST_I2CDEV_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct
+{
+    int sda_io_num;
+    int scl_io_num;
+    struct
+    {
+        uint32_t clk_speed;
+    } master;
+} i2c_config_t;
+
+typedef struct
+{
+    int port;
+    uint8_t addr;
+    i2c_config_t cfg;
+    void *mutex;
+} i2c_dev_t;
+
+esp_err_t i2c_dev_create_mutex( i2c_dev_t *dev );
+esp_err_t i2c_dev_read( const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size );
+esp_err_t i2c_dev_write( const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size, const void *out_data, size_t out_size );
+esp_err_t i2c_dev_read_reg( const i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size );
+esp_err_t i2c_dev_write_reg( const i2c_dev_t *dev, uint8_t reg, const void *out_data, size_t out_size );
+
+#endif
@@ -0,0 +1,62 @@
+/*!
+ * @brief Host stand-in for the esp-idf-lib SHT3x driver
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_HOST_SHT3X_H_
+#define _UNIT_ENV_III_HOST_SHT3X_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "i2cdev.h"
+
+#define SHT3X_I2C_ADDR_GND      0x44
+
+typedef uint8_t sht3x_raw_data_t[ 6 ];
+
+typedef enum
+{
+    SHT3X_SINGLE_SHOT = 0,
+    SHT3X_PERIODIC_05MPS,
+} sht3x_mode_t;
+
+typedef enum
+{
+    SHT3X_HIGH = 0,
+    SHT3X_MEDIUM,
+    SHT3X_LOW,
+} sht3x_repeat_t;
+
+typedef struct
+{
+    i2c_dev_t i2c_dev;
+    sht3x_mode_t mode;
+    sht3x_repeat_t repeatability;
+    bool meas_started;
+    uint64_t meas_start_time;
+    bool meas_first;
+} sht3x_t;
+
+esp_err_t sht3x_init_desc( sht3x_t *dev, uint8_t addr, int port, int sda_gpio, int scl_gpio );
+esp_err_t sht3x_init( sht3x_t *dev );
+esp_err_t sht3x_start_measurement( sht3x_t *dev, sht3x_mode_t mode, sht3x_repeat_t repeat );
+uint8_t sht3x_get_measurement_duration( sht3x_repeat_t repeat );
+
+#endif
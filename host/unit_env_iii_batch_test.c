@@ -0,0 +1,222 @@
+/*!
+ * @brief Host loopback test of the batching uploader
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unit_env_iii_batch.h"
+
+#define TEST_SAMPLES        200
+#define TEST_BATCH_SAMPLES  32
+#define TEST_START_US       1700000000000000LL
+
+typedef struct
+{
+    bool down;                                      /*!< Every publish fails */
+    uint8_t fail_next;                              /*!< Publishes left to fail */
+    uint32_t attempts;                              /*!< Publish calls */
+    size_t received;                                /*!< Samples decoded */
+    unit_enviii_sample_t samples[ TEST_SAMPLES ];   /*!< Samples decoded, in order */
+} batch_test_link_t;
+
+static void _batch_test_sample( int index, unit_enviii_sample_t *sample );
+static bool _batch_test_same( const unit_enviii_sample_t *received, int index );
+static esp_err_t _batch_test_publish( const uint8_t *payload, size_t length, uint16_t samples, void *user );
+static int _batch_test_loopback( void );
+static int _batch_test_outage( unit_enviii_batch_policy_t policy, const char *name );
+
+/* Sample index of the test stream. Some samples lack the pressure channel
+ * and some carry flags above the 16 bits a payload keeps */
+static void _batch_test_sample( int index, unit_enviii_sample_t *sample )
+{
+    *sample = ( unit_enviii_sample_t ){
+        .timestamp_us = TEST_START_US + ( int64_t )index * 5000123,
+        .channels = index % 7 ? UNIT_ENVIII_CHANNEL_ALL : UNIT_ENVIII_CHANNEL_BIT( 0 ) | UNIT_ENVIII_CHANNEL_BIT( 1 ),
+        .value = { 23000 + ( index % 5 ) * 13, 45000 - index * 7, 1013250 + ( index * 37 ) % 91 - 45 },
+        .flags = index % 50 ? 0 : 0x10004,
+    };
+}
+
+static bool _batch_test_same( const unit_enviii_sample_t *received, int index )
+{
+    unit_enviii_sample_t expected;
+
+    _batch_test_sample( index, &expected );
+    if ( received->timestamp_us != expected.timestamp_us / 1000 * 1000 || received->channels != expected.channels ||
+         received->flags != ( expected.flags & 0xFFFF ) )
+        return false;
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        if ( ( expected.channels & UNIT_ENVIII_CHANNEL_BIT( channel ) ) && received->value[ channel ] != expected.value[ channel ] )
+            return false;
+    }
+
+    return true;
+}
+
+static esp_err_t _batch_test_publish( const uint8_t *payload, size_t length, uint16_t samples, void *user )
+{
+    batch_test_link_t *link = ( batch_test_link_t * )user;
+    size_t count;
+
+    link->attempts++;
+    if ( link->down )
+        return ESP_FAIL;
+    if ( link->fail_next > 0 )
+    {
+        link->fail_next--;
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = unit_enviii_batch_decode( payload, length, &link->samples[ link->received ], TEST_SAMPLES - link->received, &count );
+    if ( err != ESP_OK || count != samples )
+    {
+        printf( "decoding %u samples failed: %d\n", samples, err );
+        return ESP_OK;
+    }
+    link->received += count;
+
+    return ESP_OK;
+}
+
+/* Every sample arrives once and in order, including the ones of a failed
+ * publish, which go out with the next attempt */
+static int _batch_test_loopback( void )
+{
+    static unit_enviii_batch_t batch;
+    static batch_test_link_t link;
+    unit_enviii_batch_config_t config = {
+        .max_samples = TEST_BATCH_SAMPLES,
+        .policy = UNIT_ENVIII_BATCH_DROP_OLDEST,
+        .publish = _batch_test_publish,
+        .user = &link,
+    };
+    unit_enviii_batch_stats_t stats;
+    uint32_t failed_at = 0;
+
+    memset( &link, 0, sizeof( link ) );
+    unit_enviii_batch_init( &batch, &config );
+    for ( int i = 0; i < TEST_SAMPLES; i++ )
+    {
+        unit_enviii_sample_t sample;
+        _batch_test_sample( i, &sample );
+        unit_enviii_batch_stage_process( &sample, &batch );
+
+        // the second batch fails once
+        if ( i == TEST_BATCH_SAMPLES )
+            link.fail_next = 1;
+        if ( unit_enviii_batch_publish( &batch, 0 ) == ESP_FAIL )
+            failed_at = i;
+    }
+    unit_enviii_batch_flush( &batch );
+    unit_enviii_batch_stats_get( &batch, &stats );
+
+    int bad = 0;
+    for ( size_t i = 0; i < link.received; i++ )
+        bad += !_batch_test_same( &link.samples[ i ], ( int )i );
+
+    printf( "loopback: %zu of %d samples in %lu batches, %lu bytes, %.1f bytes per sample, publish failed at sample %lu, %d wrong\n",
+            link.received, TEST_SAMPLES, ( unsigned long )stats.batches, ( unsigned long )stats.bytes, ( double )stats.bytes / stats.samples,
+            ( unsigned long )failed_at, bad );
+
+    return link.received != TEST_SAMPLES || bad != 0 || stats.samples != TEST_SAMPLES || stats.failures != 1 ||
+           failed_at == 0 || stats.dropped != 0;
+}
+
+/* The link is down for the first 150 samples, more than the queue holds */
+static int _batch_test_outage( unit_enviii_batch_policy_t policy, const char *name )
+{
+    static unit_enviii_batch_t batch;
+    static batch_test_link_t link;
+    unit_enviii_batch_config_t config = {
+        .max_samples = TEST_BATCH_SAMPLES,
+        .policy = policy,
+        .publish = _batch_test_publish,
+        .user = &link,
+    };
+    const int outage = 150;
+    unit_enviii_batch_stats_t stats;
+
+    memset( &link, 0, sizeof( link ) );
+    unit_enviii_batch_init( &batch, &config );
+    link.down = true;
+    for ( int i = 0; i < TEST_SAMPLES; i++ )
+    {
+        unit_enviii_sample_t sample;
+
+        // the uploader retries every 16 samples while the link is down, and catches up as soon as it is back
+        if ( i == outage )
+        {
+            link.down = false;
+            unit_enviii_batch_publish( &batch, 0 );
+        }
+        _batch_test_sample( i, &sample );
+        unit_enviii_batch_stage_process( &sample, &batch );
+        if ( !link.down || i % 16 == 15 )
+            unit_enviii_batch_publish( &batch, 0 );
+    }
+    unit_enviii_batch_flush( &batch );
+    unit_enviii_batch_stats_get( &batch, &stats );
+
+    // the samples each policy keeps through the outage, then everything after it
+    int bad = 0, index = 0, previous = -1;
+    for ( size_t i = 0; i < link.received; i++ )
+    {
+        switch ( policy )
+        {
+        case UNIT_ENVIII_BATCH_DROP_OLDEST:
+            index = ( int )i + outage - UNIT_ENVIII_BATCH_CAPACITY;
+            break;
+        case UNIT_ENVIII_BATCH_DROP_NEWEST:
+            index = ( int )i < UNIT_ENVIII_BATCH_CAPACITY ? ( int )i : ( int )i - UNIT_ENVIII_BATCH_CAPACITY + outage;
+            break;
+        default:
+            // decimation keeps a thinning subset, in order
+            for ( index = previous + 1; index < TEST_SAMPLES && !_batch_test_same( &link.samples[ i ], index ); index++ )
+                ;
+            break;
+        }
+        bad += index >= TEST_SAMPLES || !_batch_test_same( &link.samples[ i ], index );
+        previous = index;
+    }
+
+    printf( "%s: %zu samples through the outage, %lu dropped, %lu decimated, %lu failed publishes, %d wrong\n", name, link.received,
+            ( unsigned long )stats.dropped, ( unsigned long )stats.decimated, ( unsigned long )stats.failures, bad );
+
+    if ( bad != 0 || link.received + stats.dropped + stats.decimated != TEST_SAMPLES )
+        return 1;
+    if ( policy == UNIT_ENVIII_BATCH_DECIMATE )
+        return stats.dropped != 0 || !_batch_test_same( &link.samples[ 0 ], 0 ) || previous != TEST_SAMPLES - 1;
+
+    return stats.dropped != ( uint32_t )( outage - UNIT_ENVIII_BATCH_CAPACITY );
+}
+
+int main( void )
+{
+    int failed = 0;
+
+    failed |= _batch_test_loopback();
+    failed |= _batch_test_outage( UNIT_ENVIII_BATCH_DROP_OLDEST, "drop oldest" );
+    failed |= _batch_test_outage( UNIT_ENVIII_BATCH_DROP_NEWEST, "drop newest" );
+    failed |= _batch_test_outage( UNIT_ENVIII_BATCH_DECIMATE, "decimate" );
+
+    return failed;
+}
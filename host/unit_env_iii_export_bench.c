@@ -0,0 +1,121 @@
+/*!
+ * @brief Host benchmark of the CSV and NDJSON export of a filled history store
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "unit_env_iii_export.h"
+
+#define BENCH_BUDGET        65536
+#define BENCH_DAYS          14
+#define BENCH_PERIOD_US     10000000LL
+#define BENCH_ROUNDS        20
+
+typedef struct
+{
+    uint32_t lines;     /*!< Newlines written */
+    uint32_t bytes;     /*!< Bytes written */
+    bool odd;           /*!< A NUL or a chunk over the chunk size was written */
+} export_bench_sink_t;
+
+static uint32_t _buffer[ BENCH_BUDGET / sizeof( uint32_t ) ];
+
+static esp_err_t _export_bench_check( const char *data, size_t length, void *user );
+static esp_err_t _export_bench_discard( const char *data, size_t length, void *user );
+
+/* Counts the lines and bytes of the first export of each format */
+static esp_err_t _export_bench_check( const char *data, size_t length, void *user )
+{
+    export_bench_sink_t *sink = ( export_bench_sink_t * )user;
+
+    if ( length > UNIT_ENVIII_EXPORT_CHUNK_SIZE || memchr( data, '\0', length ) != NULL )
+        sink->odd = true;
+    for ( size_t i = 0; i < length; i++ )
+        sink->lines += data[ i ] == '\n';
+    sink->bytes += length;
+
+    return ESP_OK;
+}
+
+/* Stands in for a fast file or socket while the export is timed */
+static esp_err_t _export_bench_discard( const char *data, size_t length, void *user )
+{
+    return ESP_OK;
+}
+
+int main( void )
+{
+    static const char *names[] = { "CSV", "NDJSON" };
+    unit_enviii_history_t history;
+    int failed = 0;
+
+    // two weeks every 10 s, more than the budget holds at full resolution
+    if ( unit_enviii_history_init( &history, _buffer, sizeof( _buffer ) ) != ESP_OK )
+        return 1;
+    for ( int64_t i = 0; i < BENCH_DAYS * 8640LL; i++ )
+    {
+        unit_enviii_sample_t sample = {
+            .timestamp_us = 1700000000000000LL + i * BENCH_PERIOD_US,
+            .channels = i % 97 ? UNIT_ENVIII_CHANNEL_ALL : UNIT_ENVIII_CHANNEL_BIT( 0 ),
+            .value = { ( int32_t )( 18000 + ( i * 37 ) % 8000 ), ( int32_t )( 40000 + ( i * 91 ) % 30000 ), ( int32_t )( 1000000 + ( i * 13 ) % 30000 ) },
+        };
+        if ( unit_enviii_history_append( &history, &sample ) != ESP_OK )
+            return 1;
+    }
+    printf( "history: %u buckets in %d bytes\n", history.count, BENCH_BUDGET );
+
+    for ( int format = UNIT_ENVIII_EXPORT_CSV; format <= UNIT_ENVIII_EXPORT_NDJSON; format++ )
+    {
+        static unit_enviii_export_t exporter;
+        export_bench_sink_t sink = { 0 };
+        uint64_t records = 0, bytes = 0;
+        int64_t elapsed = 0;
+
+        unit_enviii_export_begin( &exporter, &history, ( unit_enviii_export_format_t )format );
+        if ( unit_enviii_export_run( &exporter, _export_bench_check, &sink ) != ESP_OK )
+            return 1;
+
+        for ( int round = 0; round < BENCH_ROUNDS; round++ )
+        {
+            unit_enviii_export_begin( &exporter, &history, ( unit_enviii_export_format_t )format );
+            if ( unit_enviii_export_run( &exporter, _export_bench_discard, NULL ) != ESP_OK )
+                return 1;
+            records += exporter.records;
+            bytes += exporter.bytes;
+            elapsed += exporter.elapsed_us;
+        }
+
+        printf( "%-6s: %lu records, %lu bytes, %.0f records/s, %.1f MB/s, %.1f bytes per record\n", names[ format ],
+                ( unsigned long )exporter.records, ( unsigned long )exporter.bytes, records * 1e6 / elapsed, bytes / ( double )elapsed,
+                ( double )exporter.bytes / exporter.records );
+
+        // one line per bucket, plus the header line of CSV
+        uint32_t lines = history.count + ( format == UNIT_ENVIII_EXPORT_CSV );
+        if ( exporter.records != history.count || sink.lines != lines || sink.bytes != exporter.bytes || sink.odd )
+        {
+            printf( "%s: %lu records and %lu lines for %u buckets\n", names[ format ], ( unsigned long )exporter.records,
+                    ( unsigned long )sink.lines, history.count );
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,141 @@
+/*!
+ * @brief Single threaded host port of the ESP-IDF, FreeRTOS and sensor driver calls the host tools link against
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <time.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "i2cdev.h"
+#include "sht3x.h"
+
+int64_t esp_timer_get_time( void )
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return ( int64_t )now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+void vTaskDelay( TickType_t ticks )
+{
+    struct timespec delay = {
+        .tv_sec = ticks * portTICK_PERIOD_MS / 1000,
+        .tv_nsec = ( long )( ticks * portTICK_PERIOD_MS % 1000 ) * 1000000,
+    };
+
+    nanosleep( &delay, NULL );
+}
+
+TickType_t xTaskGetTickCount( void )
+{
+    return ( TickType_t )( esp_timer_get_time() / 1000 / portTICK_PERIOD_MS );
+}
+
+SemaphoreHandle_t xSemaphoreCreateCountingStatic( UBaseType_t max_count, UBaseType_t initial_count, StaticSemaphore_t *buffer )
+{
+    buffer->max = max_count;
+    buffer->count = initial_count;
+    return buffer;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic( StaticSemaphore_t *buffer )
+{
+    return xSemaphoreCreateCountingStatic( 1, 0, buffer );
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic( StaticSemaphore_t *buffer )
+{
+    return xSemaphoreCreateCountingStatic( 1, 1, buffer );
+}
+
+BaseType_t xSemaphoreTake( SemaphoreHandle_t semaphore, TickType_t ticks_to_wait )
+{
+    // nothing else runs that could give it, so waiting would never end
+    if ( semaphore->count == 0 )
+        return pdFALSE;
+
+    semaphore->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive( SemaphoreHandle_t semaphore )
+{
+    if ( semaphore->count >= semaphore->max )
+        return pdFALSE;
+
+    semaphore->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend( QueueHandle_t queue, const void *item, TickType_t ticks_to_wait )
+{
+    return pdFALSE;
+}
+
+esp_err_t i2c_dev_create_mutex( i2c_dev_t *dev )
+{
+    return ESP_OK;
+}
+
+esp_err_t i2c_dev_read( const i2c_dev_t *dev, const void *out_data, size_t out_size, void *in_data, size_t in_size )
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t i2c_dev_write( const i2c_dev_t *dev, const void *out_reg, size_t out_reg_size, const void *out_data, size_t out_size )
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t i2c_dev_read_reg( const i2c_dev_t *dev, uint8_t reg, void *in_data, size_t in_size )
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t i2c_dev_write_reg( const i2c_dev_t *dev, uint8_t reg, const void *out_data, size_t out_size )
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t sht3x_init_desc( sht3x_t *dev, uint8_t addr, int port, int sda_gpio, int scl_gpio )
+{
+    return ESP_OK;
+}
+
+esp_err_t sht3x_init( sht3x_t *dev )
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t sht3x_start_measurement( sht3x_t *dev, sht3x_mode_t mode, sht3x_repeat_t repeat )
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+uint8_t sht3x_get_measurement_duration( sht3x_repeat_t repeat )
+{
+    return 2;
+}
@@ -0,0 +1,274 @@
+/*!
+ * @brief Host benchmark of batch payload compression on a simulated day of indoor data
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_timer.h>
+#include "unit_env_iii_batch.h"
+
+#define BENCH_BATCH_SAMPLES     64
+#define BENCH_DAY_S             86400
+#define BENCH_MAX_SAMPLES       ( BENCH_DAY_S / 10 )
+#define BENCH_START_US          1700000000000000LL
+#define BENCH_TIMING_ROUNDS     50
+#define BENCH_FUZZ_ROUNDS       20000
+
+typedef struct
+{
+    const unit_enviii_sample_t *input;      /*!< Samples fed to the batcher, in order */
+    size_t decoded;                         /*!< Samples decoded from the payloads so far */
+    size_t bytes;                           /*!< Payload bytes published */
+    int mismatches;                         /*!< Samples or payloads that did not round trip */
+    uint8_t *capture;                       /*!< Plain payloads kept for timing, or NULL */
+    size_t captured;                        /*!< Bytes in capture */
+    uint16_t lengths[ BENCH_MAX_SAMPLES / BENCH_BATCH_SAMPLES + 1 ];    /*!< Length of each captured payload */
+    size_t payloads;                        /*!< Payloads in capture */
+} lzss_bench_run_t;
+
+static unit_enviii_sample_t _day[ BENCH_MAX_SAMPLES ];
+static uint8_t _plain[ BENCH_MAX_SAMPLES * 16 ];
+
+static double _lzss_bench_gauss( void );
+static size_t _lzss_bench_day( int period_s, int quantum );
+static esp_err_t _lzss_bench_publish( const uint8_t *payload, size_t length, uint16_t samples, void *user );
+static int _lzss_bench_run( bool compress, int period_s, int quantum, lzss_bench_run_t *run );
+static int _lzss_bench_time( const lzss_bench_run_t *run );
+static int _lzss_bench_fuzz( void );
+
+static double _lzss_bench_gauss( void )
+{
+    double u = ( rand() + 1.0 ) / ( RAND_MAX + 2.0 );
+    double v = ( rand() + 1.0 ) / ( RAND_MAX + 2.0 );
+
+    return sqrt( -2.0 * log( u ) ) * cos( 2.0 * M_PI * v );
+}
+
+/* A day sampled every period_s: a sine shaped ±3 °C and ±8 %RH diurnal
+ * cycle plus sensor noise and pressure as a random walk. Temperature and
+ * humidity are rounded to quantum channel units */
+static size_t _lzss_bench_day( int period_s, int quantum )
+{
+    size_t count = BENCH_DAY_S / period_s;
+    double pressure = 1013250.0;
+
+    srand( 1 );
+    for ( size_t i = 0; i < count; i++ )
+    {
+        double day = i * period_s / ( double )BENCH_DAY_S;
+        double temperature = 22000.0 + 3000.0 * sin( 2.0 * M_PI * ( day - 0.375 ) ) + 15.0 * _lzss_bench_gauss();
+        double humidity = 45000.0 - 8000.0 * sin( 2.0 * M_PI * ( day - 0.375 ) ) + 50.0 * _lzss_bench_gauss();
+        pressure += 2.0 * _lzss_bench_gauss();
+        double reading = pressure + 5.0 * _lzss_bench_gauss();
+
+        _day[ i ] = ( unit_enviii_sample_t ){
+            .timestamp_us = BENCH_START_US + ( int64_t )i * period_s * 1000000,
+            .channels = UNIT_ENVIII_CHANNEL_ALL,
+            .value = {
+                ( int32_t )( round( temperature / quantum ) * quantum ),
+                ( int32_t )( round( humidity / quantum ) * quantum ),
+                ( int32_t )round( reading ),
+            },
+        };
+    }
+
+    return count;
+}
+
+static esp_err_t _lzss_bench_publish( const uint8_t *payload, size_t length, uint16_t samples, void *user )
+{
+    lzss_bench_run_t *run = ( lzss_bench_run_t * )user;
+    unit_enviii_sample_t decoded[ BENCH_BATCH_SAMPLES ];
+    uint8_t plain[ UNIT_ENVIII_BATCH_PAYLOAD_SIZE ];
+    size_t plain_length, count;
+
+    run->bytes += length;
+    if ( unit_enviii_batch_inflate( payload, length, plain, sizeof( plain ), &plain_length ) != ESP_OK ||
+         unit_enviii_batch_decode( plain, plain_length, decoded, BENCH_BATCH_SAMPLES, &count ) != ESP_OK || count != samples )
+    {
+        run->mismatches++;
+        return ESP_OK;
+    }
+
+    // timestamps travel in milliseconds
+    for ( size_t i = 0; i < count; i++ )
+    {
+        const unit_enviii_sample_t *expected = &run->input[ run->decoded + i ];
+        if ( decoded[ i ].timestamp_us != expected->timestamp_us / 1000 * 1000 ||
+             memcmp( decoded[ i ].value, expected->value, sizeof( expected->value ) ) != 0 )
+            run->mismatches++;
+    }
+    run->decoded += count;
+
+    if ( run->capture != NULL )
+    {
+        memcpy( run->capture + run->captured, payload, length );
+        run->lengths[ run->payloads++ ] = ( uint16_t )length;
+        run->captured += length;
+    }
+
+    return ESP_OK;
+}
+
+static int _lzss_bench_run( bool compress, int period_s, int quantum, lzss_bench_run_t *run )
+{
+    static unit_enviii_batch_t batch;
+    unit_enviii_batch_config_t config = {
+        .max_samples = BENCH_BATCH_SAMPLES,
+        .max_age_ms = 0,
+        .policy = UNIT_ENVIII_BATCH_DROP_OLDEST,
+        .compress = compress,
+        .publish = _lzss_bench_publish,
+        .user = run,
+    };
+    size_t count = _lzss_bench_day( period_s, quantum );
+
+    run->input = _day;
+    if ( unit_enviii_batch_init( &batch, &config ) != ESP_OK )
+        return 1;
+    for ( size_t i = 0; i < count; i++ )
+    {
+        unit_enviii_sample_t sample = _day[ i ];
+        unit_enviii_batch_stage_process( &sample, &batch );
+        unit_enviii_batch_publish( &batch, 0 );
+    }
+    unit_enviii_batch_flush( &batch );
+
+    printf( "| %d s | %s | %s | %.2f |\n", period_s, quantum == 1 ? "0.001" : "0.01", compress ? "LZSS" : "none",
+            ( double )run->bytes / run->decoded );
+    if ( run->decoded != count || run->mismatches != 0 )
+    {
+        printf( "%zu of %zu samples decoded, %d mismatches\n", run->decoded, count, run->mismatches );
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Compress the plain payloads of a day over and over, the way the batcher
+ * does: the version and count bytes stay plain */
+static int _lzss_bench_time( const lzss_bench_run_t *run )
+{
+    static uint8_t out[ UNIT_ENVIII_BATCH_PAYLOAD_SIZE * 2 ];
+    uint8_t back[ UNIT_ENVIII_BATCH_PAYLOAD_SIZE ];
+    unit_enviii_lzss_t lzss;
+    size_t length, back_length, bytes = 0;
+
+    int64_t start = esp_timer_get_time();
+    for ( int round = 0; round < BENCH_TIMING_ROUNDS; round++ )
+    {
+        const uint8_t *payload = run->capture;
+        for ( size_t i = 0; i < run->payloads; i++ )
+        {
+            unit_enviii_lzss_init( &lzss, out, sizeof( out ) );
+            unit_enviii_lzss_write( &lzss, payload + 2, run->lengths[ i ] - 2 );
+            unit_enviii_lzss_finish( &lzss, &length );
+            bytes += run->lengths[ i ];
+            payload += run->lengths[ i ];
+        }
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    printf( "compression: %.0f us per KB of payload\n", elapsed / ( bytes / 1024.0 ) );
+
+    // the last payload compressed has to come back unchanged
+    const uint8_t *last = run->capture + run->captured - run->lengths[ run->payloads - 1 ];
+    if ( unit_enviii_lzss_decompress( out, length, back, sizeof( back ), &back_length ) != ESP_OK ||
+         back_length != run->lengths[ run->payloads - 1 ] - 2u || memcmp( back, last + 2, back_length ) != 0 )
+    {
+        printf( "compressed payload did not round trip\n" );
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Random inputs over alphabets of 1 to 256 symbols, written in random chunks */
+static int _lzss_bench_fuzz( void )
+{
+    uint8_t in[ 400 ], out[ 500 ], back[ 400 ];
+    unit_enviii_lzss_t lzss;
+    int failures = 0;
+
+    srand( 2 );
+    for ( int round = 0; round < BENCH_FUZZ_ROUNDS; round++ )
+    {
+        size_t count = rand() % sizeof( in ), length, back_length, offset = 0;
+        int alphabet = 1 + rand() % 256;
+
+        for ( size_t i = 0; i < count; i++ )
+            in[ i ] = ( uint8_t )( rand() % alphabet );
+
+        unit_enviii_lzss_init( &lzss, out, sizeof( out ) );
+        while ( offset < count )
+        {
+            size_t chunk = 1 + rand() % 37;
+            if ( chunk > count - offset )
+                chunk = count - offset;
+            if ( unit_enviii_lzss_bound( &lzss, chunk ) > sizeof( out ) )
+                break;
+            unit_enviii_lzss_write( &lzss, in + offset, chunk );
+            offset += chunk;
+        }
+        unit_enviii_lzss_finish( &lzss, &length );
+
+        if ( offset != count || unit_enviii_lzss_decompress( out, length, back, sizeof( back ), &back_length ) != ESP_OK ||
+             back_length != count || memcmp( back, in, count ) != 0 )
+            failures++;
+    }
+    printf( "fuzz: %d of %d round trips failed\n", failures, BENCH_FUZZ_ROUNDS );
+
+    return failures != 0;
+}
+
+int main( void )
+{
+    static const int periods[] = { 10, 60 };
+    static const int quanta[] = { 1, 10 };
+    static lzss_bench_run_t timed;
+    int failed = 0;
+
+    printf( "| Period | Resolution | Compression | Bytes per sample |\n" );
+    printf( "|---|---|---|---|\n" );
+    for ( size_t p = 0; p < sizeof( periods ) / sizeof( periods[ 0 ] ); p++ )
+    {
+        for ( size_t q = 0; q < sizeof( quanta ) / sizeof( quanta[ 0 ] ); q++ )
+        {
+            for ( int compress = 0; compress <= 1; compress++ )
+            {
+                static lzss_bench_run_t run;
+                lzss_bench_run_t *target = ( p == 0 && q == 0 && !compress ) ? &timed : &run;
+
+                memset( target, 0, sizeof( lzss_bench_run_t ) );
+                if ( target == &timed )
+                    target->capture = _plain;
+                failed |= _lzss_bench_run( compress, periods[ p ], quanta[ q ], target );
+            }
+        }
+    }
+
+    failed |= _lzss_bench_time( &timed );
+    failed |= _lzss_bench_fuzz();
+
+    return failed;
+}
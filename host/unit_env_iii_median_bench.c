@@ -0,0 +1,104 @@
+/*!
+ * @brief Host check and benchmark of the streaming median filter
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <esp_timer.h>
+#include "unit_env_iii_median.h"
+
+#define CHECK_SAMPLES   10000
+#define BENCH_SAMPLES   4000000
+#define BENCH_INPUT     4096
+
+static int32_t _reference_median( const int32_t *history, int count );
+
+static int32_t _reference_median( const int32_t *history, int count )
+{
+    int32_t sorted[ UNIT_ENVIII_MEDIAN_MAX_WINDOW ];
+
+    // insertion sort of the window, the filter has to agree with it on every sample
+    for ( int i = 0; i < count; i++ )
+    {
+        int j = i;
+        for ( ; j > 0 && sorted[ j - 1 ] > history[ i ]; j-- )
+            sorted[ j ] = sorted[ j - 1 ];
+        sorted[ j ] = history[ i ];
+    }
+
+    if ( count & 1 )
+        return sorted[ count / 2 ];
+    return ( int32_t )( ( ( int64_t )sorted[ count / 2 - 1 ] + sorted[ count / 2 ] ) / 2 );
+}
+
+int main( void )
+{
+    static int32_t history[ CHECK_SAMPLES ];
+    static int32_t input[ BENCH_INPUT ];
+    unit_enviii_median_t filter;
+    int32_t median;
+
+    srand( 1 );
+    for ( uint8_t window = 1; window <= UNIT_ENVIII_MEDIAN_MAX_WINDOW; window++ )
+    {
+        unit_enviii_median_init( &filter, window );
+        for ( int i = 0; i < CHECK_SAMPLES; i++ )
+        {
+            // a narrow range so that ties are common
+            history[ i ] = rand() % 50 - 25;
+            unit_enviii_median_update( &filter, history[ i ], &median );
+
+            int count = i + 1 < window ? i + 1 : window;
+            int32_t expected = _reference_median( &history[ i + 1 - count ], count );
+            if ( median != expected )
+            {
+                printf( "window %u sample %d: median %ld, expected %ld\n", window, i, ( long )median, ( long )expected );
+                return 1;
+            }
+        }
+    }
+    printf( "median matches a sorted window for windows 1 to %d\n", UNIT_ENVIII_MEDIAN_MAX_WINDOW );
+
+    // a slow temperature swing with sensor noise and an occasional spike
+    for ( int i = 0; i < BENCH_INPUT; i++ )
+        input[ i ] = 22000 + ( i / 8 ) % 200 + rand() % 30 + ( i % 97 == 0 ? 5000 : 0 );
+
+    static const uint8_t windows[] = { 3, 5, 9, 15 };
+    for ( size_t w = 0; w < sizeof( windows ); w++ )
+    {
+        if ( windows[ w ] > UNIT_ENVIII_MEDIAN_MAX_WINDOW )
+            continue;
+
+        int64_t sum = 0;
+        unit_enviii_median_init( &filter, windows[ w ] );
+        int64_t start = esp_timer_get_time();
+        for ( int i = 0; i < BENCH_SAMPLES; i++ )
+        {
+            unit_enviii_median_update( &filter, input[ i % BENCH_INPUT ], &median );
+            sum += median;
+        }
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        printf( "window %2u: %6.1f ns per update (checksum %lld)\n", windows[ w ], elapsed * 1000.0 / BENCH_SAMPLES, ( long long )sum );
+    }
+
+    return 0;
+}
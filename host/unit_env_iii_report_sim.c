@@ -0,0 +1,164 @@
+/*!
+ * @brief Host simulation of a day of reports per reporting mode
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "unit_env_iii_report.h"
+
+#define SIM_PERIOD_US       10000000LL
+#define SIM_SAMPLES         8640
+
+typedef struct
+{
+    const char *name;
+    unit_enviii_report_mode_t mode;
+    uint32_t interval_ms;
+} report_sim_case_t;
+
+static const report_sim_case_t _cases[] = {
+    { "Fixed, 10 s", UNIT_ENVIII_REPORT_FIXED, 10000 },
+    { "Fixed, 15 min", UNIT_ENVIII_REPORT_FIXED, 900000 },
+    { "Deadband", UNIT_ENVIII_REPORT_DEADBAND, 0 },
+    { "Predictive", UNIT_ENVIII_REPORT_PREDICTIVE, 0 },
+};
+
+static unit_enviii_report_update_t _receiver;
+static uint32_t _reported[ UNIT_ENVIII_CHANNEL_MAX ];
+
+static double _report_sim_gauss( void );
+static void _report_sim_sample( int index, double *pressure, unit_enviii_sample_t *sample );
+static esp_err_t _report_sim_publish( const unit_enviii_report_update_t *update, void *user );
+
+static double _report_sim_gauss( void )
+{
+    double u = ( rand() + 1.0 ) / ( RAND_MAX + 2.0 );
+    double v = ( rand() + 1.0 ) / ( RAND_MAX + 2.0 );
+
+    return sqrt( -2.0 * log( u ) ) * cos( 2.0 * M_PI * v );
+}
+
+/* One sample of the simulated day: a ±3 °C and ±8 %RH diurnal cycle with
+ * sensor noise, a 2.4 h heating burst peaking at 1.5 °C and pressure as a
+ * random walk under a small daily swing */
+static void _report_sim_sample( int index, double *pressure, unit_enviii_sample_t *sample )
+{
+    double day = index / ( double )SIM_SAMPLES;
+    double temperature = 22000.0 + 3000.0 * sin( 2.0 * M_PI * ( day - 0.375 ) ) + 15.0 * _report_sim_gauss();
+
+    if ( day > 0.3 && day < 0.35 )
+        temperature += ( day - 0.3 ) / 0.05 * 1500.0;
+    else if ( day >= 0.35 && day < 0.4 )
+        temperature += ( 0.4 - day ) / 0.05 * 1500.0;
+
+    double humidity = 45000.0 - 8000.0 * sin( 2.0 * M_PI * ( day - 0.375 ) ) + 50.0 * _report_sim_gauss();
+    *pressure += 3.0 * _report_sim_gauss();
+    double reading = *pressure - 300.0 * sin( 2.0 * M_PI * day ) + 5.0 * _report_sim_gauss();
+
+    *sample = ( unit_enviii_sample_t ){
+        .timestamp_us = index * SIM_PERIOD_US,
+        .channels = UNIT_ENVIII_CHANNEL_ALL,
+        .value = { ( int32_t )round( temperature ), ( int32_t )round( humidity ), ( int32_t )round( reading ) },
+    };
+}
+
+static esp_err_t _report_sim_publish( const unit_enviii_report_update_t *update, void *user )
+{
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        if ( update->channels & UNIT_ENVIII_CHANNEL_BIT( channel ) )
+            _reported[ channel ]++;
+    }
+
+    return unit_enviii_report_apply( &_receiver, update );
+}
+
+int main( void )
+{
+    static const int32_t tolerance[ UNIT_ENVIII_CHANNEL_MAX ] = { 100, 1000, 100 };
+    int failed = 0;
+
+    printf( "| Mode | Updates per day | Temperature, humidity, pressure updates | Largest error |\n" );
+    printf( "|---|---|---|---|\n" );
+    for ( size_t i = 0; i < sizeof( _cases ) / sizeof( _cases[ 0 ] ); i++ )
+    {
+        unit_enviii_report_t report;
+        unit_enviii_report_config_t config = {
+            .mode = _cases[ i ].mode,
+            .channels = UNIT_ENVIII_CHANNEL_ALL,
+            .tolerance = { tolerance[ 0 ], tolerance[ 1 ], tolerance[ 2 ] },
+            .interval_ms = _cases[ i ].interval_ms,
+            .heartbeat_ms = 3600000,
+            .publish = _report_sim_publish,
+        };
+        int32_t error[ UNIT_ENVIII_CHANNEL_MAX ] = { 0 };
+        double pressure = 1013250.0;
+
+        if ( unit_enviii_report_init( &report, &config ) != ESP_OK )
+            return 1;
+        _receiver = ( unit_enviii_report_update_t ){ 0 };
+        for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+            _reported[ channel ] = 0;
+
+        // every case sees the same day
+        srand( 1 );
+        for ( int index = 0; index < SIM_SAMPLES; index++ )
+        {
+            unit_enviii_sample_t sample;
+            _report_sim_sample( index, &pressure, &sample );
+            unit_enviii_report_stage_process( &sample, &report );
+
+            // what the receiver shows at this sample
+            for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+            {
+                int32_t predicted;
+                unit_enviii_report_predict( &_receiver.model[ channel ], sample.timestamp_us, &predicted );
+                if ( abs( predicted - sample.value[ channel ] ) > error[ channel ] )
+                    error[ channel ] = abs( predicted - sample.value[ channel ] );
+            }
+        }
+
+        printf( "| %s | %lu | %lu, %lu, %lu | %.3f °C, %.2f %%RH, %.0f Pa |\n", _cases[ i ].name, ( unsigned long )report.updates,
+                ( unsigned long )_reported[ 0 ], ( unsigned long )_reported[ 1 ], ( unsigned long )_reported[ 2 ],
+                error[ 0 ] / 1000.0, error[ 1 ] / 1000.0, error[ 2 ] / 10.0 );
+
+        // the tolerance modes promise the receiver stays within tolerance
+        if ( _cases[ i ].mode != UNIT_ENVIII_REPORT_FIXED )
+        {
+            for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+            {
+                if ( error[ channel ] > tolerance[ channel ] )
+                {
+                    printf( "%s: channel %u off by %ld, tolerance %ld\n", _cases[ i ].name, channel, ( long )error[ channel ], ( long )tolerance[ channel ] );
+                    failed = 1;
+                }
+            }
+        }
+        else if ( report.updates != SIM_SAMPLES * 10000ULL / _cases[ i ].interval_ms )
+        {
+            printf( "%s: %lu updates\n", _cases[ i ].name, ( unsigned long )report.updates );
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
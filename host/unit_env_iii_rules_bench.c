@@ -0,0 +1,156 @@
+/*!
+ * @brief Host benchmark of the alert rule engine at 10 and 100 rules
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <esp_timer.h>
+#include "unit_env_iii_rules.h"
+
+#define BENCH_SAMPLES       8640
+#define BENCH_PERIOD_US     10000000LL
+#define BENCH_ROUNDS        20
+
+_Static_assert( UNIT_ENVIII_RULES_MAX >= 100, "The benchmark needs UNIT_ENVIII_RULES_MAX of 100 or more" );
+
+static unit_enviii_sample_t _day[ BENCH_SAMPLES ];
+static unit_enviii_rule_t _definitions[ UNIT_ENVIII_RULES_MAX ];
+static unit_enviii_rules_t _rules;
+
+static void _rules_bench_day( void );
+static void _rules_bench_definitions( uint16_t count );
+static double _rules_bench_run( uint16_t count, uint32_t *changes );
+
+/* A day every 10 s with slow diurnal swings and a pressure front */
+static void _rules_bench_day( void )
+{
+    for ( int i = 0; i < BENCH_SAMPLES; i++ )
+    {
+        double day = i / ( double )BENCH_SAMPLES;
+
+        _day[ i ] = ( unit_enviii_sample_t ){
+            .timestamp_us = i * BENCH_PERIOD_US,
+            .channels = UNIT_ENVIII_CHANNEL_ALL,
+            .value = {
+                ( int32_t )( 22000 + 3000 * sin( 2 * M_PI * ( day - 0.375 ) ) + ( int32_t )( ( i * 7919u ) % 60 ) ),
+                ( int32_t )( 55000 - 15000 * sin( 2 * M_PI * ( day - 0.375 ) ) + ( int32_t )( ( i * 104729u ) % 200 ) ),
+                ( int32_t )( 1013000 - ( day > 0.5 ? ( day - 0.5 ) * 80000 : 0 ) + ( int32_t )( ( i * 1299709u ) % 30 ) ),
+            },
+        };
+    }
+}
+
+/* Threshold rules spread over each channel's range, with a rise or drop
+ * rule every fifth. Rules on one channel share its change tracker */
+static void _rules_bench_definitions( uint16_t count )
+{
+    static const int32_t low[ UNIT_ENVIII_CHANNEL_MAX ] = { 18000, 38000, 990000 };
+    static const int32_t span[ UNIT_ENVIII_CHANNEL_MAX ] = { 8000, 34000, 30000 };
+
+    for ( uint16_t i = 0; i < count; i++ )
+    {
+        unit_enviii_channel_t channel = ( unit_enviii_channel_t )( i % UNIT_ENVIII_CHANNEL_MAX );
+        unit_enviii_rule_t *rule = &_definitions[ i ];
+
+        rule->channel = channel;
+        rule->hysteresis = span[ channel ] / 50;
+        rule->duration_s = ( i % 4 ) * 300;
+        rule->window_s = 0;
+        if ( i % 5 == 4 )
+        {
+            rule->type = ( i / 5 ) & 1 ? UNIT_ENVIII_RULE_DROP : UNIT_ENVIII_RULE_RISE;
+            rule->threshold = span[ channel ] / 20 + ( i % 7 ) * span[ channel ] / 100;
+            rule->window_s = 3600;
+        }
+        else
+        {
+            rule->type = i & 1 ? UNIT_ENVIII_RULE_BELOW : UNIT_ENVIII_RULE_ABOVE;
+            rule->threshold = low[ channel ] + ( int32_t )( ( i * 37 ) % 100 ) * span[ channel ] / 100;
+        }
+    }
+}
+
+/* Nanoseconds per evaluated sample, and the rule changes over the day */
+static double _rules_bench_run( uint16_t count, uint32_t *changes )
+{
+    int64_t elapsed = 0;
+
+    *changes = 0;
+    for ( int round = 0; round < BENCH_ROUNDS; round++ )
+    {
+        if ( unit_enviii_rules_compile( &_rules, _definitions, count ) != ESP_OK )
+            return -1.0;
+
+        int64_t start = esp_timer_get_time();
+        for ( int i = 0; i < BENCH_SAMPLES; i++ )
+        {
+            unit_enviii_sample_t sample = _day[ i ];
+            unit_enviii_rules_evaluate( &_rules, &sample );
+            if ( round == 0 && ( sample.flags & UNIT_ENVIII_SAMPLE_FLAG_RULE_CHANGED ) )
+                ( *changes )++;
+        }
+        elapsed += esp_timer_get_time() - start;
+    }
+
+    return elapsed * 1000.0 / ( ( double )BENCH_ROUNDS * BENCH_SAMPLES );
+}
+
+int main( void )
+{
+    static const uint16_t counts[] = { 10, 32, 100 };
+    bool first[ 10 ];
+    int failed = 0;
+
+    _rules_bench_day();
+    _rules_bench_definitions( 100 );
+
+    printf( "unit_enviii_rules_t holds up to %d rules in %zu bytes\n", UNIT_ENVIII_RULES_MAX, sizeof( unit_enviii_rules_t ) );
+    for ( size_t c = 0; c < sizeof( counts ) / sizeof( counts[ 0 ] ); c++ )
+    {
+        uint32_t changes;
+        double ns = _rules_bench_run( counts[ c ], &changes );
+
+        if ( ns < 0 )
+        {
+            printf( "compiling %u rules failed\n", counts[ c ] );
+            return 1;
+        }
+        printf( "%3u rules: %6.1f ns per sample, %5.2f ns per rule, %lu changes over the day\n", counts[ c ], ns, ns / counts[ c ],
+                ( unsigned long )changes );
+
+        // rules do not interact, so the first ten end the day alike whatever follows them
+        for ( uint16_t i = 0; i < 10; i++ )
+        {
+            bool active;
+            unit_enviii_rules_active_get( &_rules, i, &active );
+            if ( c == 0 )
+                first[ i ] = active;
+            else if ( active != first[ i ] )
+            {
+                printf( "rule %u ends the day %s with %u rules\n", i, active ? "active" : "inactive", counts[ c ] );
+                failed = 1;
+            }
+        }
+    }
+
+    return failed;
+}
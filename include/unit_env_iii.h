@@ -32,7 +32,103 @@ extern "C" {
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <esp_attr.h>
+#include <esp_err.h>
 #include "core2foraws.h"
+#include "unit_env_iii_config.h"
+
+#if UNIT_ENVIII_HOT_IRAM
+#define UNIT_ENVIII_HOT_ATTR    IRAM_ATTR
+#else
+#define UNIT_ENVIII_HOT_ATTR
+#endif
+
+/* ESP-IDF defines this code from 5.0 on, with the same value */
+#ifndef ESP_ERR_NOT_FINISHED
+#define ESP_ERR_NOT_FINISHED    0x10C
+#endif
+
+/**
+ * @brief Sensor channels carried in a sample record.
+ */
+typedef enum
+{
+    UNIT_ENVIII_CHANNEL_TEMPERATURE = 0,    /*!< Temperature in 0.001 degree Celsius */
+    UNIT_ENVIII_CHANNEL_HUMIDITY,           /*!< Relative humidity in 0.001 percent */
+    UNIT_ENVIII_CHANNEL_PRESSURE,           /*!< Pressure in 0.1 Pa */
+    UNIT_ENVIII_CHANNEL_MAX
+} unit_enviii_channel_t;
+
+/**
+ * @brief Sensors of the unit, each triggered and read on its own.
+ */
+typedef enum
+{
+    UNIT_ENVIII_SENSOR_HUMIDITY = 0,    /*!< SHT30 or SHT40, temperature and humidity channels */
+    UNIT_ENVIII_SENSOR_PRESSURE,        /*!< QMP6988 or BMP280, pressure channel */
+    UNIT_ENVIII_SENSOR_MAX
+} unit_enviii_sensor_t;
+
+#define UNIT_ENVIII_CHANNEL_BIT( channel )  ( 1UL << ( channel ) )
+#define UNIT_ENVIII_CHANNEL_ALL             ( UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_MAX ) - 1 )
+
+/* Flags raised in unit_enviii_sample_t::flags by the processing stages */
+#define UNIT_ENVIII_SAMPLE_FLAG_RULE_ACTIVE     ( 1UL << 0 )    /*!< At least one alert rule is active */
+#define UNIT_ENVIII_SAMPLE_FLAG_RULE_CHANGED    ( 1UL << 1 )    /*!< An alert rule changed state on this sample */
+#define UNIT_ENVIII_SAMPLE_FLAG_ANOMALY         ( 1UL << 2 )    /*!< A channel is an outlier or changed level */
+#define UNIT_ENVIII_SAMPLE_FLAG_CONDENSATION    ( 1UL << 3 )    /*!< Surface at or below the dew point */
+#define UNIT_ENVIII_SAMPLE_FLAG_MOLD_GROWTH     ( 1UL << 4 )    /*!< Surface conditions above the mold growth isopleth */
+#define UNIT_ENVIII_SAMPLE_FLAG_OUTLIER( channel )  ( 1UL << ( 8 + ( channel ) ) )  /*!< Channel z-score above threshold */
+#define UNIT_ENVIII_SAMPLE_FLAG_CHANGE( channel )   ( 1UL << ( 12 + ( channel ) ) ) /*!< CUSUM detected a level change on channel */
+
+/**
+ * @brief Metrics derived from the channels by the processing stages, zero
+ * unless the stage computing them is registered.
+ */
+typedef struct
+{
+    int32_t dew_point;          /*!< Dew point in 0.001 degree Celsius */
+    int32_t dew_point_margin;   /*!< Surface temperature minus dew point in 0.001 degree Celsius */
+    int32_t mold_index;         /*!< Mold growth index in 0.001, 0 for none up to 6000 for heavy growth */
+    uint8_t comfort;            /*!< Thermal comfort class, see unit_env_iii_comfort.h */
+} unit_enviii_derived_t;
+
+/**
+ * @brief Fixed-point sample record shared by all processing stages.
+ * Stages read and update the record in place.
+ */
+typedef struct
+{
+    int64_t timestamp_us;                       /*!< Time the sample was fetched, from unit_enviii_pipeline_timestamp_get() */
+    int32_t value[ UNIT_ENVIII_CHANNEL_MAX ];   /*!< Channel values indexed by unit_enviii_channel_t */
+    uint32_t channels;                          /*!< Mask of channels holding a valid value */
+    uint32_t flags;                             /*!< Flags raised by the processing stages */
+    unit_enviii_derived_t derived;              /*!< Metrics derived by the processing stages */
+} unit_enviii_sample_t;
+
+/**
+ * @brief Retry policy applied when a SHT30 read fails the CRC check.
+ * In single shot mode a new conversion is triggered before every retry, in
+ * periodic mode the same conversion is fetched again. The delay before each
+ * retry starts at backoff_initial_ms and doubles up to backoff_max_ms.
+ */
+typedef struct
+{
+    uint8_t max_retries;            /*!< Retries before the sample is dropped, 0 disables retrying */
+    uint16_t backoff_initial_ms;    /*!< Delay before the first retry */
+    uint16_t backoff_max_ms;        /*!< Upper bound of the exponential backoff */
+} unit_enviii_retry_config_t;
+
+/**
+ * @brief Counters for the SHT30 CRC retry policy.
+ */
+typedef struct
+{
+    uint32_t crc_errors;    /*!< Reads that failed the CRC check, including retries */
+    uint32_t retries;       /*!< Retry attempts made */
+    uint32_t recovered;     /*!< Samples returned successfully after at least one retry */
+    uint32_t failures;      /*!< Samples dropped after all retries were exhausted */
+} unit_enviii_retry_stats_t;
 
 /** 
  * @brief Initialize the temperature/humidity and pressure sensors.
@@ -69,28 +165,122 @@ esp_err_t unit_enviii_temp_humidity_measure( void );
 
 /**
  * @brief Get the stored temp/humidity measurement from the SHT3x sensor.
+ * Reads failing the CRC check are retried according to the retry policy set
+ * with unit_enviii_retry_config_set().
  *
  * @param temperature Temperature in degree Celsius
  * @param humidity    Humidity in percent
  * @return            `ESP_OK` on success
+ *  - ESP_ERR_INVALID_STATE : Measurement not started or still running
+ *  - ESP_ERR_INVALID_CRC   : CRC check still failing after all retries
  */
 esp_err_t unit_enviii_temp_humidity_get( float *temperature, float *humidity );
 
 /**
- * @brief Get the pressure measurement from the QMP6988 sensor.
+ * @brief Get the stored temp/humidity measurement as a fixed-point sample record
+ * and run it through the processing pipeline.
+ * Must wait at least for duration ticks after unit_enviii_temp_humidity_measure().
+ * The pressure sensors convert continuously, a pressure backend that needs a
+ * trigger is started with unit_enviii_sensor_trigger().
+ *
+ * @param sample The sample record, holding the pipeline output on return.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_INVALID_STATE : Measurement not started or still running
+ *  - ESP_ERR_INVALID_CRC   : CRC check still failing after all retries
+ *  - Any error returned by a pipeline stage
+ */
+esp_err_t unit_enviii_sample_get( unit_enviii_sample_t *sample );
+
+/**
+ * @brief Set the retry policy used when a SHT30 read fails the CRC check.
+ *
+ * @param config The retry policy to apply.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Missing config or backoff_max_ms lower than backoff_initial_ms
+ */
+esp_err_t unit_enviii_retry_config_set( const unit_enviii_retry_config_t *config );
+
+/**
+ * @brief Get the retry policy currently in use.
+ *
+ * @param config Pointer filled with the active retry policy.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_retry_config_get( unit_enviii_retry_config_t *config );
+
+/**
+ * @brief Get the CRC retry counters.
+ *
+ * @param stats Pointer filled with the counters since init or the last reset.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_retry_stats_get( unit_enviii_retry_stats_t *stats );
+
+/**
+ * @brief Reset the CRC retry counters to zero.
+ *
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ */
+esp_err_t unit_enviii_retry_stats_reset( void );
+
+/** 
+ * @brief Start a conversion on one sensor only. Free running sensors ignore it.
+ * @param sensor The sensor to trigger.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_sensor_trigger( unit_enviii_sensor_t sensor );
+
+/** 
+ * @brief Conversion time of one sensor.
+ * @param sensor The sensor.
+ * @param duration The time in RTOS ticks between a trigger and the read, 0 for free running sensors.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_sensor_duration_get( unit_enviii_sensor_t sensor, uint8_t *duration );
+
+/** 
+ * @brief Read the last conversion of one sensor into its channels of a
+ * sample record. Other channels are left untouched. Humidity reads failing
+ * the CRC check are retried according to the retry policy.
+ * @param sensor The sensor to read.
+ * @param sample The sample record, its channels mask gains the channels of the sensor.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_INVALID_STATE : Measurement not started or still running
+ *  - ESP_ERR_INVALID_CRC   : CRC check still failing after all retries
+ */
+esp_err_t unit_enviii_sensor_read( unit_enviii_sensor_t sensor, unit_enviii_sample_t *sample );
+
+/**
+ * @brief Get the pressure measurement from the QMP6988 or BMP280 sensor.
  *
  * @param pressure Pressure in bar
  * @return            `ESP_OK` on success
  */
 esp_err_t unit_enviii_pressure_get( float *pressure );
 
+#if UNIT_ENVIII_ALTITUDE
 /**
- * @brief Get the calculated altitude by reading the pressure and temperature.
+ * @brief Get the altitude calculated from the pressure with the standard atmosphere.
  *
- * @param altitude The calculated altitude.
+ * @param altitude The calculated altitude in meters.
  * @return            `ESP_OK` on success
  */
 esp_err_t unit_enviii_altitude_get( float *altitude );
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,113 @@
+/*!
+ * @brief Multi-rate acquisition, each ENV III sensor sampled at its own cadence
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_ACQUIRE_H_
+#define _UNIT_ENV_III_ACQUIRE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "unit_env_iii.h"
+
+/**
+ * @brief Counters of one sensor schedule.
+ */
+typedef struct
+{
+    uint32_t samples;   /*!< Samples delivered */
+    uint32_t errors;    /*!< Triggers and reads that failed */
+    uint32_t skipped;   /*!< Cadence slots missed because the poll came late */
+} unit_enviii_acquire_stats_t;
+
+/**
+ * @brief Acquisition schedule. Each sensor is triggered and read at its
+ * own interval and delivers samples holding only its channels, so a fast
+ * pressure cadence does not drag the humidity sensor along.
+ */
+typedef struct
+{
+    int64_t interval_us[ UNIT_ENVIII_SENSOR_MAX ];                  /*!< Cadence per sensor, 0 when not sampled */
+    int64_t next_us[ UNIT_ENVIII_SENSOR_MAX ];                      /*!< Next trigger time */
+    int64_t ready_us[ UNIT_ENVIII_SENSOR_MAX ];                     /*!< Time the pending conversion completes */
+    bool pending[ UNIT_ENVIII_SENSOR_MAX ];                         /*!< A conversion was triggered and not read yet */
+    unit_enviii_acquire_stats_t stats[ UNIT_ENVIII_SENSOR_MAX ];    /*!< Counters per sensor */
+} unit_enviii_acquire_t;
+
+/** 
+ * @brief Initialize a schedule. The first conversions start at the first poll.
+ * @param acquire The schedule.
+ * @param humidity_interval_ms Temperature and humidity cadence, 0 to leave the sensor idle.
+ * @param pressure_interval_ms Pressure cadence, 0 to leave the sensor idle.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_NOT_SUPPORTED : Pressure cadence without a pressure backend compiled in
+ */
+esp_err_t unit_enviii_acquire_init( unit_enviii_acquire_t *acquire, uint32_t humidity_interval_ms, uint32_t pressure_interval_ms );
+
+/** 
+ * @brief Change the cadence of one sensor. It is next triggered one new interval from now.
+ * @param acquire The schedule.
+ * @param sensor The sensor.
+ * @param interval_ms The cadence, 0 to stop sampling the sensor.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_NOT_SUPPORTED : Pressure cadence without a pressure backend compiled in
+ */
+esp_err_t unit_enviii_acquire_interval_set( unit_enviii_acquire_t *acquire, unit_enviii_sensor_t sensor, uint32_t interval_ms );
+
+/** 
+ * @brief Trigger the sensors that are due and read at most one finished
+ * conversion. The sample holds the channels of that sensor only, flagged
+ * in its channels mask, and has been through the processing pipeline.
+ * Call it in a loop and sleep for wait in between.
+ * @param acquire The schedule.
+ * @param sample Filled with the sample read, if any.
+ * @param wait Ticks until the next trigger or read is due.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Sample delivered
+ *  - ESP_ERR_NOT_FINISHED  : Nothing to deliver yet
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - Any error of the sensor trigger or read, or of a pipeline stage
+ */
+esp_err_t unit_enviii_acquire_poll( unit_enviii_acquire_t *acquire, unit_enviii_sample_t *sample, TickType_t *wait );
+
+/** 
+ * @brief Get the counters of one sensor.
+ * @param acquire The schedule.
+ * @param sensor The sensor.
+ * @param stats Filled with the counters.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_acquire_stats_get( const unit_enviii_acquire_t *acquire, unit_enviii_sensor_t sensor, unit_enviii_acquire_stats_t *stats );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,105 @@
+/*!
+ * @brief Streaming fixed-point anomaly detection on ENV III sensor channels
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_ANOMALY_H_
+#define _UNIT_ENV_III_ANOMALY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "unit_env_iii.h"
+
+/**
+ * @brief Detector settings of one channel, in the fixed-point unit of the channel.
+ */
+typedef struct
+{
+    uint8_t shift;          /*!< EWMA weight of a new sample is 2^-shift, also the warm-up length in samples */
+    uint16_t z_x10;         /*!< Z-score above which a sample is an outlier, in tenths, at least 1 */
+    int32_t min_stddev;     /*!< Floor of the standard deviation, about the sensor noise */
+    int32_t cusum_k;        /*!< CUSUM drift allowance per sample */
+    int32_t cusum_h;        /*!< CUSUM decision threshold */
+} unit_enviii_anomaly_config_t;
+
+/**
+ * @brief Detector state of one channel.
+ */
+typedef struct
+{
+    int64_t mean;           /*!< EWMA mean, value << 8 */
+    int64_t variance;       /*!< EWMA variance, value^2 << 16 */
+    int64_t cusum_high;     /*!< Upward cumulative sum */
+    int64_t cusum_low;      /*!< Downward cumulative sum */
+    uint32_t count;         /*!< Samples seen, saturating at the warm-up length */
+} unit_enviii_anomaly_state_t;
+
+/**
+ * @brief Per-channel detector combining an EWMA z-score outlier test with a
+ * two sided CUSUM change-point test, used as the context of
+ * unit_enviii_anomaly_stage_process(). Register state as the snapshot state
+ * to skip the warm-up after a reset.
+ */
+typedef struct
+{
+    uint32_t channels;                                          /*!< Mask of monitored channels */
+    unit_enviii_anomaly_config_t config[ UNIT_ENVIII_CHANNEL_MAX ]; /*!< Per-channel settings */
+    unit_enviii_anomaly_state_t state[ UNIT_ENVIII_CHANNEL_MAX ];   /*!< Per-channel state */
+} unit_enviii_anomaly_t;
+
+/** 
+ * @brief Initialize an anomaly detector.
+ * @param detector The detector.
+ * @param channels Mask of channels to monitor, built with UNIT_ENVIII_CHANNEL_BIT().
+ * @param config Array of UNIT_ENVIII_CHANNEL_MAX settings indexed by channel, or
+ * NULL for defaults tuned to the SHT30 and QMP6988 noise levels.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_anomaly_init( unit_enviii_anomaly_t *detector, uint32_t channels, const unit_enviii_anomaly_config_t *config );
+
+/** 
+ * @brief Update the detector with a sample and raise the anomaly flags in it.
+ * @param detector The detector.
+ * @param sample The sample record.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_anomaly_update( unit_enviii_anomaly_t *detector, unit_enviii_sample_t *sample );
+
+/** 
+ * @brief Pipeline stage function running the detector on every sample.
+ * @param sample The sample record processed in place.
+ * @param context A unit_enviii_anomaly_t initialized with unit_enviii_anomaly_init().
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_anomaly_stage_process( unit_enviii_sample_t *sample, void *context );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,150 @@
+/*!
+ * @brief Sensor backend interface for the ENV II, ENV III and ENV IV units
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_BACKEND_H_
+#define _UNIT_ENV_III_BACKEND_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "unit_env_iii.h"
+
+/* The backends compiled in and the static dispatch switch are set in
+ * unit_env_iii_config.h */
+#if UNIT_ENVIII_BACKEND_SHT3X + UNIT_ENVIII_BACKEND_SHT4X < 1
+#error "At least one of UNIT_ENVIII_BACKEND_SHT3X and UNIT_ENVIII_BACKEND_SHT4X has to be enabled"
+#endif
+#if UNIT_ENVIII_BACKEND_STATIC_DISPATCH && ( UNIT_ENVIII_BACKEND_SHT3X + UNIT_ENVIII_BACKEND_SHT4X != 1 || \
+                                             UNIT_ENVIII_BACKEND_QMP6988 + UNIT_ENVIII_BACKEND_BMP280 > 1 )
+#error "UNIT_ENVIII_BACKEND_STATIC_DISPATCH needs one humidity backend and at most one pressure backend"
+#endif
+
+#define UNIT_ENVIII_SHT3X_I2C_ADDR      0x44
+#define UNIT_ENVIII_SHT4X_I2C_ADDR      0x44
+#define UNIT_ENVIII_QMP6988_I2C_ADDR    0x70
+#define UNIT_ENVIII_BMP280_I2C_ADDR     0x76
+
+/* Port A clock of the QMP6988, BMP280 and SHT4x descriptors, the SHT3x
+ * descriptor is set up by the esp-idf-lib driver */
+#ifndef UNIT_ENVIII_I2C_FREQ_HZ
+#define UNIT_ENVIII_I2C_FREQ_HZ         400000
+#endif
+
+/**
+ * @brief Unit variants and the sensors fitted to them.
+ */
+typedef enum
+{
+    UNIT_ENVIII_VARIANT_ENV_II = 0, /*!< SHT30 and BMP280 */
+    UNIT_ENVIII_VARIANT_ENV_III,    /*!< SHT30 and QMP6988 */
+    UNIT_ENVIII_VARIANT_ENV_IV      /*!< SHT40 and BMP280 */
+} unit_enviii_variant_t;
+
+/**
+ * @brief Operations of a sensor backend. A conversion is started with
+ * trigger, read with fetch once duration has passed and turned into
+ * fixed point sample values with compensate.
+ */
+typedef struct
+{
+    const char *name;                                           /*!< Sensor name used in logs */
+    uint32_t channels;                                          /*!< Channels filled by compensate, UNIT_ENVIII_CHANNEL_BIT() mask */
+    esp_err_t ( *init )( void );                                /*!< Probe and configure the sensor on Port A */
+    esp_err_t ( *trigger )( void );                             /*!< Start a conversion, nothing to do for free running sensors */
+    uint8_t ( *duration_get )( void );                          /*!< Conversion time in RTOS ticks */
+    esp_err_t ( *fetch )( void );                               /*!< Read the raw conversion, ESP_ERR_INVALID_CRC on a corrupted read */
+    esp_err_t ( *compensate )( unit_enviii_sample_t *sample );  /*!< Convert the last raw conversion into the sample */
+} unit_enviii_backend_t;
+
+#if UNIT_ENVIII_BACKEND_SHT3X
+extern const unit_enviii_backend_t unit_enviii_backend_sht3x;
+esp_err_t unit_enviii_sht3x_init( void );
+esp_err_t unit_enviii_sht3x_trigger( void );
+uint8_t unit_enviii_sht3x_duration_get( void );
+esp_err_t unit_enviii_sht3x_fetch( void );
+esp_err_t unit_enviii_sht3x_compensate( unit_enviii_sample_t *sample );
+esp_err_t unit_enviii_sht3x_decode( const uint8_t *raw, unit_enviii_sample_t *sample );
+#endif
+
+#if UNIT_ENVIII_BACKEND_SHT4X
+extern const unit_enviii_backend_t unit_enviii_backend_sht4x;
+esp_err_t unit_enviii_sht4x_init( void );
+esp_err_t unit_enviii_sht4x_trigger( void );
+uint8_t unit_enviii_sht4x_duration_get( void );
+esp_err_t unit_enviii_sht4x_fetch( void );
+esp_err_t unit_enviii_sht4x_compensate( unit_enviii_sample_t *sample );
+esp_err_t unit_enviii_sht4x_decode( const uint8_t *raw, unit_enviii_sample_t *sample );
+#endif
+
+#if UNIT_ENVIII_BACKEND_QMP6988
+extern const unit_enviii_backend_t unit_enviii_backend_qmp6988;
+esp_err_t unit_enviii_qmp6988_init( void );
+esp_err_t unit_enviii_qmp6988_trigger( void );
+uint8_t unit_enviii_qmp6988_duration_get( void );
+esp_err_t unit_enviii_qmp6988_fetch( void );
+esp_err_t unit_enviii_qmp6988_compensate( unit_enviii_sample_t *sample );
+esp_err_t unit_enviii_qmp6988_decode( const uint8_t *raw, unit_enviii_sample_t *sample );
+#endif
+
+#if UNIT_ENVIII_BACKEND_BMP280
+extern const unit_enviii_backend_t unit_enviii_backend_bmp280;
+esp_err_t unit_enviii_bmp280_init( void );
+esp_err_t unit_enviii_bmp280_trigger( void );
+uint8_t unit_enviii_bmp280_duration_get( void );
+esp_err_t unit_enviii_bmp280_fetch( void );
+esp_err_t unit_enviii_bmp280_compensate( unit_enviii_sample_t *sample );
+esp_err_t unit_enviii_bmp280_decode( const uint8_t *raw, unit_enviii_sample_t *sample );
+#endif
+
+/* The unit_enviii_<sensor>_decode() functions turn the 6 raw bytes of a
+ * conversion, as read from the data registers, into sample values. They
+ * neither log, lock nor touch the bus, so a bus callback or an ISR can use
+ * them. With UNIT_ENVIII_HOT_IRAM they run from IRAM and read only
+ * calibration and raw data held in DRAM, so they stay usable while the
+ * flash cache is disabled. The SHT decoders return ESP_ERR_INVALID_CRC on a
+ * corrupted conversion. */
+
+/** 
+ * @brief Select the sensors of the unit variant. Call before unit_enviii_init().
+ * @param variant The unit variant plugged into Port A.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_NOT_SUPPORTED : A sensor of the variant is not compiled in
+ */
+esp_err_t unit_enviii_variant_set( unit_enviii_variant_t variant );
+
+/** 
+ * @brief Sensirion CRC-8 of a data word, shared by the SHT3x and SHT4x backends.
+ * @param data The bytes to check.
+ * @param len Number of bytes.
+ * @return The CRC.
+ */
+uint8_t unit_enviii_backend_crc8( const uint8_t *data, size_t len );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,221 @@
+/*!
+ * @brief Batching of ENV III samples for upload with backpressure
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_BATCH_H_
+#define _UNIT_ENV_III_BATCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "unit_env_iii.h"
+#include "unit_env_iii_lzss.h"
+
+/* Samples queued while the link is slow or down */
+#ifndef UNIT_ENVIII_BATCH_CAPACITY
+#define UNIT_ENVIII_BATCH_CAPACITY      64
+#endif
+
+/* Largest encoded batch handed to the publish callback, samples that do
+ * not fit go out with the next batch */
+#ifndef UNIT_ENVIII_BATCH_PAYLOAD_SIZE
+#define UNIT_ENVIII_BATCH_PAYLOAD_SIZE  512
+#endif
+
+#define UNIT_ENVIII_BATCH_VERSION       1
+/* Set in the version byte of payloads compressed with LZSS */
+#define UNIT_ENVIII_BATCH_COMPRESSED    0x80
+
+/**
+ * @brief What happens to a new sample when the queue is full.
+ */
+typedef enum
+{
+    UNIT_ENVIII_BATCH_BLOCK = 0,    /*!< Wait up to block_ticks for room, then drop the new sample */
+    UNIT_ENVIII_BATCH_DROP_OLDEST,  /*!< Drop the oldest sample not being published */
+    UNIT_ENVIII_BATCH_DROP_NEWEST,  /*!< Drop the new sample */
+    UNIT_ENVIII_BATCH_DECIMATE      /*!< Drop every other queued sample, halving the rate of the backlog */
+} unit_enviii_batch_policy_t;
+
+/**
+ * @brief Called with each encoded batch, e.g. to publish it over MQTT.
+ * On an error the samples stay queued and go out with the next attempt.
+ */
+typedef esp_err_t ( *unit_enviii_batch_publish_t )( const uint8_t *payload, size_t length, uint16_t samples, void *user );
+
+/**
+ * @brief Batching options.
+ */
+typedef struct
+{
+    uint16_t max_samples;                   /*!< Publish once this many samples are queued, up to UNIT_ENVIII_BATCH_CAPACITY */
+    uint32_t max_age_ms;                    /*!< Publish once the oldest queued sample is this old, 0 for size bound batches only */
+    unit_enviii_batch_policy_t policy;      /*!< Handling of new samples when the queue is full */
+    TickType_t block_ticks;                 /*!< Longest wait for room with UNIT_ENVIII_BATCH_BLOCK */
+    bool compress;                          /*!< LZSS compress the payloads, see unit_enviii_batch_inflate() */
+    unit_enviii_batch_publish_t publish;    /*!< Publish callback */
+    void *user;                             /*!< Passed to the publish callback */
+} unit_enviii_batch_config_t;
+
+/**
+ * @brief Batching counters.
+ */
+typedef struct
+{
+    uint32_t batches;       /*!< Batches published */
+    uint32_t samples;       /*!< Samples published */
+    uint32_t bytes;         /*!< Payload bytes published */
+    uint32_t failures;      /*!< Publish attempts that failed */
+    uint32_t dropped;       /*!< Samples dropped by the block, drop oldest and drop newest policies */
+    uint32_t decimated;     /*!< Samples dropped by decimation */
+} unit_enviii_batch_stats_t;
+
+/**
+ * @brief Queued sample, the channel values with their timestamp and the low 16 flag bits.
+ */
+typedef struct
+{
+    int64_t timestamp_us;                       /*!< Sample time */
+    int32_t value[ UNIT_ENVIII_CHANNEL_MAX ];   /*!< Channel values */
+    uint16_t flags;                             /*!< Flags raised by the processing stages */
+    uint8_t channels;                           /*!< Mask of valid channels */
+} unit_enviii_batch_entry_t;
+
+/**
+ * @brief Batcher, used as the context of unit_enviii_batch_stage_process().
+ * The pipeline task queues samples and an uploader task publishes them with
+ * unit_enviii_batch_publish(). Samples being published stay queued until
+ * the callback succeeds, so nothing is lost while the link is down unless
+ * the policy drops it.
+ */
+typedef struct
+{
+    unit_enviii_batch_config_t config;                          /*!< Options */
+    SemaphoreHandle_t lock;                                     /*!< Guards the queue */
+    SemaphoreHandle_t ready;                                    /*!< Given when a batch fills up */
+    SemaphoreHandle_t space;                                    /*!< Given when published samples leave the queue */
+    StaticSemaphore_t lock_buffer;                              /*!< Storage of lock */
+    StaticSemaphore_t ready_buffer;                             /*!< Storage of ready */
+    StaticSemaphore_t space_buffer;                             /*!< Storage of space */
+    uint16_t head;                                              /*!< Index of the oldest queued sample */
+    uint16_t count;                                             /*!< Queued samples */
+    uint16_t inflight;                                          /*!< Oldest samples being published */
+    unit_enviii_batch_stats_t stats;                            /*!< Counters */
+    unit_enviii_batch_entry_t queue[ UNIT_ENVIII_BATCH_CAPACITY ]; /*!< Ring of queued samples */
+    unit_enviii_lzss_t lzss;                                    /*!< Compressor of the payload */
+    uint8_t payload[ UNIT_ENVIII_BATCH_PAYLOAD_SIZE ];          /*!< Encoded batch being published */
+} unit_enviii_batch_t;
+
+/** 
+ * @brief Initialize a batcher.
+ * @param batch The batcher.
+ * @param config The options.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_batch_init( unit_enviii_batch_t *batch, const unit_enviii_batch_config_t *config );
+
+/** 
+ * @brief Pipeline stage function queuing every sample. The sample is passed on unchanged.
+ * @param sample The sample record.
+ * @param context A unit_enviii_batch_t initialized with unit_enviii_batch_init().
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success, also when the policy dropped a sample
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_batch_stage_process( unit_enviii_sample_t *sample, void *context );
+
+/** 
+ * @brief Wait for a batch to fill up or age out, encode it and hand it to the
+ * publish callback. Call it in a loop from the uploader task.
+ * @param batch The batcher.
+ * @param wait Longest time to wait for a batch.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Batch published
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_TIMEOUT       : No batch ready within wait
+ *  - Any error returned by the publish callback
+ */
+esp_err_t unit_enviii_batch_publish( unit_enviii_batch_t *batch, TickType_t wait );
+
+/** 
+ * @brief Publish the queued samples now, e.g. before deep sleep, whether or
+ * not a batch is full. Does nothing when the queue is empty.
+ * @param batch The batcher.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - Any error returned by the publish callback
+ */
+esp_err_t unit_enviii_batch_flush( unit_enviii_batch_t *batch );
+
+/** 
+ * @brief Get the batching counters.
+ * @param batch The batcher.
+ * @param stats Filled with the counters.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_batch_stats_get( unit_enviii_batch_t *batch, unit_enviii_batch_stats_t *stats );
+
+/** 
+ * @brief Decode a batch payload, e.g. on the receiving side or in a loopback test.
+ * Plain C without driver state, so it also builds on a host.
+ * @param payload The payload handed to the publish callback.
+ * @param length Payload length.
+ * @param samples Filled with the decoded samples, timestamps in whole milliseconds.
+ * @param max Room in samples.
+ * @param count Number of samples decoded.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_INVALID_VERSION : Payload of another format version, or compressed
+ *  - ESP_ERR_INVALID_SIZE  : Payload truncated or more samples than max
+ */
+esp_err_t unit_enviii_batch_decode( const uint8_t *payload, size_t length, unit_enviii_sample_t *samples, size_t max, size_t *count );
+
+/** 
+ * @brief Restore a compressed payload for unit_enviii_batch_decode(). Plain
+ * payloads are copied unchanged, so receivers can pass every payload through.
+ * @param payload The payload handed to the publish callback.
+ * @param length Payload length.
+ * @param out Filled with the plain payload.
+ * @param size Room in out, UNIT_ENVIII_BATCH_PAYLOAD_SIZE of the sender is always enough.
+ * @param out_length Length of the plain payload.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_INVALID_SIZE  : Payload truncated or larger than size
+ *  - ESP_FAIL              : Corrupt compressed payload
+ */
+esp_err_t unit_enviii_batch_inflate( const uint8_t *payload, size_t length, uint8_t *out, size_t size, size_t *out_length );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
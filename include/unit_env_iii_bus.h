@@ -0,0 +1,151 @@
+/*!
+ * @brief Port A bus scheduler shared by the ENV unit and co-resident I2C drivers
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_BUS_H_
+#define _UNIT_ENV_III_BUS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "unit_env_iii.h"
+
+/* Transactions expected to take at most this long are run back to back by
+ * whichever task holds the bus instead of waking their own task */
+#ifndef UNIT_ENVIII_BUS_SHORT_US
+#define UNIT_ENVIII_BUS_SHORT_US        500
+#endif
+
+/* Bus time a task spends on other tasks' transactions before handing over */
+#ifndef UNIT_ENVIII_BUS_BATCH_US
+#define UNIT_ENVIII_BUS_BATCH_US        2000
+#endif
+
+/* Time after a reservation during which background transactions stay held */
+#ifndef UNIT_ENVIII_BUS_RESERVE_HOLD_US
+#define UNIT_ENVIII_BUS_RESERVE_HOLD_US 2000
+#endif
+
+/* Waiting transactions rise one priority level per period so a busy bus
+ * cannot starve background transactions */
+#ifndef UNIT_ENVIII_BUS_AGING_US
+#define UNIT_ENVIII_BUS_AGING_US        50000
+#endif
+
+/**
+ * @brief Transaction priorities, highest last.
+ */
+typedef enum
+{
+    UNIT_ENVIII_BUS_PRIORITY_BACKGROUND = 0,    /*!< Deferrable, only run in bus windows that fit before a reservation */
+    UNIT_ENVIII_BUS_PRIORITY_NORMAL,            /*!< Run in submission order */
+    UNIT_ENVIII_BUS_PRIORITY_LATENCY,           /*!< Run ahead of everything else */
+    UNIT_ENVIII_BUS_PRIORITY_MAX
+} unit_enviii_bus_priority_t;
+
+/**
+ * @brief A bus transaction, owned by the submitting task for the duration of
+ * unit_enviii_bus_submit(). Only the fields before the scheduler owned ones
+ * are set by the caller.
+ */
+typedef struct unit_enviii_bus_transaction
+{
+    const char *name;                               /*!< Name used in logs */
+    unit_enviii_bus_priority_t priority;            /*!< Scheduling priority */
+    uint32_t duration_us;                           /*!< Expected bus time, used for batching and fitting windows */
+    esp_err_t ( *run )( void *context );            /*!< Performs the I2C transfers, may run in another task */
+    void *context;                                  /*!< Passed to run */
+
+    /* owned by the scheduler */
+    struct unit_enviii_bus_transaction *next;       /*!< Next pending transaction */
+    SemaphoreHandle_t wake;                         /*!< Given to the submitting task on a handoff and when another task ran it */
+    StaticSemaphore_t wake_buffer;                  /*!< Storage of wake */
+    uint8_t signals;                                /*!< Gives of wake announced, all taken before submit returns */
+    int64_t queued_us;                              /*!< Submission time */
+    volatile uint8_t state;                         /*!< Pending, leading, running or done */
+    bool deferred;                                  /*!< Held for a reservation at least once */
+    esp_err_t result;                               /*!< Result of run */
+} unit_enviii_bus_transaction_t;
+
+/**
+ * @brief Bus statistics since the last reset.
+ */
+typedef struct
+{
+    uint32_t transactions[ UNIT_ENVIII_BUS_PRIORITY_MAX ];   /*!< Completed transactions per priority */
+    uint64_t wait_total_us[ UNIT_ENVIII_BUS_PRIORITY_MAX ];  /*!< Queueing time per priority */
+    uint32_t wait_max_us[ UNIT_ENVIII_BUS_PRIORITY_MAX ];    /*!< Longest queueing time per priority */
+    uint32_t batched;                                       /*!< Transactions run by another task's batch */
+    uint32_t handoffs;                                      /*!< Bus handed to another task */
+    uint32_t deferred;                                      /*!< Background transactions held for a reservation */
+    uint32_t timeouts;                                      /*!< Submissions withdrawn after their timeout */
+    uint64_t busy_us;                                       /*!< Time spent in transactions */
+    int64_t elapsed_us;                                     /*!< Time since the last reset */
+    uint16_t utilization;                                   /*!< busy_us over elapsed_us in 0.1 percent */
+} unit_enviii_bus_stats_t;
+
+/** 
+ * @brief Run a transaction on Port A. Blocks until the transaction has run,
+ * possibly in the task that currently holds the bus.
+ * @param transaction The transaction, name, priority, duration_us, run and context set.
+ * @param timeout Ticks to wait for the bus, portMAX_DELAY to wait forever.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - The result of run
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_TIMEOUT       : The transaction did not start within timeout
+ */
+esp_err_t unit_enviii_bus_submit( unit_enviii_bus_transaction_t *transaction, TickType_t timeout );
+
+/** 
+ * @brief Announce that the calling driver needs the bus again in a while,
+ * typically right after starting a conversion. Background transactions run
+ * meanwhile only when they fit before then.
+ * @param in_us Time until the bus is needed.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ */
+esp_err_t unit_enviii_bus_reserve( uint32_t in_us );
+
+/** 
+ * @brief Get the bus statistics.
+ * @param stats Filled with the statistics.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_bus_stats_get( unit_enviii_bus_stats_t *stats );
+
+/** 
+ * @brief Reset the bus statistics.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ */
+esp_err_t unit_enviii_bus_stats_reset( void );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
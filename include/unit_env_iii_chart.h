@@ -0,0 +1,130 @@
+/*!
+ * @brief Incremental per-pixel-column chart feed for ENV III history on the Core2 display
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_CHART_H_
+#define _UNIT_ENV_III_CHART_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "unit_env_iii.h"
+#include "unit_env_iii_history.h"
+
+#ifndef UNIT_ENVIII_CHART_MAX_WIDTH
+#define UNIT_ENVIII_CHART_MAX_WIDTH 320
+#endif
+
+/* Value of unit_enviii_chart_column_t::last when the column was filled from
+ * downsampled history, whose buckets keep no last value */
+#define UNIT_ENVIII_CHART_NO_LAST   INT32_MIN
+
+/**
+ * @brief Aggregate of the samples falling into one pixel column.
+ */
+typedef struct
+{
+    int32_t min;    /*!< Lowest value in the column */
+    int32_t max;    /*!< Highest value in the column */
+    int32_t last;   /*!< Most recent value in the column, or UNIT_ENVIII_CHART_NO_LAST */
+} unit_enviii_chart_column_t;
+
+/**
+ * @brief Chart feed keeping one aggregate per pixel column for a time window
+ * ending at the newest sample. Columns are a ring, so scrolling clears only
+ * the columns entering on the right and a redraw reads width columns however
+ * long the history is.
+ */
+typedef struct
+{
+    unit_enviii_channel_t channel;                              /*!< Channel plotted */
+    uint16_t width;                                             /*!< Columns in the chart */
+    uint16_t head;                                              /*!< Ring position of the leftmost column */
+    int64_t column_us;                                          /*!< Time covered by one column */
+    int64_t origin_us;                                          /*!< Start time of the leftmost column */
+    unit_enviii_chart_column_t column[ UNIT_ENVIII_CHART_MAX_WIDTH ]; /*!< Column aggregates */
+} unit_enviii_chart_t;
+
+/** 
+ * @brief Initialize a chart feed.
+ * @param chart The chart feed.
+ * @param channel Channel to plot.
+ * @param width Chart width in pixels, up to UNIT_ENVIII_CHART_MAX_WIDTH.
+ * @param window_ms Time span shown across the chart, at least one millisecond per column.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_chart_init( unit_enviii_chart_t *chart, unit_enviii_channel_t channel, uint16_t width, uint32_t window_ms );
+
+/** 
+ * @brief Add a sample to the chart, scrolling it when the sample is past the right edge.
+ * Samples without the chart channel or older than the left edge are ignored.
+ * @param chart The chart feed.
+ * @param sample The sample to add.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_chart_update( unit_enviii_chart_t *chart, const unit_enviii_sample_t *sample );
+
+/** 
+ * @brief Fill the chart from a history store, e.g. after boot before live samples arrive.
+ * Min and max come from the buckets. A bucket holding a single sample, or
+ * only equal values, also gives the column its last value. Columns ending
+ * with a merged bucket have last set to UNIT_ENVIII_CHART_NO_LAST until a
+ * live sample lands in them.
+ * @param chart The chart feed.
+ * @param history The history store to read.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_chart_history_load( unit_enviii_chart_t *chart, const unit_enviii_history_t *history );
+
+/** 
+ * @brief Get the aggregate of a pixel column.
+ * @param chart The chart feed.
+ * @param x Column from the left edge, width - 1 holds the newest sample.
+ * @param column Pointer filled with the column aggregate.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or x outside the chart
+ *  - ESP_ERR_NOT_FOUND     : No sample in the column
+ */
+esp_err_t unit_enviii_chart_column_get( const unit_enviii_chart_t *chart, uint16_t x, unit_enviii_chart_column_t *column );
+
+/** 
+ * @brief Pipeline stage function feeding every sample to a chart.
+ * @param sample The sample record.
+ * @param context A unit_enviii_chart_t initialized with unit_enviii_chart_init().
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_chart_stage_process( unit_enviii_sample_t *sample, void *context );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,105 @@
+/*!
+ * @brief Thermal comfort classification of ENV III samples from a precomputed lookup grid
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_COMFORT_H_
+#define _UNIT_ENV_III_COMFORT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "unit_env_iii.h"
+
+#define UNIT_ENVIII_COMFORT_TEMPERATURE_MIN     10000   /* grid start, 0.001 degree Celsius */
+#define UNIT_ENVIII_COMFORT_TEMPERATURE_STEP    500
+#define UNIT_ENVIII_COMFORT_TEMPERATURE_POINTS  51      /* 10 to 35 degree Celsius */
+#define UNIT_ENVIII_COMFORT_HUMIDITY_STEP       5000    /* 0.001 percent */
+#define UNIT_ENVIII_COMFORT_HUMIDITY_POINTS     21      /* 0 to 100 percent */
+
+/* Thermal sensation in the low nibble of a comfort class, 0 when not classified */
+#define UNIT_ENVIII_COMFORT_SENSATION_MASK      0x0F
+#define UNIT_ENVIII_COMFORT_COLD                1
+#define UNIT_ENVIII_COMFORT_COOL                2
+#define UNIT_ENVIII_COMFORT_SLIGHTLY_COOL       3
+#define UNIT_ENVIII_COMFORT_NEUTRAL             4
+#define UNIT_ENVIII_COMFORT_SLIGHTLY_WARM       5
+#define UNIT_ENVIII_COMFORT_WARM                6
+#define UNIT_ENVIII_COMFORT_HOT                 7
+/* Humidity bits of a comfort class */
+#define UNIT_ENVIII_COMFORT_DRY                 0x10    /* Below 30 percent RH */
+#define UNIT_ENVIII_COMFORT_HUMID               0x20    /* Humidity ratio above 0.012 kg/kg */
+
+/**
+ * @brief Model used to fill the lookup grid.
+ */
+typedef enum
+{
+    UNIT_ENVIII_COMFORT_MODEL_ZONE = 0, /*!< ASHRAE 55 style comfort zone, bounds shifted by clothing */
+    UNIT_ENVIII_COMFORT_MODEL_PMV       /*!< ISO 7730 PMV with still air and radiant temperature equal to air temperature */
+} unit_enviii_comfort_model_t;
+
+/**
+ * @brief Comfort classifier, used as the context of unit_enviii_comfort_stage_process().
+ * The model is evaluated once per grid point at init, so classifying a
+ * sample is a single table lookup at the nearest grid point.
+ */
+typedef struct
+{
+    uint8_t grid[ UNIT_ENVIII_COMFORT_HUMIDITY_POINTS ][ UNIT_ENVIII_COMFORT_TEMPERATURE_POINTS ]; /*!< Classes by humidity then temperature */
+} unit_enviii_comfort_t;
+
+/** 
+ * @brief Fill the lookup grid of a comfort classifier.
+ * @param comfort The classifier.
+ * @param model The model evaluated on the grid.
+ * @param clo Clothing insulation, 0.5 for summer and 1.0 for winter clothing.
+ * @param met Metabolic rate used by the PMV model, 1.1 for office work.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_comfort_init( unit_enviii_comfort_t *comfort, unit_enviii_comfort_model_t model, float clo, float met );
+
+/** 
+ * @brief Classify a temperature and humidity pair.
+ * @param comfort The classifier.
+ * @param temperature Temperature in 0.001 degree Celsius, clamped to the grid.
+ * @param humidity Relative humidity in 0.001 percent, clamped to the grid.
+ * @return The comfort class.
+ */
+uint8_t unit_enviii_comfort_classify( const unit_enviii_comfort_t *comfort, int32_t temperature, int32_t humidity );
+
+/** 
+ * @brief Pipeline stage function classifying every sample with temperature and humidity.
+ * @param sample The sample record processed in place.
+ * @param context A unit_enviii_comfort_t initialized with unit_enviii_comfort_init().
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_comfort_stage_process( unit_enviii_sample_t *sample, void *context );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
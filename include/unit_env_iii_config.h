@@ -0,0 +1,193 @@
+/*!
+ * @brief Build options of the ENV III driver, from menuconfig or compiler definitions
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_CONFIG_H_
+#define _UNIT_ENV_III_CONFIG_H_
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+/* Options from the component menu. Unset Kconfig booleans are not defined,
+ * so each one is spelled out as 0 or 1 */
+#ifdef CONFIG_UNIT_ENVIII_KCONFIG
+
+#ifdef CONFIG_UNIT_ENVIII_BACKEND_SHT3X
+#define UNIT_ENVIII_BACKEND_SHT3X           1
+#else
+#define UNIT_ENVIII_BACKEND_SHT3X           0
+#endif
+#ifdef CONFIG_UNIT_ENVIII_BACKEND_SHT4X
+#define UNIT_ENVIII_BACKEND_SHT4X           1
+#else
+#define UNIT_ENVIII_BACKEND_SHT4X           0
+#endif
+#ifdef CONFIG_UNIT_ENVIII_BACKEND_QMP6988
+#define UNIT_ENVIII_BACKEND_QMP6988         1
+#else
+#define UNIT_ENVIII_BACKEND_QMP6988         0
+#endif
+#ifdef CONFIG_UNIT_ENVIII_BACKEND_BMP280
+#define UNIT_ENVIII_BACKEND_BMP280          1
+#else
+#define UNIT_ENVIII_BACKEND_BMP280          0
+#endif
+#ifdef CONFIG_UNIT_ENVIII_BACKEND_STATIC_DISPATCH
+#define UNIT_ENVIII_BACKEND_STATIC_DISPATCH 1
+#else
+#define UNIT_ENVIII_BACKEND_STATIC_DISPATCH 0
+#endif
+#ifdef CONFIG_UNIT_ENVIII_ALTITUDE
+#define UNIT_ENVIII_ALTITUDE                1
+#else
+#define UNIT_ENVIII_ALTITUDE                0
+#endif
+#ifdef CONFIG_UNIT_ENVIII_HISTORY
+#define UNIT_ENVIII_HISTORY                 1
+#else
+#define UNIT_ENVIII_HISTORY                 0
+#endif
+#ifdef CONFIG_UNIT_ENVIII_ENCODERS
+#define UNIT_ENVIII_ENCODERS                1
+#else
+#define UNIT_ENVIII_ENCODERS                0
+#endif
+#ifdef CONFIG_UNIT_ENVIII_INSTRUMENTATION
+#define UNIT_ENVIII_INSTRUMENTATION         1
+#else
+#define UNIT_ENVIII_INSTRUMENTATION         0
+#endif
+#ifdef CONFIG_UNIT_ENVIII_BUS_SCHEDULER
+#define UNIT_ENVIII_BUS_SCHEDULER           1
+#else
+#define UNIT_ENVIII_BUS_SCHEDULER           0
+#endif
+#ifdef CONFIG_UNIT_ENVIII_HOT_IRAM
+#define UNIT_ENVIII_HOT_IRAM                1
+#else
+#define UNIT_ENVIII_HOT_IRAM                0
+#endif
+#ifdef CONFIG_UNIT_ENVIII_NO_HEAP
+#define UNIT_ENVIII_NO_HEAP                 1
+#else
+#define UNIT_ENVIII_NO_HEAP                 0
+#endif
+#define UNIT_ENVIII_SHT_REPEATABILITY       CONFIG_UNIT_ENVIII_SHT_REPEATABILITY
+#ifdef CONFIG_UNIT_ENVIII_PRESSURE_OVERSAMPLING
+#define UNIT_ENVIII_PRESSURE_OVERSAMPLING   CONFIG_UNIT_ENVIII_PRESSURE_OVERSAMPLING
+#define UNIT_ENVIII_PRESSURE_FILTER         CONFIG_UNIT_ENVIII_PRESSURE_FILTER
+#endif
+#ifdef CONFIG_UNIT_ENVIII_PRESSURE_STANDBY
+#define UNIT_ENVIII_PRESSURE_STANDBY        CONFIG_UNIT_ENVIII_PRESSURE_STANDBY
+#endif
+
+#endif
+
+/* Defaults for builds without Kconfig, set with -D or the CMake cache
+ * options of the host build. They match the full ENV III driver with
+ * history and encoders */
+
+/* Sensor backends, see unit_env_iii_backend.h */
+#ifndef UNIT_ENVIII_BACKEND_SHT3X
+#define UNIT_ENVIII_BACKEND_SHT3X           1
+#endif
+#ifndef UNIT_ENVIII_BACKEND_SHT4X
+#define UNIT_ENVIII_BACKEND_SHT4X           0
+#endif
+#ifndef UNIT_ENVIII_BACKEND_QMP6988
+#define UNIT_ENVIII_BACKEND_QMP6988         1
+#endif
+#ifndef UNIT_ENVIII_BACKEND_BMP280
+#define UNIT_ENVIII_BACKEND_BMP280          0
+#endif
+
+/* Bind the backends at compile time and call them directly instead of
+ * through the backend table. Needs exactly one humidity backend and at
+ * most one pressure backend */
+#ifndef UNIT_ENVIII_BACKEND_STATIC_DISPATCH
+#define UNIT_ENVIII_BACKEND_STATIC_DISPATCH 0
+#endif
+
+/* SHT30 and SHT40 repeatability, 0 high, 1 medium, 2 low */
+#ifndef UNIT_ENVIII_SHT_REPEATABILITY
+#define UNIT_ENVIII_SHT_REPEATABILITY       0
+#endif
+
+/* QMP6988 and BMP280 pressure oversampling, 1 to 5 for 1x to 16x, and IIR
+ * filter, 0 off and 1 to 4 for coefficients 2 to 16. Both sensors share
+ * the register encoding */
+#ifndef UNIT_ENVIII_PRESSURE_OVERSAMPLING
+#define UNIT_ENVIII_PRESSURE_OVERSAMPLING   4
+#endif
+#ifndef UNIT_ENVIII_PRESSURE_FILTER
+#define UNIT_ENVIII_PRESSURE_FILTER         2
+#endif
+
+/* Standby between free running pressure conversions, register code 0 to 7.
+ * QMP6988 1, 5, 50, 250, 500, 1000, 2000, 4000 ms, BMP280 0.5, 62.5, 125,
+ * 250, 500, 1000, 2000, 4000 ms */
+#ifndef UNIT_ENVIII_PRESSURE_STANDBY
+#define UNIT_ENVIII_PRESSURE_STANDBY        0
+#endif
+
+/* unit_enviii_altitude_get(), needs a pressure backend */
+#ifndef UNIT_ENVIII_ALTITUDE
+#define UNIT_ENVIII_ALTITUDE                1
+#endif
+
+/* History store and chart feed */
+#ifndef UNIT_ENVIII_HISTORY
+#define UNIT_ENVIII_HISTORY                 1
+#endif
+
+/* Columnar pack blocks, and with the history the CSV/NDJSON exporter */
+#ifndef UNIT_ENVIII_ENCODERS
+#define UNIT_ENVIII_ENCODERS                1
+#endif
+
+/* Stage timing, bus statistics and the footprint report */
+#ifndef UNIT_ENVIII_INSTRUMENTATION
+#define UNIT_ENVIII_INSTRUMENTATION         1
+#endif
+
+/* Route the ENV bus transactions through the scheduler, 0 to call the sensors directly */
+#ifndef UNIT_ENVIII_BUS_SCHEDULER
+#define UNIT_ENVIII_BUS_SCHEDULER           1
+#endif
+
+/* Place the decode, compensation and CRC functions in IRAM. The bus access,
+ * locking and logging around them stay in flash */
+#ifndef UNIT_ENVIII_HOT_IRAM
+#define UNIT_ENVIII_HOT_IRAM                0
+#endif
+
+/* Poison the heap functions in every driver source, see unit_env_iii_noheap.h */
+#ifndef UNIT_ENVIII_NO_HEAP
+#define UNIT_ENVIII_NO_HEAP                 1
+#endif
+
+#if !UNIT_ENVIII_BACKEND_QMP6988 && !UNIT_ENVIII_BACKEND_BMP280
+#undef UNIT_ENVIII_ALTITUDE
+#define UNIT_ENVIII_ALTITUDE                0
+#endif
+
+#endif
@@ -0,0 +1,114 @@
+/*!
+ * @brief Streaming CSV and NDJSON export of the ENV III history
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_EXPORT_H_
+#define _UNIT_ENV_III_EXPORT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "unit_env_iii_history.h"
+
+#ifndef UNIT_ENVIII_EXPORT_CHUNK_SIZE
+#define UNIT_ENVIII_EXPORT_CHUNK_SIZE   512
+#endif
+
+/**
+ * @brief Output format of the exporter.
+ */
+typedef enum
+{
+    UNIT_ENVIII_EXPORT_CSV = 0,     /*!< Header line then one comma separated line per bucket */
+    UNIT_ENVIII_EXPORT_NDJSON       /*!< One JSON object per line per bucket */
+} unit_enviii_export_format_t;
+
+/**
+ * @brief Called with each full chunk, and the final partial one.
+ * Returning anything other than ESP_OK aborts the export with that error.
+ */
+typedef esp_err_t ( *unit_enviii_export_write_t )( const char *data, size_t length, void *user );
+
+/**
+ * @brief Exporter walking a history store with a cursor. Records are
+ * formatted with integer routines into a fixed chunk which is handed to the
+ * write callback when full, so exports of any size run in constant memory.
+ */
+typedef struct
+{
+    const unit_enviii_history_t *history;   /*!< History store being exported */
+    unit_enviii_export_format_t format;     /*!< Output format */
+    uint16_t cursor;                        /*!< Next bucket to format */
+    bool header_done;                       /*!< CSV header already formatted */
+    size_t fill;                            /*!< Bytes in chunk */
+    uint32_t records;                       /*!< Records formatted */
+    uint32_t bytes;                         /*!< Bytes handed to the write callback */
+    int64_t elapsed_us;                     /*!< Time spent formatting and writing */
+    char chunk[ UNIT_ENVIII_EXPORT_CHUNK_SIZE ]; /*!< Output chunk */
+} unit_enviii_export_t;
+
+/** 
+ * @brief Start an export of a history store. The store must not be appended
+ * to until the export is finished.
+ * @param exporter The exporter.
+ * @param history The history store to export.
+ * @param format The output format.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_export_begin( unit_enviii_export_t *exporter, const unit_enviii_history_t *history, unit_enviii_export_format_t format );
+
+/** 
+ * @brief Format records until one chunk is written. Lets a caller interleave
+ * the export with other work.
+ * @param exporter The exporter.
+ * @param write Callback receiving the chunk.
+ * @param user Passed to write.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Export finished
+ *  - ESP_ERR_NOT_FINISHED  : More chunks remain
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - Any error returned by write
+ */
+esp_err_t unit_enviii_export_step( unit_enviii_export_t *exporter, unit_enviii_export_write_t write, void *user );
+
+/** 
+ * @brief Run the export to the end. The exporter counts records, bytes and
+ * elapsed time for throughput reporting.
+ * @param exporter The exporter.
+ * @param write Callback receiving the chunks.
+ * @param user Passed to write.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - Any error returned by write
+ */
+esp_err_t unit_enviii_export_run( unit_enviii_export_t *exporter, unit_enviii_export_write_t write, void *user );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,64 @@
+/*!
+ * @brief Memory footprint report of the ENV III driver handles
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_FOOTPRINT_H_
+#define _UNIT_ENV_III_FOOTPRINT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "unit_env_iii.h"
+
+/**
+ * @brief Size of one caller owned handle or driver buffer on this target.
+ */
+typedef struct
+{
+    const char *name;       /*!< Type or buffer name */
+    uint32_t size;          /*!< Size in bytes */
+} unit_enviii_footprint_entry_t;
+
+/** 
+ * @brief Get the sizes of the handles the application allocates for the
+ * driver and its stages. None of the driver or stage functions allocate
+ * from the heap, so these plus the driver statics are the whole RAM cost.
+ * @param entries Set to the first entry of a constant table.
+ * @param count Set to the number of entries.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_footprint_get( const unit_enviii_footprint_entry_t **entries, size_t *count );
+
+/** 
+ * @brief Log the handle sizes at info level.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ */
+esp_err_t unit_enviii_footprint_log( void );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
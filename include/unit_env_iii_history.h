@@ -0,0 +1,121 @@
+/*!
+ * @brief Memory-budgeted ENV III sample history with automatic downsampling
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_HISTORY_H_
+#define _UNIT_ENV_III_HISTORY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "unit_env_iii.h"
+
+#ifndef UNIT_ENVIII_HISTORY_BUCKETS_PER_LEVEL
+#define UNIT_ENVIII_HISTORY_BUCKETS_PER_LEVEL   16
+#endif
+
+/**
+ * @brief Min/max aggregate of consecutive samples, in the packed units of
+ * unit_env_iii_pack.h. A new sample is a level 0 bucket with min equal to max.
+ */
+typedef struct
+{
+    uint32_t start_ms;          /*!< Start of the bucket relative to the history epoch */
+    uint32_t span_ms;           /*!< Time from the first to the last sample in the bucket */
+    int16_t temperature_min;    /*!< Lowest temperature in 0.01 degree Celsius */
+    int16_t temperature_max;    /*!< Highest temperature in 0.01 degree Celsius */
+    uint16_t humidity_min;      /*!< Lowest relative humidity in 0.002 percent */
+    uint16_t humidity_max;      /*!< Highest relative humidity in 0.002 percent */
+    uint32_t pressure_min;      /*!< Lowest pressure in 0.1 Pa */
+    uint32_t pressure_max;      /*!< Highest pressure in 0.1 Pa */
+    uint16_t samples;           /*!< Samples aggregated, saturating */
+    uint8_t channels;           /*!< Mask of channels seen in the bucket */
+    uint8_t level;              /*!< Times the bucket was merged, its span is about 2^level samples */
+} unit_enviii_history_bucket_t;
+
+/**
+ * @brief History store bounded by a byte budget instead of a sample count.
+ * When the budget is used up, the two oldest buckets of the finest
+ * over-populated level are merged pairwise into the next level. Recent data
+ * stays at full resolution, older data gets coarser, and the whole horizon
+ * since the first sample remains covered, up to about 49 days after which
+ * the oldest buckets are dropped.
+ */
+typedef struct
+{
+    unit_enviii_history_bucket_t *buckets;  /*!< Buckets from oldest to newest, inside the caller buffer */
+    uint16_t capacity;                      /*!< Buckets fitting in the budget */
+    uint16_t count;                         /*!< Buckets in use */
+    uint16_t per_level;                     /*!< Buckets a level may hold before it is merged */
+    int64_t epoch_us;                       /*!< Timestamp bucket start times are relative to */
+} unit_enviii_history_t;
+
+/** 
+ * @brief Initialize a history store inside a caller provided buffer.
+ * @param history The history store.
+ * @param buffer Memory holding the buckets, e.g. a static array. Must be 4 byte aligned.
+ * @param budget Size of buffer in bytes, at least four buckets.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_INVALID_SIZE  : Budget too small
+ */
+esp_err_t unit_enviii_history_init( unit_enviii_history_t *history, void *buffer, size_t budget );
+
+/** 
+ * @brief Append a sample, downsampling older data if the budget is used up.
+ * @param history The history store.
+ * @param sample The sample to store.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or sample older than the newest stored
+ */
+esp_err_t unit_enviii_history_append( unit_enviii_history_t *history, const unit_enviii_sample_t *sample );
+
+/** 
+ * @brief Get a bucket of the history.
+ * @param history The history store.
+ * @param index Position of the bucket, 0 is the oldest.
+ * @param bucket Pointer filled with the bucket.
+ * @param start_us Pointer filled with the absolute start of the bucket. Optional.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or no bucket at index
+ */
+esp_err_t unit_enviii_history_bucket_get( const unit_enviii_history_t *history, uint16_t index, unit_enviii_history_bucket_t *bucket, int64_t *start_us );
+
+/** 
+ * @brief Pipeline stage function appending every sample to a history store.
+ * @param sample The sample record.
+ * @param context A unit_enviii_history_t initialized with unit_enviii_history_init().
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_history_stage_process( unit_enviii_sample_t *sample, void *context );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,132 @@
+/*!
+ * @brief Small footprint LZSS compression of encoded payloads
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_LZSS_H_
+#define _UNIT_ENV_III_LZSS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/* Back references reach 2^WINDOW_BITS bytes, which is also the history kept
+ * in RAM. Must match on both ends of the link */
+#ifndef UNIT_ENVIII_LZSS_WINDOW_BITS
+#define UNIT_ENVIII_LZSS_WINDOW_BITS    8
+#endif
+
+/* Matches are 2 to 2^LENGTH_BITS + 1 bytes long. Must match on both ends of the link */
+#ifndef UNIT_ENVIII_LZSS_LENGTH_BITS
+#define UNIT_ENVIII_LZSS_LENGTH_BITS    4
+#endif
+
+#define UNIT_ENVIII_LZSS_WINDOW         ( 1 << UNIT_ENVIII_LZSS_WINDOW_BITS )
+#define UNIT_ENVIII_LZSS_MIN_MATCH      2
+#define UNIT_ENVIII_LZSS_MAX_MATCH      ( ( 1 << UNIT_ENVIII_LZSS_LENGTH_BITS ) + UNIT_ENVIII_LZSS_MIN_MATCH - 1 )
+
+/**
+ * @brief Streaming compressor. Input is buffered a match length at a time
+ * and every token is written to the output buffer as soon as it is found,
+ * so the compressor needs no copy of the input.
+ */
+typedef struct
+{
+    uint8_t window[ UNIT_ENVIII_LZSS_WINDOW ];          /*!< Ring of the bytes already compressed */
+    uint8_t lookahead[ UNIT_ENVIII_LZSS_MAX_MATCH ];    /*!< Bytes waiting to be compressed */
+    uint8_t pending;                                    /*!< Bytes in lookahead */
+    uint8_t bit_count;                                  /*!< Bits in bits not yet written */
+    uint16_t head;                                      /*!< Next write position in window */
+    uint16_t filled;                                    /*!< Bytes in window */
+    uint32_t bits;                                      /*!< Output bits not yet written, right aligned */
+    uint8_t *out;                                       /*!< Output buffer */
+    size_t size;                                        /*!< Room in out */
+    size_t length;                                      /*!< Bytes written to out */
+} unit_enviii_lzss_t;
+
+/** 
+ * @brief Start compressing into a buffer.
+ * @param lzss The compressor.
+ * @param out Output buffer.
+ * @param size Room in out.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_lzss_init( unit_enviii_lzss_t *lzss, uint8_t *out, size_t size );
+
+/** 
+ * @brief Compress more input. Use unit_enviii_lzss_bound() first to check
+ * that the output cannot overflow.
+ * @param lzss The compressor.
+ * @param data Input bytes.
+ * @param length Number of input bytes.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_NO_MEM        : Output buffer full, the output is unusable
+ */
+esp_err_t unit_enviii_lzss_write( unit_enviii_lzss_t *lzss, const uint8_t *data, size_t length );
+
+/** 
+ * @brief Compress the buffered input and pad the last byte.
+ * @param lzss The compressor.
+ * @param length Total bytes written to the output buffer.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_NO_MEM        : Output buffer full, the output is unusable
+ */
+esp_err_t unit_enviii_lzss_finish( unit_enviii_lzss_t *lzss, size_t *length );
+
+/** 
+ * @brief Worst case output length if length more bytes are written and the
+ * stream is then finished, with every byte left a literal.
+ * @param lzss The compressor.
+ * @param length Number of input bytes to add.
+ * @return Output bytes.
+ */
+size_t unit_enviii_lzss_bound( const unit_enviii_lzss_t *lzss, size_t length );
+
+/** 
+ * @brief Decompress a whole stream, e.g. on the receiving side. Plain C
+ * without state, so it also builds on a host.
+ * @param in Compressed stream.
+ * @param in_length Length of the stream.
+ * @param out Filled with the original bytes.
+ * @param size Room in out.
+ * @param length Number of bytes decompressed.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_INVALID_SIZE  : Output larger than size
+ *  - ESP_FAIL              : Back reference before the start of the output, the stream is corrupt
+ */
+esp_err_t unit_enviii_lzss_decompress( const uint8_t *in, size_t in_length, uint8_t *out, size_t size, size_t *length );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,116 @@
+/*!
+ * @brief Streaming median-of-N filter for the ENV III unit sensor channels
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_MEDIAN_H_
+#define _UNIT_ENV_III_MEDIAN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "unit_env_iii.h"
+
+#ifndef UNIT_ENVIII_MEDIAN_MAX_WINDOW
+#define UNIT_ENVIII_MEDIAN_MAX_WINDOW   15
+#endif
+
+/**
+ * @brief Running median over the last N fixed-point samples of one channel.
+ * Samples are kept in arrival order in a ring and, by ring slot, in two heaps:
+ * a max-heap with the lower half of the window and a min-heap with the upper
+ * half, so the median sits on the heap tops. The heap position of every slot
+ * is tracked so the outgoing sample is overwritten in place and only sifted
+ * along one branch, O(log N) per update. All memory is inside the struct.
+ */
+typedef struct
+{
+    uint8_t window;                                             /*!< Number of samples N the median is taken over */
+    uint8_t head;                                               /*!< Ring slot holding the oldest sample once full */
+    uint8_t lower_count;                                        /*!< Slots in the lower half max-heap */
+    uint8_t upper_count;                                        /*!< Slots in the upper half min-heap, lower_count or one less */
+    uint8_t lower[ ( UNIT_ENVIII_MEDIAN_MAX_WINDOW + 1 ) / 2 ]; /*!< Max-heap of the ring slots of the lower half */
+    uint8_t upper[ UNIT_ENVIII_MEDIAN_MAX_WINDOW / 2 ];         /*!< Min-heap of the ring slots of the upper half */
+    uint8_t index[ UNIT_ENVIII_MEDIAN_MAX_WINDOW ];             /*!< Heap position of each ring slot, top bit set in the upper heap */
+    int32_t ring[ UNIT_ENVIII_MEDIAN_MAX_WINDOW ];              /*!< Samples in arrival order */
+} unit_enviii_median_t;
+
+/** 
+ * @brief Initialize or reset a median filter.
+ * @param filter The filter to initialize.
+ * @param window Number of samples the median is taken over, 1 to UNIT_ENVIII_MEDIAN_MAX_WINDOW.
+ * An odd window returns an actual sample, an even one the mean of the two middle samples.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_median_init( unit_enviii_median_t *filter, uint8_t window );
+
+/** 
+ * @brief Push a sample into the filter and get the median of the window.
+ * Until the window is full the median of the samples received so far is returned.
+ * @param filter The filter to update.
+ * @param value The new sample.
+ * @param median The median of the window including the new sample.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_median_update( unit_enviii_median_t *filter, int32_t value, int32_t *median );
+
+/**
+ * @brief Pipeline stage context running a median filter on each selected channel.
+ * Register with unit_enviii_median_stage_process() after the compensation stages,
+ * with the whole struct as the snapshot state to keep the windows across resets.
+ */
+typedef struct
+{
+    uint32_t channels;                                          /*!< Mask of filtered channels */
+    unit_enviii_median_t filter[ UNIT_ENVIII_CHANNEL_MAX ];     /*!< Per-channel filter state */
+} unit_enviii_median_stage_t;
+
+/** 
+ * @brief Initialize a median filter pipeline stage.
+ * @param stage The stage context to initialize.
+ * @param channels Mask of channels to filter, built with UNIT_ENVIII_CHANNEL_BIT().
+ * @param window Number of samples the median is taken over on every channel.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_median_stage_init( unit_enviii_median_stage_t *stage, uint32_t channels, uint8_t window );
+
+/** 
+ * @brief Pipeline stage function replacing each selected valid channel by its running median.
+ * @param sample The sample record processed in place.
+ * @param context A unit_enviii_median_stage_t initialized with unit_enviii_median_stage_init().
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_median_stage_process( unit_enviii_sample_t *sample, void *context );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,118 @@
+/*!
+ * @brief Dew point margin and mold risk index for ENV III storage room monitoring
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_MOLD_H_
+#define _UNIT_ENV_III_MOLD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "unit_env_iii.h"
+
+#define UNIT_ENVIII_MOLD_INDEX_MAX          6000
+#define UNIT_ENVIII_MOLD_DEFAULT_GROWTH     1000    /* 0.001 index per hour per percent RH above the isopleth */
+#define UNIT_ENVIII_MOLD_DEFAULT_DECAY      1330    /* 0.000001 index per hour below the isopleth */
+
+/**
+ * @brief Integrated state of the mold risk index.
+ */
+typedef struct
+{
+    int64_t index;              /*!< Mold index in 1e-9 units */
+    int64_t last_us;            /*!< Timestamp of the last sample integrated, 0 before the first */
+} unit_enviii_mold_state_t;
+
+/**
+ * @brief Mold risk model, used as the context of unit_enviii_mold_stage_process().
+ * Vapour pressure is carried from the air to a surface at a configurable
+ * temperature, such as a cold wall. The index grows while the surface
+ * humidity is above the lowest isopleth for mold growth (VTT model, 80
+ * percent above 20 degree Celsius rising towards 100 percent at 0 degree
+ * Celsius) in proportion to the excess, and slowly declines otherwise.
+ */
+typedef struct
+{
+    bool surface_valid;                 /*!< Surface temperature set, otherwise the air temperature is used */
+    int32_t surface_temperature;        /*!< Surface temperature in 0.001 degree Celsius */
+    uint32_t growth_rate;               /*!< Growth in 1e-6 index per hour per percent RH above the isopleth */
+    uint32_t decay_rate;                /*!< Decline in 1e-6 index per hour below the isopleth */
+    unit_enviii_mold_state_t state;     /*!< Integrated state, the snapshot state of the stage */
+} unit_enviii_mold_t;
+
+/** 
+ * @brief Compute the dew point from lookup tables, without floating point.
+ * @param temperature Air temperature in 0.001 degree Celsius, -40 to 60 degree Celsius.
+ * @param humidity Relative humidity in 0.001 percent.
+ * @param dew_point Pointer filled with the dew point in 0.001 degree Celsius.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_dew_point_get( int32_t temperature, int32_t humidity, int32_t *dew_point );
+
+/** 
+ * @brief Initialize a mold risk model with the default rates.
+ * @param mold The model.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_mold_init( unit_enviii_mold_t *mold );
+
+/** 
+ * @brief Set the temperature of the monitored surface, e.g. from a probe on an outer wall.
+ * @param mold The model.
+ * @param temperature Surface temperature in 0.001 degree Celsius.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_mold_surface_temperature_set( unit_enviii_mold_t *mold, int32_t temperature );
+
+/** 
+ * @brief Update the model with a sample and fill its dew point, margin and mold index.
+ * Samples without temperature and humidity are left untouched.
+ * @param mold The model.
+ * @param sample The sample record.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_mold_update( unit_enviii_mold_t *mold, unit_enviii_sample_t *sample );
+
+/** 
+ * @brief Pipeline stage function running the mold risk model on every sample.
+ * @param sample The sample record processed in place.
+ * @param context A unit_enviii_mold_t initialized with unit_enviii_mold_init().
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_mold_stage_process( unit_enviii_sample_t *sample, void *context );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,137 @@
+/*!
+ * @brief Bit-packed columnar storage format for ENV III sample history
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_PACK_H_
+#define _UNIT_ENV_III_PACK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "unit_env_iii.h"
+
+#ifndef UNIT_ENVIII_PACK_BLOCK_SAMPLES
+#define UNIT_ENVIII_PACK_BLOCK_SAMPLES  32
+#endif
+
+#define UNIT_ENVIII_PACK_PRESSURE_MAX   0xFFFFFF
+
+/**
+ * @brief Block of samples stored column by column at sensor resolution.
+ * Temperature is kept in 0.01 degree Celsius, humidity in 0.002 percent and
+ * pressure in 0.1 Pa split into a 16 bit and an 8 bit plane, so a sample
+ * takes 10 bytes including its timestamp delta and channel mask. Each column
+ * is a contiguous array that can be scanned on its own.
+ */
+typedef struct
+{
+    int64_t base_us;                                            /*!< Timestamp of the first sample */
+    int64_t last_us;                                            /*!< Timestamp of the last sample */
+    uint16_t count;                                             /*!< Samples held */
+    uint16_t delta_ms[ UNIT_ENVIII_PACK_BLOCK_SAMPLES ];        /*!< Milliseconds since the previous sample, 0 for the first */
+    int16_t temperature[ UNIT_ENVIII_PACK_BLOCK_SAMPLES ];      /*!< Temperature in 0.01 degree Celsius */
+    uint16_t humidity[ UNIT_ENVIII_PACK_BLOCK_SAMPLES ];        /*!< Relative humidity in 0.002 percent */
+    uint16_t pressure_lo[ UNIT_ENVIII_PACK_BLOCK_SAMPLES ];     /*!< Pressure in 0.1 Pa, bits 0 to 15 */
+    uint8_t pressure_hi[ UNIT_ENVIII_PACK_BLOCK_SAMPLES ];      /*!< Pressure in 0.1 Pa, bits 16 to 23 */
+    uint8_t channels[ UNIT_ENVIII_PACK_BLOCK_SAMPLES ];         /*!< Mask of valid channels per sample */
+} unit_enviii_pack_block_t;
+
+/**
+ * @brief Convert a temperature from the sample record to the packed format.
+ */
+static inline int16_t unit_enviii_pack_temperature( int32_t millidegrees )
+{
+    int32_t centidegrees = ( millidegrees + ( millidegrees < 0 ? -5 : 5 ) ) / 10;
+    return ( int16_t )( centidegrees > INT16_MAX ? INT16_MAX : centidegrees < INT16_MIN ? INT16_MIN : centidegrees );
+}
+
+/**
+ * @brief Convert a temperature from the packed format to the sample record.
+ */
+static inline int32_t unit_enviii_unpack_temperature( int16_t packed )
+{
+    return ( int32_t )packed * 10;
+}
+
+/**
+ * @brief Convert a humidity from the sample record to the packed format.
+ */
+static inline uint16_t unit_enviii_pack_humidity( int32_t millipercent )
+{
+    int32_t packed = ( millipercent + 1 ) / 2;
+    return ( uint16_t )( packed < 0 ? 0 : packed > UINT16_MAX ? UINT16_MAX : packed );
+}
+
+/**
+ * @brief Convert a humidity from the packed format to the sample record.
+ */
+static inline int32_t unit_enviii_unpack_humidity( uint16_t packed )
+{
+    return ( int32_t )packed * 2;
+}
+
+/**
+ * @brief Clamp a pressure from the sample record to the 24 bit packed range.
+ */
+static inline uint32_t unit_enviii_pack_pressure( int32_t decipascal )
+{
+    return decipascal < 0 ? 0 : decipascal > UNIT_ENVIII_PACK_PRESSURE_MAX ? UNIT_ENVIII_PACK_PRESSURE_MAX : ( uint32_t )decipascal;
+}
+
+/** 
+ * @brief Initialize or empty a packed block.
+ * @param block The block to initialize.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_pack_block_init( unit_enviii_pack_block_t *block );
+
+/** 
+ * @brief Append a sample to a packed block.
+ * @param block The block to append to.
+ * @param sample The sample to store.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or sample older than the last one stored
+ *  - ESP_ERR_NO_MEM        : Block full, start a new one
+ *  - ESP_ERR_INVALID_SIZE  : Gap to the last sample does not fit the delta column, start a new block
+ */
+esp_err_t unit_enviii_pack_block_append( unit_enviii_pack_block_t *block, const unit_enviii_sample_t *sample );
+
+/** 
+ * @brief Unpack a stored sample. Timestamps are rebuilt from the delta
+ * column, so scanning a block in order is cheaper than random access.
+ * @param block The block to read from.
+ * @param index Position of the sample in the block.
+ * @param sample The sample record to fill, flags are cleared.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or no sample at index
+ */
+esp_err_t unit_enviii_pack_block_get( const unit_enviii_pack_block_t *block, uint16_t index, unit_enviii_sample_t *sample );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
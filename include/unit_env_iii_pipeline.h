@@ -0,0 +1,196 @@
+/*!
+ * @brief Per-sample processing pipeline for the ENV III unit
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_PIPELINE_H_
+#define _UNIT_ENV_III_PIPELINE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "unit_env_iii.h"
+
+#ifndef UNIT_ENVIII_PIPELINE_MAX_STAGES
+#define UNIT_ENVIII_PIPELINE_MAX_STAGES 8
+#endif
+
+#ifndef UNIT_ENVIII_PIPELINE_RTC_SNAPSHOT_SIZE
+#define UNIT_ENVIII_PIPELINE_RTC_SNAPSHOT_SIZE  1024
+#endif
+
+#define UNIT_ENVIII_PIPELINE_SNAPSHOT_VERSION   1
+
+/**
+ * @brief Processing function of a pipeline stage.
+ * Works on the shared sample record in place. Returning anything other than
+ * ESP_OK stops the pipeline and the error is returned to the caller.
+ */
+typedef esp_err_t ( *unit_enviii_stage_process_t )( unit_enviii_sample_t *sample, void *context );
+
+/**
+ * @brief A processing stage registered with the pipeline.
+ */
+typedef struct
+{
+    const char *name;                       /*!< Name reported in the stage statistics */
+    unit_enviii_stage_process_t process;    /*!< Function run for every validated sample */
+    void *context;                          /*!< Stage state passed to process, owned by the caller */
+    void *state;                            /*!< Optional runtime state kept across resets by the snapshot, NULL if none */
+    uint16_t state_size;                    /*!< Size of state in bytes */
+} unit_enviii_stage_t;
+
+/**
+ * @brief Timing instrumentation of a pipeline stage.
+ */
+typedef struct
+{
+    const char *name;       /*!< Name of the stage */
+    uint32_t runs;          /*!< Samples processed */
+    uint32_t errors;        /*!< Runs that returned an error */
+    uint32_t last_us;       /*!< Duration of the last run in microseconds, 0 without UNIT_ENVIII_INSTRUMENTATION */
+    uint32_t max_us;        /*!< Longest run in microseconds */
+    uint64_t total_us;      /*!< Sum of all runs in microseconds */
+} unit_enviii_stage_stats_t;
+
+/** 
+ * @brief Append a stage to the end of the pipeline. Stages are meant to be
+ * registered during init and run in registration order.
+ * @param stage The stage to register. It is copied, the context must outlive the pipeline.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_NO_MEM        : All UNIT_ENVIII_PIPELINE_MAX_STAGES slots are in use
+ */
+esp_err_t unit_enviii_pipeline_stage_register( const unit_enviii_stage_t *stage );
+
+/** 
+ * @brief Remove all stages from the pipeline.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ */
+esp_err_t unit_enviii_pipeline_clear( void );
+
+/** 
+ * @brief Run every registered stage in order over a sample, then deliver it
+ * to the subscribers. Called by unit_enviii_sample_get() for each validated sample.
+ * @param sample The sample record processed in place.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - Any error returned by a stage
+ */
+esp_err_t unit_enviii_pipeline_run( unit_enviii_sample_t *sample );
+
+/** 
+ * @brief Number of stages registered with the pipeline.
+ * @param count Pointer filled with the number of stages.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_pipeline_stage_count_get( uint8_t *count );
+
+/** 
+ * @brief Get the timing instrumentation of a stage.
+ * @param index Position of the stage in the pipeline.
+ * @param stats Pointer filled with the stage statistics.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or no stage at index
+ */
+esp_err_t unit_enviii_pipeline_stage_stats_get( uint8_t index, unit_enviii_stage_stats_t *stats );
+
+/** 
+ * @brief Reset the timing instrumentation of all stages.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ */
+esp_err_t unit_enviii_pipeline_stats_reset( void );
+
+/** 
+ * @brief Current time on the sample timebase. Continues from the saved time
+ * after a snapshot restore so time based stage state stays consistent.
+ * @return Time in microseconds.
+ */
+int64_t unit_enviii_pipeline_timestamp_get( void );
+
+/** 
+ * @brief Size of the snapshot blob for the registered stages.
+ * @param size Pointer filled with the blob size in bytes.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_pipeline_snapshot_size_get( size_t *size );
+
+/** 
+ * @brief Serialize the state of every stage that declares one into a
+ * versioned blob, for example to store in flash before powering down.
+ * @param buffer Destination of the blob.
+ * @param size Size of buffer in bytes.
+ * @param written Pointer filled with the blob size. Optional.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_INVALID_SIZE  : buffer too small
+ */
+esp_err_t unit_enviii_pipeline_snapshot_save( uint8_t *buffer, size_t size, size_t *written );
+
+/** 
+ * @brief Restore stage state from a blob made by unit_enviii_pipeline_snapshot_save().
+ * Must be called after the stages are registered in the same order as when
+ * saved. Stages whose name or state size changed keep their fresh state.
+ * @param buffer The blob.
+ * @param size Size of buffer in bytes.
+ * @param elapsed_us Time spent between the save and this restore, e.g. the deep sleep duration.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_INVALID_SIZE  : Truncated blob
+ *  - ESP_ERR_INVALID_VERSION : Blob made by another snapshot version
+ *  - ESP_ERR_INVALID_CRC   : Corrupted blob
+ */
+esp_err_t unit_enviii_pipeline_snapshot_restore( const uint8_t *buffer, size_t size, int64_t elapsed_us );
+
+/** 
+ * @brief Save the snapshot to RTC memory, which survives deep sleep and soft resets.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_SIZE  : Snapshot larger than UNIT_ENVIII_PIPELINE_RTC_SNAPSHOT_SIZE
+ */
+esp_err_t unit_enviii_pipeline_snapshot_rtc_save( void );
+
+/** 
+ * @brief Restore the snapshot saved to RTC memory.
+ * @param elapsed_us Time spent between the save and this restore, e.g. the deep sleep duration.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_CRC   : No valid snapshot in RTC memory, e.g. after power on
+ *  - Any error returned by unit_enviii_pipeline_snapshot_restore()
+ */
+esp_err_t unit_enviii_pipeline_snapshot_rtc_restore( int64_t elapsed_us );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
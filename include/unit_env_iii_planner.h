@@ -0,0 +1,127 @@
+/*!
+ * @brief Energy budget planner choosing the cheapest sensor configuration
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_PLANNER_H_
+#define _UNIT_ENV_III_PLANNER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "unit_env_iii_backend.h"
+
+/**
+ * @brief How a sensor is sampled.
+ */
+typedef enum
+{
+    UNIT_ENVIII_PLANNER_MODE_OFF = 0,       /*!< Sensor not needed */
+    UNIT_ENVIII_PLANNER_MODE_SINGLE_SHOT,   /*!< Trigger, wait for the conversion and fetch on every read */
+    UNIT_ENVIII_PLANNER_MODE_PIPELINED,     /*!< Fetch the conversion started at the previous read and trigger the next one */
+    UNIT_ENVIII_PLANNER_MODE_PERIODIC       /*!< Sensor converts on its own, SHT30 periodic or pressure sensor normal mode */
+} unit_enviii_planner_mode_t;
+
+/**
+ * @brief Requirements of one channel. A zero limit is not checked.
+ */
+typedef struct
+{
+    uint32_t interval_ms;       /*!< Time between reads, 0 if the channel is not needed */
+    uint32_t max_latency_us;    /*!< Longest time from starting a read to having the value */
+    uint32_t max_age_us;        /*!< Oldest the delivered value may be, including IIR filter lag */
+    int32_t max_noise;          /*!< Largest RMS noise in channel units, see unit_enviii_channel_t */
+} unit_enviii_planner_channel_t;
+
+/**
+ * @brief What the planner has to meet.
+ * The budget is budget_ua if set, otherwise battery_mah spread over
+ * life_hours. Without either the cheapest configuration is returned.
+ */
+typedef struct
+{
+    unit_enviii_variant_t variant;              /*!< Unit the configuration is for */
+    uint32_t budget_ua;                         /*!< Average current budget of the sensors in microamps */
+    uint32_t battery_mah;                       /*!< Battery capacity in milliamp hours */
+    uint32_t life_hours;                        /*!< Battery life to reach in hours */
+    uint32_t host_active_ua;                    /*!< Host current while awake for a sensor access, 0 to count the sensors only */
+    uint16_t heater_duty;                       /*!< SHT heater on time in 0.1 percent, 0 for none, fixed by the caller */
+    unit_enviii_planner_channel_t temperature;  /*!< Temperature requirements */
+    unit_enviii_planner_channel_t humidity;     /*!< Humidity requirements */
+    unit_enviii_planner_channel_t pressure;     /*!< Pressure requirements */
+} unit_enviii_planner_request_t;
+
+/**
+ * @brief Estimated performance of one channel.
+ */
+typedef struct
+{
+    uint32_t latency_us;    /*!< Time from starting a read to having the value */
+    uint32_t age_us;        /*!< Worst case age of the delivered value, including IIR filter lag */
+    int32_t noise;          /*!< RMS noise in channel units */
+} unit_enviii_planner_estimate_t;
+
+/**
+ * @brief Configuration chosen by the planner and its estimated cost.
+ * repeatability, oversampling and filter use the encoding of
+ * UNIT_ENVIII_SHT_REPEATABILITY, UNIT_ENVIII_PRESSURE_OVERSAMPLING and
+ * UNIT_ENVIII_PRESSURE_FILTER.
+ */
+typedef struct
+{
+    unit_enviii_planner_mode_t humidity_mode;   /*!< Sampling of the temperature and humidity sensor */
+    uint8_t repeatability;                      /*!< SHT repeatability, 0 high, 1 medium, 2 low */
+    uint32_t humidity_period_ms;                /*!< Conversion period, the SHT30 periodic rate in periodic mode */
+    uint16_t heater_duty;                       /*!< SHT heater on time in 0.1 percent */
+    unit_enviii_planner_mode_t pressure_mode;   /*!< Sampling of the pressure sensor */
+    uint8_t oversampling;                       /*!< Pressure oversampling, 1 to 5 for 1x to 16x */
+    uint8_t filter;                             /*!< Pressure IIR filter, 0 off and 1 to 4 for coefficients 2 to 16 */
+    uint32_t pressure_standby_us;               /*!< Standby time between conversions in periodic mode */
+    uint32_t current_na;                        /*!< Estimated average current of the sensors in nanoamps */
+    uint32_t life_hours;                        /*!< Estimated battery life, 0 without a battery capacity */
+    unit_enviii_planner_estimate_t temperature; /*!< Estimate for the temperature channel */
+    unit_enviii_planner_estimate_t humidity;    /*!< Estimate for the humidity channel */
+    unit_enviii_planner_estimate_t pressure;    /*!< Estimate for the pressure channel */
+} unit_enviii_planner_config_t;
+
+/** 
+ * @brief Find the configuration with the lowest average current that meets
+ * the interval, latency, age and noise limits of every requested channel.
+ * The search covers repeatability, oversampling, IIR filter, single shot,
+ * pipelined and periodic sampling, using the datasheet currents and
+ * conversion times of the sensors. The heater duty is not searched, it is
+ * taken from the request and its current added to every candidate. It needs
+ * no sensor and no driver init, so provisioning tools can run it on a host.
+ * @param request What the configuration has to meet.
+ * @param config Filled with the chosen configuration, also when it is over budget.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_NOT_FOUND     : No configuration meets the limits
+ *  - ESP_FAIL              : The cheapest configuration meeting the limits is over budget
+ */
+esp_err_t unit_enviii_planner_plan( const unit_enviii_planner_request_t *request, unit_enviii_planner_config_t *config );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,147 @@
+/*!
+ * @brief Model based reporting of ENV III samples
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_REPORT_H_
+#define _UNIT_ENV_III_REPORT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "unit_env_iii.h"
+
+/**
+ * @brief When a channel is reported.
+ */
+typedef enum
+{
+    UNIT_ENVIII_REPORT_FIXED = 0,   /*!< Every interval_ms, the receiver holds the last value */
+    UNIT_ENVIII_REPORT_DEADBAND,    /*!< When the value moves more than the tolerance from the last one reported */
+    UNIT_ENVIII_REPORT_PREDICTIVE   /*!< When the value leaves the tolerance around the line extrapolated from the last report */
+} unit_enviii_report_mode_t;
+
+/**
+ * @brief Model of one channel as last reported. The receiver predicts the
+ * channel from it with unit_enviii_report_predict() until the next update.
+ */
+typedef struct
+{
+    int64_t timestamp_us;   /*!< Time of the reported value */
+    int32_t value;          /*!< Reported value in channel units */
+    int32_t slope;          /*!< Change per hour in channel units, 0 unless predictive */
+} unit_enviii_report_model_t;
+
+/**
+ * @brief Model update, also the state kept by the receiver.
+ */
+typedef struct
+{
+    uint32_t channels;                                          /*!< Mask of the channels whose model is set */
+    unit_enviii_report_model_t model[ UNIT_ENVIII_CHANNEL_MAX ];  /*!< Models indexed by unit_enviii_channel_t */
+} unit_enviii_report_update_t;
+
+/**
+ * @brief Called with each update holding the models of the channels that
+ * changed. On an error the models stay as they were and the update is
+ * retried with the next sample.
+ */
+typedef esp_err_t ( *unit_enviii_report_publish_t )( const unit_enviii_report_update_t *update, void *user );
+
+/**
+ * @brief Reporting options.
+ */
+typedef struct
+{
+    unit_enviii_report_mode_t mode;             /*!< When channels are reported */
+    uint32_t channels;                          /*!< Mask of the channels reported, see UNIT_ENVIII_CHANNEL_BIT() */
+    int32_t tolerance[ UNIT_ENVIII_CHANNEL_MAX ]; /*!< Largest error the receiver sees, in channel units, deadband and predictive */
+    uint32_t interval_ms;                       /*!< Reporting period, fixed */
+    uint32_t heartbeat_ms;                      /*!< Longest time a channel goes unreported, 0 for no limit */
+    unit_enviii_report_publish_t publish;       /*!< Update callback */
+    void *user;                                 /*!< Passed to the update callback */
+} unit_enviii_report_config_t;
+
+/**
+ * @brief Reporter, used as the context of unit_enviii_report_stage_process().
+ * It keeps the same models as the receiver and compares every sample with
+ * what the receiver predicts, so updates are only sent when the receiver
+ * would be off by more than the tolerance.
+ */
+typedef struct
+{
+    unit_enviii_report_config_t config;     /*!< Options */
+    unit_enviii_report_update_t state;      /*!< Models as held by the receiver */
+    uint32_t samples;                       /*!< Samples with a reported channel */
+    uint32_t updates;                       /*!< Updates published */
+    uint32_t values;                        /*!< Channel models published */
+    uint32_t failures;                      /*!< Updates the callback failed */
+} unit_enviii_report_t;
+
+/** 
+ * @brief Initialize a reporter.
+ * @param report The reporter.
+ * @param config The options.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_report_init( unit_enviii_report_t *report, const unit_enviii_report_config_t *config );
+
+/** 
+ * @brief Pipeline stage function publishing an update when a reported
+ * channel of the sample is due. The sample is passed on unchanged.
+ * @param sample The sample record.
+ * @param context A unit_enviii_report_t initialized with unit_enviii_report_init().
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - Any error returned by the update callback
+ */
+esp_err_t unit_enviii_report_stage_process( unit_enviii_sample_t *sample, void *context );
+
+/** 
+ * @brief Predict a channel from its model. Plain C, so the receiver runs
+ * the same arithmetic as the device.
+ * @param model The model of the channel.
+ * @param timestamp_us Time to predict, on the sample timebase.
+ * @param value The predicted value in channel units.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_report_predict( const unit_enviii_report_model_t *model, int64_t timestamp_us, int32_t *value );
+
+/** 
+ * @brief Merge an update into the models held by the receiver.
+ * @param state The models held by the receiver, zeroed before the first update.
+ * @param update The update received.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_report_apply( unit_enviii_report_update_t *state, const unit_enviii_report_update_t *update );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
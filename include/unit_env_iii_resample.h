@@ -0,0 +1,108 @@
+/*!
+ * @brief Resampling of the ENV III sensor channels onto a common time grid
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_RESAMPLE_H_
+#define _UNIT_ENV_III_RESAMPLE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "unit_env_iii.h"
+
+/* Grid values held per channel while waiting for the slower channels,
+ * at least the slowest cadence divided by the grid step */
+#ifndef UNIT_ENVIII_RESAMPLE_DEPTH
+#define UNIT_ENVIII_RESAMPLE_DEPTH  16
+#endif
+
+/**
+ * @brief Called with each aligned row. The row is only valid during the call.
+ * Returning anything other than ESP_OK stops the stage with that error.
+ */
+typedef esp_err_t ( *unit_enviii_resample_emit_t )( const unit_enviii_sample_t *row, void *user );
+
+/**
+ * @brief Interpolated values of one channel for the grid instants not emitted yet.
+ */
+typedef struct
+{
+    int64_t last_us;                                /*!< Time of the last sample of the channel */
+    int32_t last_value;                             /*!< Value of the last sample of the channel */
+    bool seen;                                      /*!< A sample of the channel arrived */
+    uint8_t head;                                   /*!< Index of the value for the oldest pending instant */
+    uint8_t count;                                  /*!< Pending values */
+    int32_t value[ UNIT_ENVIII_RESAMPLE_DEPTH ];    /*!< Ring of values, one per grid instant */
+} unit_enviii_resample_channel_t;
+
+/**
+ * @brief Resampler, used as the context of unit_enviii_resample_stage_process().
+ * Each channel is interpolated linearly between its two samples around
+ * every grid instant. A row is emitted once all channels have a value for
+ * its instant, so rows lag by the slowest cadence. When a channel stalls
+ * and another one runs out of room, the oldest row is emitted with the
+ * channels it has, as flagged in its channels mask.
+ */
+typedef struct
+{
+    uint32_t channels;                                                  /*!< Channels aligned into rows */
+    int64_t step_us;                                                    /*!< Grid step */
+    int64_t next_us;                                                    /*!< Grid instant of the next row */
+    bool started;                                                       /*!< Every channel has been seen and the grid is running */
+    unit_enviii_resample_emit_t emit;                                   /*!< Row callback */
+    void *user;                                                         /*!< Passed to the row callback */
+    uint32_t rows;                                                      /*!< Rows emitted */
+    uint32_t partial;                                                   /*!< Rows emitted with a channel missing */
+    unit_enviii_resample_channel_t channel[ UNIT_ENVIII_CHANNEL_MAX ];  /*!< Per-channel pending values */
+} unit_enviii_resample_t;
+
+/** 
+ * @brief Initialize a resampler.
+ * @param resample The resampler.
+ * @param channels Mask of the channels aligned into rows, see UNIT_ENVIII_CHANNEL_BIT().
+ * @param step_ms Grid step, rows are stamped at whole multiples of it on the sample timebase.
+ * @param emit Called with each row.
+ * @param user Passed to emit.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_resample_init( unit_enviii_resample_t *resample, uint32_t channels, uint32_t step_ms, unit_enviii_resample_emit_t emit, void *user );
+
+/** 
+ * @brief Pipeline stage function feeding the samples to the resampler and
+ * emitting the rows they complete. The sample itself is passed on unchanged.
+ * @param sample The sample record.
+ * @param context A unit_enviii_resample_t initialized with unit_enviii_resample_init().
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - Any error returned by the row callback
+ */
+esp_err_t unit_enviii_resample_stage_process( unit_enviii_sample_t *sample, void *context );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,162 @@
+/*!
+ * @brief Threshold and trend alert rules evaluated per ENV III sample
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_RULES_H_
+#define _UNIT_ENV_III_RULES_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "unit_env_iii.h"
+
+/* Rules per engine. Each rule adds 24 bytes to unit_enviii_rules_t, so
+ * 100 rules need -DUNIT_ENVIII_RULES_MAX=100 and take 2640 bytes */
+#ifndef UNIT_ENVIII_RULES_MAX
+#define UNIT_ENVIII_RULES_MAX           32
+#endif
+
+#ifndef UNIT_ENVIII_RULES_MAX_TRENDS
+#define UNIT_ENVIII_RULES_MAX_TRENDS    4
+#endif
+
+#ifndef UNIT_ENVIII_RULES_TREND_POINTS
+#define UNIT_ENVIII_RULES_TREND_POINTS  8
+#endif
+
+/* Words per compiled rule in unit_enviii_rules_program_t::code */
+#define UNIT_ENVIII_RULES_WORDS         4
+
+/**
+ * @brief Condition checked by a rule.
+ */
+typedef enum
+{
+    UNIT_ENVIII_RULE_ABOVE = 0,     /*!< Channel value above threshold */
+    UNIT_ENVIII_RULE_BELOW,         /*!< Channel value below threshold */
+    UNIT_ENVIII_RULE_RISE,          /*!< Channel rose by more than threshold over window_s */
+    UNIT_ENVIII_RULE_DROP           /*!< Channel dropped by more than threshold over window_s */
+} unit_enviii_rule_type_t;
+
+/**
+ * @brief Definition of an alert rule, in the fixed-point units of the channel.
+ * For example "humidity > 70% for 10 min" is { UNIT_ENVIII_RULE_ABOVE,
+ * UNIT_ENVIII_CHANNEL_HUMIDITY, 70000, hysteresis, 600, 0 } and "pressure drop
+ * > 3 hPa/3h" is { UNIT_ENVIII_RULE_DROP, UNIT_ENVIII_CHANNEL_PRESSURE, 3000,
+ * hysteresis, 0, 10800 }.
+ */
+typedef struct
+{
+    unit_enviii_rule_type_t type;   /*!< Condition to check */
+    unit_enviii_channel_t channel;  /*!< Channel the condition applies to */
+    int32_t threshold;              /*!< Value, or change over window_s for rise/drop rules */
+    int32_t hysteresis;             /*!< Margin back past threshold before an active rule clears */
+    uint32_t duration_s;            /*!< Time the condition must hold before the rule activates */
+    uint32_t window_s;              /*!< Span the change is measured over for rise/drop rules */
+} unit_enviii_rule_t;
+
+/**
+ * @brief Rules compiled into a flat array of fixed-width instructions.
+ */
+typedef struct
+{
+    uint16_t count;                                                 /*!< Compiled rules */
+    uint8_t trend_count;                                            /*!< Change trackers used by rise/drop rules */
+    uint8_t trend_channel[ UNIT_ENVIII_RULES_MAX_TRENDS ];          /*!< Channel followed by each tracker */
+    int64_t trend_interval_us[ UNIT_ENVIII_RULES_MAX_TRENDS ];      /*!< Time between tracker checkpoints */
+    int32_t code[ UNIT_ENVIII_RULES_MAX * UNIT_ENVIII_RULES_WORDS ];/*!< Compiled rules */
+} unit_enviii_rules_program_t;
+
+/**
+ * @brief Runtime state of the compiled rules.
+ */
+typedef struct
+{
+    int64_t since_us[ UNIT_ENVIII_RULES_MAX ];                      /*!< Time each pending condition became true */
+    uint32_t active[ ( UNIT_ENVIII_RULES_MAX + 31 ) / 32 ];         /*!< Bitmap of active rules */
+    int64_t trend_next_us[ UNIT_ENVIII_RULES_MAX_TRENDS ];          /*!< Time of the next tracker checkpoint */
+    uint8_t trend_head[ UNIT_ENVIII_RULES_MAX_TRENDS ];             /*!< Oldest checkpoint of each tracker */
+    uint8_t trend_fill[ UNIT_ENVIII_RULES_MAX_TRENDS ];             /*!< Checkpoints held by each tracker */
+    int32_t trend_point[ UNIT_ENVIII_RULES_MAX_TRENDS ][ UNIT_ENVIII_RULES_TREND_POINTS + 1 ]; /*!< Checkpoints */
+} unit_enviii_rules_state_t;
+
+/**
+ * @brief Rule engine, used as the context of unit_enviii_rules_stage_process().
+ * Register state as the snapshot state to keep pending durations and change
+ * trackers across resets.
+ */
+typedef struct
+{
+    unit_enviii_rules_program_t program;    /*!< Compiled rules */
+    unit_enviii_rules_state_t state;        /*!< Runtime state */
+} unit_enviii_rules_t;
+
+/** 
+ * @brief Compile rule definitions into the engine and reset its state.
+ * Rise/drop rules on the same channel and window share one change tracker.
+ * @param rules The rule engine.
+ * @param definitions Array of rule definitions. Rule indexes follow the array order.
+ * @param count Number of definitions, up to UNIT_ENVIII_RULES_MAX.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or invalid definition
+ *  - ESP_ERR_NO_MEM        : More than UNIT_ENVIII_RULES_MAX rules or UNIT_ENVIII_RULES_MAX_TRENDS trackers
+ */
+esp_err_t unit_enviii_rules_compile( unit_enviii_rules_t *rules, const unit_enviii_rule_t *definitions, uint16_t count );
+
+/** 
+ * @brief Evaluate every rule against a sample and raise the rule flags in it.
+ * @param rules The rule engine.
+ * @param sample The sample to evaluate.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_rules_evaluate( unit_enviii_rules_t *rules, unit_enviii_sample_t *sample );
+
+/** 
+ * @brief Check whether a rule is currently active.
+ * @param rules The rule engine.
+ * @param index Index of the rule in the definitions passed to unit_enviii_rules_compile().
+ * @param active Pointer filled with the rule state.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or no rule at index
+ */
+esp_err_t unit_enviii_rules_active_get( const unit_enviii_rules_t *rules, uint16_t index, bool *active );
+
+/** 
+ * @brief Pipeline stage function evaluating the rules on every sample.
+ * @param sample The sample record processed in place.
+ * @param context A unit_enviii_rules_t compiled with unit_enviii_rules_compile().
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_rules_stage_process( unit_enviii_sample_t *sample, void *context );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
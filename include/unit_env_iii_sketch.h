@@ -0,0 +1,165 @@
+/*!
+ * @brief Mergeable fixed-memory quantile sketch for ENV III sensor channels
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_SKETCH_H_
+#define _UNIT_ENV_III_SKETCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "unit_env_iii.h"
+
+#ifndef UNIT_ENVIII_SKETCH_BINS
+#define UNIT_ENVIII_SKETCH_BINS     128
+#endif
+
+#define UNIT_ENVIII_SKETCH_VERSION  1
+
+/* Largest serialized sketch, header plus a five byte varint per bin */
+#define UNIT_ENVIII_SKETCH_SERIALIZED_MAX   ( 32 + 5 * UNIT_ENVIII_SKETCH_BINS )
+
+/**
+ * @brief DDSketch style quantile sketch with a fixed number of logarithmic bins.
+ * Values are shifted by offset so they are positive, then binned so any
+ * quantile is estimated within the relative accuracy alpha of the shifted
+ * value. When the values span more bins than available the lowest bins are
+ * collapsed, so low quantiles lose accuracy first. Sketches with the same
+ * alpha and offset can be merged.
+ */
+typedef struct
+{
+    float alpha;                                /*!< Relative accuracy */
+    float log_gamma;                            /*!< Logarithm of the bin growth factor */
+    int32_t offset;                             /*!< Added to values before binning */
+    int32_t min;                                /*!< Lowest value added */
+    int32_t max;                                /*!< Highest value added */
+    uint32_t count;                             /*!< Values added */
+    uint32_t zero_count;                        /*!< Values not positive after offset */
+    int32_t first_index;                        /*!< Bin index held by bins[ 0 ] */
+    uint32_t bins[ UNIT_ENVIII_SKETCH_BINS ];   /*!< Value counts per bin */
+} unit_enviii_sketch_t;
+
+/**
+ * @brief Pipeline stage context keeping a sketch on each channel.
+ */
+typedef struct
+{
+    unit_enviii_sketch_t sketch[ UNIT_ENVIII_CHANNEL_MAX ];    /*!< Per-channel sketch */
+} unit_enviii_sketch_stage_t;
+
+/** 
+ * @brief Initialize or empty a sketch.
+ * @param sketch The sketch.
+ * @param alpha Relative accuracy, e.g. 0.002 for 0.2 percent of the shifted value.
+ * @param offset Added to values so the channel range is positive, e.g. 50000 for temperatures down to -50 degree Celsius.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or alpha outside (0, 1)
+ */
+esp_err_t unit_enviii_sketch_init( unit_enviii_sketch_t *sketch, float alpha, int32_t offset );
+
+/** 
+ * @brief Add a value to a sketch.
+ * @param sketch The sketch.
+ * @param value Value in the fixed-point unit of the channel.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_sketch_add( unit_enviii_sketch_t *sketch, int32_t value );
+
+/** 
+ * @brief Merge a sketch into another, e.g. to combine devices or hours.
+ * @param into The sketch receiving the values.
+ * @param from The sketch to merge, left unchanged.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or sketches with different alpha or offset
+ */
+esp_err_t unit_enviii_sketch_merge( unit_enviii_sketch_t *into, const unit_enviii_sketch_t *from );
+
+/** 
+ * @brief Estimate a quantile.
+ * @param sketch The sketch.
+ * @param quantile Quantile between 0 and 1, e.g. 0.95 for p95.
+ * @param value Pointer filled with the estimate in the fixed-point unit of the channel.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or quantile outside [0, 1]
+ *  - ESP_ERR_INVALID_STATE : Empty sketch
+ */
+esp_err_t unit_enviii_sketch_quantile_get( const unit_enviii_sketch_t *sketch, float quantile, int32_t *value );
+
+/** 
+ * @brief Serialize a sketch for upload. Only the occupied bin range is
+ * written, as varints, so an hour of a channel is typically a few hundred bytes.
+ * @param sketch The sketch.
+ * @param buffer Destination, UNIT_ENVIII_SKETCH_SERIALIZED_MAX bytes always suffice.
+ * @param size Size of buffer in bytes.
+ * @param written Pointer filled with the serialized size.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_INVALID_SIZE  : buffer too small
+ */
+esp_err_t unit_enviii_sketch_serialize( const unit_enviii_sketch_t *sketch, uint8_t *buffer, size_t size, size_t *written );
+
+/** 
+ * @brief Rebuild a sketch from unit_enviii_sketch_serialize() output.
+ * @param sketch The sketch to fill.
+ * @param buffer The serialized sketch.
+ * @param size Size of buffer in bytes.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or malformed data
+ *  - ESP_ERR_INVALID_VERSION : Serialized by another sketch version
+ */
+esp_err_t unit_enviii_sketch_deserialize( unit_enviii_sketch_t *sketch, const uint8_t *buffer, size_t size );
+
+/** 
+ * @brief Initialize a sketch stage with the default accuracy and offset of
+ * each channel: 0.2 percent above -50 degree Celsius for temperature, 0.2
+ * percent for humidity and 0.01 percent for pressure.
+ * @param stage The stage context.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_sketch_stage_init( unit_enviii_sketch_stage_t *stage );
+
+/** 
+ * @brief Pipeline stage function adding every valid channel to its sketch.
+ * @param sample The sample record.
+ * @param context A unit_enviii_sketch_stage_t.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_sketch_stage_process( unit_enviii_sample_t *sample, void *context );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,132 @@
+/*!
+ * @brief Subscriptions of in-process consumers to ENV III samples
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_SUBSCRIBE_H_
+#define _UNIT_ENV_III_SUBSCRIBE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "unit_env_iii.h"
+
+/* Consumers subscribed at the same time */
+#ifndef UNIT_ENVIII_SUBSCRIBE_MAX
+#define UNIT_ENVIII_SUBSCRIBE_MAX       4
+#endif
+
+/* Samples held for queue subscribers until they release them */
+#ifndef UNIT_ENVIII_SUBSCRIBE_RECORDS
+#define UNIT_ENVIII_SUBSCRIBE_RECORDS   4
+#endif
+
+/**
+ * @brief Called in the sampling task with each sample delivered. The sample
+ * is shared with the other consumers and only valid during the call, so
+ * copy what is needed and return quickly. An error is counted and does not
+ * stop the delivery to others.
+ */
+typedef esp_err_t ( *unit_enviii_subscribe_callback_t )( const unit_enviii_sample_t *sample, void *user );
+
+/**
+ * @brief A consumer of samples.
+ */
+typedef struct
+{
+    uint32_t channels;                          /*!< Deliver samples carrying any of these channels, see UNIT_ENVIII_CHANNEL_BIT() */
+    uint32_t min_interval_ms;                   /*!< Skip samples less than this after the last one delivered, 0 for all */
+    unit_enviii_subscribe_callback_t callback;  /*!< Callback receiving the samples, or NULL to use queue */
+    QueueHandle_t queue;                        /*!< Queue of const unit_enviii_sample_t * receiving the samples when callback is NULL */
+    void *user;                                 /*!< Passed to the callback */
+} unit_enviii_subscription_t;
+
+/**
+ * @brief Delivery counters of a subscriber.
+ */
+typedef struct
+{
+    uint32_t delivered;     /*!< Samples delivered */
+    uint32_t skipped;       /*!< Samples skipped by the rate limit */
+    uint32_t dropped;       /*!< Samples lost because the queue was full or no record was free */
+    uint32_t errors;        /*!< Deliveries the callback returned an error for */
+} unit_enviii_subscribe_stats_t;
+
+/** 
+ * @brief Subscribe a consumer to the samples leaving the pipeline.
+ * @param subscription The consumer. It is copied.
+ * @param id Filled with the subscriber id.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ *  - ESP_ERR_NO_MEM        : All UNIT_ENVIII_SUBSCRIBE_MAX slots are in use
+ */
+esp_err_t unit_enviii_subscribe( const unit_enviii_subscription_t *subscription, uint8_t *id );
+
+/** 
+ * @brief Stop the delivery to a subscriber. A sample being delivered while
+ * this is called may still reach it once.
+ * @param id The subscriber id.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: No subscriber with this id
+ */
+esp_err_t unit_enviii_unsubscribe( uint8_t id );
+
+/** 
+ * @brief Give back a sample received from a subscription queue. Every
+ * sample received must be released once it is no longer used.
+ * @param sample The sample received.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Not a sample received from a queue
+ */
+esp_err_t unit_enviii_subscribe_release( const unit_enviii_sample_t *sample );
+
+/** 
+ * @brief Deliver a sample to every subscriber whose channels and rate limit
+ * it matches. Called by unit_enviii_pipeline_run() once the stages have
+ * processed the sample. Callbacks get the sample itself and queue
+ * subscribers share a single copy of it.
+ * @param sample The sample record.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success, also when a delivery failed
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error
+ */
+esp_err_t unit_enviii_subscribe_dispatch( const unit_enviii_sample_t *sample );
+
+/** 
+ * @brief Get the delivery counters of a subscriber.
+ * @param id The subscriber id.
+ * @param stats Filled with the counters.
+ * @return [esp_err_t](https://docs.espressif.com/projects/esp-idf/en/release-v4.3/esp32/api-reference/system/esp_err.html#macros).
+ *  - ESP_OK                : Success
+ *  - ESP_ERR_INVALID_ARG	: Driver parameter error or no subscriber with this id
+ */
+esp_err_t unit_enviii_subscribe_stats_get( uint8_t id, unit_enviii_subscribe_stats_t *stats );
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -16,167 +16,133 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  * 
- * @todo Add support for QMP6988 pressure sensor
- * 
  * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
  * @version  V0.0.1
  * @date  2023-04-03
  */
 
+#include <math.h>
 #include <string.h>
 #include <esp_log.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "unit_env_iii.h"
-#include "sht3x.h"
-
-#define REPEATABILITY_MODE              SHT3X_HIGH
-#define SHT3X_FETCH_DATA_CMD            0xE000
-#define SHT3X_MEAS_DURATION_REP_HIGH    15
-#define SHT3X_MEAS_DURATION_REP_MEDIUM  6
-#define SHT3X_MEAS_DURATION_REP_LOW     4
+#include "unit_env_iii_backend.h"
+#include "unit_env_iii_bus.h"
+#include "unit_env_iii_pipeline.h"
+#include "unit_env_iii_noheap.h"
 
 #define G_POLYNOM 0x31
 
-#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
+#define RETRY_DEFAULT_MAX_RETRIES       3
+#define RETRY_DEFAULT_BACKOFF_INITIAL   5
+#define RETRY_DEFAULT_BACKOFF_MAX       40
 
-#define QMP6988_SLAVE_ADDRESS_L (0x70)
-#define QMP6988_SLAVE_ADDRESS_H (0x56)
-
-#define QMP6988_U16_t unsigned short
-#define QMP6988_S16_t short
-#define QMP6988_U32_t unsigned int
-#define QMP6988_S32_t int
-#define QMP6988_U64_t unsigned long long
-#define QMP6988_S64_t long long
-
-#define QMP6988_CHIP_ID 0x5C
-
-#define QMP6988_CHIP_ID_REG     0xD1
-#define QMP6988_RESET_REG       0xE0 /* Device reset register */
-#define QMP6988_DEVICE_STAT_REG 0xF3 /* Device state register */
-#define QMP6988_CTRLMEAS_REG    0xF4 /* Measurement Condition Control Register */
-/* data */
-#define QMP6988_PRESSURE_MSB_REG    0xF7 /* Pressure MSB Register */
-#define QMP6988_TEMPERATURE_MSB_REG 0xFA /* Temperature MSB Reg */
-
-/* compensation calculation */
-#define QMP6988_CALIBRATION_DATA_START \
-    0xA0 /* QMP6988 compensation coefficients */
-#define QMP6988_CALIBRATION_DATA_LENGTH 25
-
-#define SHIFT_RIGHT_4_POSITION 4
-#define SHIFT_LEFT_2_POSITION  2
-#define SHIFT_LEFT_4_POSITION  4
-#define SHIFT_LEFT_5_POSITION  5
-#define SHIFT_LEFT_8_POSITION  8
-#define SHIFT_LEFT_12_POSITION 12
-#define SHIFT_LEFT_16_POSITION 16
-
-/* power mode */
-#define QMP6988_SLEEP_MODE  0x00
-#define QMP6988_FORCED_MODE 0x01
-#define QMP6988_NORMAL_MODE 0x03
-
-#define QMP6988_CTRLMEAS_REG_MODE__POS 0
-#define QMP6988_CTRLMEAS_REG_MODE__MSK 0x03
-#define QMP6988_CTRLMEAS_REG_MODE__LEN 2
-
-/* oversampling */
-#define QMP6988_OVERSAMPLING_SKIPPED 0x00
-#define QMP6988_OVERSAMPLING_1X      0x01
-#define QMP6988_OVERSAMPLING_2X      0x02
-#define QMP6988_OVERSAMPLING_4X      0x03
-#define QMP6988_OVERSAMPLING_8X      0x04
-#define QMP6988_OVERSAMPLING_16X     0x05
-#define QMP6988_OVERSAMPLING_32X     0x06
-#define QMP6988_OVERSAMPLING_64X     0x07
-
-#define QMP6988_CTRLMEAS_REG_OSRST__POS 5
-#define QMP6988_CTRLMEAS_REG_OSRST__MSK 0xE0
-#define QMP6988_CTRLMEAS_REG_OSRST__LEN 3
-
-#define QMP6988_CTRLMEAS_REG_OSRSP__POS 2
-#define QMP6988_CTRLMEAS_REG_OSRSP__MSK 0x1C
-#define QMP6988_CTRLMEAS_REG_OSRSP__LEN 3
-
-/* filter */
-#define QMP6988_FILTERCOEFF_OFF 0x00
-#define QMP6988_FILTERCOEFF_2   0x01
-#define QMP6988_FILTERCOEFF_4   0x02
-#define QMP6988_FILTERCOEFF_8   0x03
-#define QMP6988_FILTERCOEFF_16  0x04
-#define QMP6988_FILTERCOEFF_32  0x05
-
-#define QMP6988_CONFIG_REG             0xF1 /*IIR filter co-efficient setting Register*/
-#define QMP6988_CONFIG_REG_FILTER__POS 0
-#define QMP6988_CONFIG_REG_FILTER__MSK 0x07
-#define QMP6988_CONFIG_REG_FILTER__LEN 3
-
-#define SUBTRACTOR 8388608
-
-typedef struct _qmp6988_cali_data {
-    QMP6988_S32_t COE_a0;
-    QMP6988_S16_t COE_a1;
-    QMP6988_S16_t COE_a2;
-    QMP6988_S32_t COE_b00;
-    QMP6988_S16_t COE_bt1;
-    QMP6988_S16_t COE_bt2;
-    QMP6988_S16_t COE_bp1;
-    QMP6988_S16_t COE_b11;
-    QMP6988_S16_t COE_bp2;
-    QMP6988_S16_t COE_b12;
-    QMP6988_S16_t COE_b21;
-    QMP6988_S16_t COE_bp3;
-} qmp6988_cali_data_t;
-
-typedef struct _qmp6988_fk_data {
-    float a0, b00;
-    float a1, a2, bt1, bt2, bp1, b11, bp2, b12, b21, bp3;
-} qmp6988_fk_data_t;
-
-typedef struct _qmp6988_ik_data {
-    QMP6988_S32_t a0, b00;
-    QMP6988_S32_t a1, a2;
-    QMP6988_S64_t bt1, bt2, bp1, b11, bp2, b12, b21, bp3;
-} qmp6988_ik_data_t;
-
-typedef struct _qmp6988_data {
-    uint8_t slave;
-    uint8_t chip_id;
-    uint8_t power_mode;
-    float temperature;
-    float pressure;
-    float altitude;
-    qmp6988_cali_data_t qmp6988_cali;
-    qmp6988_ik_data_t ik;
-} qmp6988_data_t;
-
-static const uint16_t SHT3X_MEAS_DURATION_US[3];
-static inline uint16_t shuffle(uint16_t val);
-static uint8_t crc8(uint8_t data[], int len);
-static inline bool is_measuring(sht3x_t *dev);
-static esp_err_t _unit_enviii_qmp6988_get( float *pressure, float *temperature );
-static sht3x_t _dev;
-static const char *_TAG = "UNIT_ENV_III";
+#define BUS_TRIGGER_US                  150
+#define BUS_FETCH_US                    300
 
-// measurement durations in us
-static const uint16_t SHT3X_MEAS_DURATION_US[3] = {
-        SHT3X_MEAS_DURATION_REP_HIGH   * 1000,
-        SHT3X_MEAS_DURATION_REP_MEDIUM * 1000,
-        SHT3X_MEAS_DURATION_REP_LOW    * 1000
-};
+#define SEA_LEVEL_PRESSURE              1013250     /* 0.1 Pa */
 
-static inline uint16_t shuffle(uint16_t val)
-{
-    return (val >> 8) | (val << 8);
-}
+#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
 
-static uint8_t crc8(uint8_t data[], int len)
+#define PRESSURE_NONE ( !UNIT_ENVIII_BACKEND_QMP6988 && !UNIT_ENVIII_BACKEND_BMP280 )
+
+#if UNIT_ENVIII_BACKEND_SHT3X
+#define SHT3X_BACKEND   ( &unit_enviii_backend_sht3x )
+#else
+#define SHT3X_BACKEND   NULL
+#endif
+#if UNIT_ENVIII_BACKEND_SHT4X
+#define SHT4X_BACKEND   ( &unit_enviii_backend_sht4x )
+#else
+#define SHT4X_BACKEND   NULL
+#endif
+#if UNIT_ENVIII_BACKEND_QMP6988
+#define QMP6988_BACKEND ( &unit_enviii_backend_qmp6988 )
+#else
+#define QMP6988_BACKEND NULL
+#endif
+#if UNIT_ENVIII_BACKEND_BMP280
+#define BMP280_BACKEND  ( &unit_enviii_backend_bmp280 )
+#else
+#define BMP280_BACKEND  NULL
+#endif
+
+#if UNIT_ENVIII_BACKEND_SHT3X
+#define DEFAULT_HUMIDITY_BACKEND    SHT3X_BACKEND
+#else
+#define DEFAULT_HUMIDITY_BACKEND    SHT4X_BACKEND
+#endif
+#if UNIT_ENVIII_BACKEND_QMP6988
+#define DEFAULT_PRESSURE_BACKEND    QMP6988_BACKEND
+#elif UNIT_ENVIII_BACKEND_BMP280
+#define DEFAULT_PRESSURE_BACKEND    BMP280_BACKEND
+#else
+#define DEFAULT_PRESSURE_BACKEND    ( &_unit_enviii_backend_none )
+#endif
+
+#if PRESSURE_NONE
+static esp_err_t _unit_enviii_none_init( void );
+static esp_err_t _unit_enviii_none_trigger( void );
+static uint8_t _unit_enviii_none_duration_get( void );
+static esp_err_t _unit_enviii_none_fetch( void );
+static esp_err_t _unit_enviii_none_compensate( unit_enviii_sample_t *sample );
+static const unit_enviii_backend_t _unit_enviii_backend_none = {
+    .name = "none",
+    .channels = 0,
+    .init = _unit_enviii_none_init,
+    .trigger = _unit_enviii_none_trigger,
+    .duration_get = _unit_enviii_none_duration_get,
+    .fetch = _unit_enviii_none_fetch,
+    .compensate = _unit_enviii_none_compensate
+};
+#endif
+
+/* HUMIDITY_OP( fetch )() resolves to a direct call with static dispatch
+ * and to a call through the selected backend table otherwise */
+#if UNIT_ENVIII_BACKEND_STATIC_DISPATCH
+#if UNIT_ENVIII_BACKEND_SHT3X
+#define HUMIDITY_OP( op )   unit_enviii_sht3x_##op
+#else
+#define HUMIDITY_OP( op )   unit_enviii_sht4x_##op
+#endif
+#if UNIT_ENVIII_BACKEND_QMP6988
+#define PRESSURE_OP( op )   unit_enviii_qmp6988_##op
+#elif UNIT_ENVIII_BACKEND_BMP280
+#define PRESSURE_OP( op )   unit_enviii_bmp280_##op
+#else
+#define PRESSURE_OP( op )   _unit_enviii_none_##op
+#endif
+#else
+#define HUMIDITY_OP( op )   _humidity->op
+#define PRESSURE_OP( op )   _pressure->op
+#endif
+
+static esp_err_t _unit_enviii_humidity_read( unit_enviii_sample_t *sample );
+static esp_err_t _unit_enviii_humidity_retry( void );
+static esp_err_t _unit_enviii_pressure_read( unit_enviii_sample_t *sample );
+static esp_err_t _unit_enviii_bus_run( const char *name, esp_err_t ( *run )( void * ), unit_enviii_bus_priority_t priority, uint32_t duration_us );
+static esp_err_t _unit_enviii_bus_humidity_trigger( void *context );
+static esp_err_t _unit_enviii_bus_humidity_fetch( void *context );
+static esp_err_t _unit_enviii_bus_pressure_trigger( void *context );
+static esp_err_t _unit_enviii_bus_pressure_fetch( void *context );
+static const unit_enviii_backend_t *_humidity = DEFAULT_HUMIDITY_BACKEND;
+static const unit_enviii_backend_t *_pressure = DEFAULT_PRESSURE_BACKEND;
+static unit_enviii_retry_config_t _retry_config = {
+    .max_retries = RETRY_DEFAULT_MAX_RETRIES,
+    .backoff_initial_ms = RETRY_DEFAULT_BACKOFF_INITIAL,
+    .backoff_max_ms = RETRY_DEFAULT_BACKOFF_MAX
+};
+static unit_enviii_retry_stats_t _retry_stats;
+static const char *_TAG = "UNIT_ENV_III";
+
+UNIT_ENVIII_HOT_ATTR uint8_t unit_enviii_backend_crc8( const uint8_t *data, size_t len )
 {
     // initialization value
     uint8_t crc = 0xff;
 
     // iterate over all bytes
-    for (int i = 0; i < len; i++)
+    for (size_t i = 0; i < len; i++)
     {
         crc ^= data[i];
         for (int i = 0; i < 8; i++)
@@ -189,111 +155,330 @@ static uint8_t crc8(uint8_t data[], int len)
     return crc;
 }
 
-static inline bool is_measuring(sht3x_t *dev)
+esp_err_t unit_enviii_variant_set( unit_enviii_variant_t variant )
 {
-    // not running if measurement is not started at all or
-    // it is not the first measurement in periodic mode
-    if (!dev->meas_started || !dev->meas_first)
-      return false;
+    const unit_enviii_backend_t *humidity;
+    const unit_enviii_backend_t *pressure;
 
-    // not running if time elapsed is greater than duration
-    uint64_t elapsed = esp_timer_get_time() - dev->meas_start_time;
+    switch ( variant )
+    {
+    case UNIT_ENVIII_VARIANT_ENV_II:
+        humidity = SHT3X_BACKEND;
+        pressure = BMP280_BACKEND;
+        break;
+    case UNIT_ENVIII_VARIANT_ENV_III:
+        humidity = SHT3X_BACKEND;
+        pressure = QMP6988_BACKEND;
+        break;
+    case UNIT_ENVIII_VARIANT_ENV_IV:
+        humidity = SHT4X_BACKEND;
+        pressure = BMP280_BACKEND;
+        break;
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    return elapsed < SHT3X_MEAS_DURATION_US[dev->repeatability];
+    if ( humidity == NULL || pressure == NULL )
+    {
+        ESP_LOGE( _TAG, "Sensors of variant %d are not compiled in", variant );
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    _humidity = humidity;
+    _pressure = pressure;
+
+    return ESP_OK;
 }
 
 esp_err_t unit_enviii_init( uint8_t *duration_to_wait )
 {
-    memset( &_dev, 0, sizeof( sht3x_t ) );
-
-    ESP_ERROR_CHECK( sht3x_init_desc( &_dev, SHT3X_I2C_ADDR_GND, COMMON_I2C_EXTERNAL, PORT_A_SDA_PIN, PORT_A_SCL_PIN ) );
-    ESP_LOGD( _TAG, "Setting SHT30 initial device descriptor success" );
-    ESP_ERROR_CHECK( sht3x_init( &_dev ) );
-    ESP_LOGD( _TAG, "Initializing SHT30 sensor success" );
+    CHECK( HUMIDITY_OP( init )() );
+    ESP_LOGD( _TAG, "Initializing %s backend success", _humidity->name );
+    CHECK( PRESSURE_OP( init )() );
+    ESP_LOGD( _TAG, "Initializing %s backend success", _pressure->name );
 
     return unit_enviii_duration_get( duration_to_wait );
 }
 
 esp_err_t unit_enviii_temp_humidity_measure( void )
 {
-    esp_err_t err = sht3x_start_measurement( &_dev, SHT3X_SINGLE_SHOT, REPEATABILITY_MODE );
-    ESP_LOGD( _TAG, "Start single measurement from SHT30 with high repeatability" );
-    
-    return err;
+    return _unit_enviii_bus_run( "humidity trigger", _unit_enviii_bus_humidity_trigger, UNIT_ENVIII_BUS_PRIORITY_NORMAL, BUS_TRIGGER_US );
 }
 
-esp_err_t unit_enviii_duration_get( uint8_t *duration )
+esp_err_t unit_enviii_sensor_trigger( unit_enviii_sensor_t sensor )
 {
-    esp_err_t ret = ESP_OK;
-
-    *duration = sht3x_get_measurement_duration( REPEATABILITY_MODE );
-
-    return ret;
+    switch ( sensor )
+    {
+    case UNIT_ENVIII_SENSOR_HUMIDITY:
+        return _unit_enviii_bus_run( "humidity trigger", _unit_enviii_bus_humidity_trigger, UNIT_ENVIII_BUS_PRIORITY_NORMAL, BUS_TRIGGER_US );
+    case UNIT_ENVIII_SENSOR_PRESSURE:
+        return _unit_enviii_bus_run( "pressure trigger", _unit_enviii_bus_pressure_trigger, UNIT_ENVIII_BUS_PRIORITY_NORMAL, BUS_TRIGGER_US );
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
 }
 
-esp_err_t unit_enviii_temp_humidity_get( float *temperature, float *humidity )
+esp_err_t unit_enviii_sensor_duration_get( unit_enviii_sensor_t sensor, uint8_t *duration )
 {
-    sht3x_raw_data_t raw_data;
+    if ( duration == NULL )
+        return ESP_ERR_INVALID_ARG;
 
-    if ( !_dev.meas_started )
+    switch ( sensor )
     {
-        ESP_LOGE( _TAG, "Measurement is not started" );
-        return ESP_ERR_INVALID_STATE;
+    case UNIT_ENVIII_SENSOR_HUMIDITY:
+        *duration = HUMIDITY_OP( duration_get )();
+        return ESP_OK;
+    case UNIT_ENVIII_SENSOR_PRESSURE:
+        *duration = PRESSURE_OP( duration_get )();
+        return ESP_OK;
+    default:
+        return ESP_ERR_INVALID_ARG;
     }
-    if (is_measuring(&_dev))
+}
+
+esp_err_t unit_enviii_sensor_read( unit_enviii_sensor_t sensor, unit_enviii_sample_t *sample )
+{
+    if ( sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    switch ( sensor )
     {
-        ESP_LOGE( _TAG, "Measurement is still running" );
-        return ESP_ERR_INVALID_STATE;
+    case UNIT_ENVIII_SENSOR_HUMIDITY:
+        return _unit_enviii_humidity_read( sample );
+    case UNIT_ENVIII_SENSOR_PRESSURE:
+        return _unit_enviii_pressure_read( sample );
+    default:
+        return ESP_ERR_INVALID_ARG;
     }
+}
 
-    // read raw data
-    uint16_t cmd = shuffle( SHT3X_FETCH_DATA_CMD );
-    CHECK( i2c_dev_read( &( _dev.i2c_dev ), &cmd, 1, raw_data, sizeof( sht3x_raw_data_t ) ) );
+esp_err_t unit_enviii_duration_get( uint8_t *duration )
+{
+    uint8_t humidity = HUMIDITY_OP( duration_get )();
+    uint8_t pressure = PRESSURE_OP( duration_get )();
 
-    // reset first measurement flag
-    _dev.meas_first = false;
+    *duration = humidity > pressure ? humidity : pressure;
 
-    // reset measurement started flag in single shot mode
-    if ( _dev.mode == SHT3X_SINGLE_SHOT )
-        _dev.meas_started = false;
+    return ESP_OK;
+}
 
-    // check temperature crc
-    if (crc8(raw_data, 2) != raw_data[ 2 ] )
+esp_err_t unit_enviii_retry_config_set( const unit_enviii_retry_config_t *config )
+{
+    if ( config == NULL || config->backoff_max_ms < config->backoff_initial_ms )
     {
-        ESP_LOGE( _TAG, "CRC check for temperature data failed" );
-        return ESP_ERR_INVALID_CRC;
+        ESP_LOGE( _TAG, "Invalid retry configuration" );
+        return ESP_ERR_INVALID_ARG;
     }
 
-    // check humidity crc
-    if ( crc8(raw_data + 3, 2) != raw_data[ 5 ] )
+    _retry_config = *config;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_retry_config_get( unit_enviii_retry_config_t *config )
+{
+    if ( config == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    *config = _retry_config;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_retry_stats_get( unit_enviii_retry_stats_t *stats )
+{
+    if ( stats == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    *stats = _retry_stats;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_retry_stats_reset( void )
+{
+    memset( &_retry_stats, 0, sizeof( unit_enviii_retry_stats_t ) );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_temp_humidity_get( float *temperature, float *humidity )
+{
+    unit_enviii_sample_t sample;
+
+    sample.channels = 0;
+    CHECK( _unit_enviii_humidity_read( &sample ) );
+
+    *temperature = sample.value[ UNIT_ENVIII_CHANNEL_TEMPERATURE ] / 1000.0f;
+    *humidity = sample.value[ UNIT_ENVIII_CHANNEL_HUMIDITY ] / 1000.0f;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_sample_get( unit_enviii_sample_t *sample )
+{
+    if ( sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    memset( sample, 0, sizeof( unit_enviii_sample_t ) );
+    sample->timestamp_us = unit_enviii_pipeline_timestamp_get();
+    CHECK( _unit_enviii_humidity_read( sample ) );
+    CHECK( _unit_enviii_pressure_read( sample ) );
+
+    return unit_enviii_pipeline_run( sample );
+}
+
+static esp_err_t _unit_enviii_humidity_read( unit_enviii_sample_t *sample )
+{
+    esp_err_t err = _unit_enviii_bus_run( "humidity fetch", _unit_enviii_bus_humidity_fetch, UNIT_ENVIII_BUS_PRIORITY_BACKGROUND, BUS_FETCH_US );
+    if ( err == ESP_ERR_INVALID_CRC )
+        err = _unit_enviii_humidity_retry();
+    if ( err != ESP_OK )
+        return err;
+
+    return HUMIDITY_OP( compensate )( sample );
+}
+
+static esp_err_t _unit_enviii_humidity_retry( void )
+{
+    esp_err_t err = ESP_ERR_INVALID_CRC;
+    uint32_t backoff_ms = _retry_config.backoff_initial_ms;
+
+    _retry_stats.crc_errors++;
+    for ( uint8_t attempt = 0; attempt < _retry_config.max_retries; attempt++ )
     {
-        ESP_LOGE( _TAG, "CRC check for humidity data failed" );
-        return ESP_ERR_INVALID_CRC;
+        TickType_t wait = pdMS_TO_TICKS( backoff_ms );
+        TickType_t duration = HUMIDITY_OP( duration_get )();
+
+        // single shot conversions were consumed by the failed read, the
+        // backend starts a new one and ignores the trigger when free running
+        esp_err_t trigger = _unit_enviii_bus_run( "humidity trigger", _unit_enviii_bus_humidity_trigger, UNIT_ENVIII_BUS_PRIORITY_NORMAL, BUS_TRIGGER_US );
+        if ( wait < duration )
+            wait = duration;
+        vTaskDelay( wait > 0 ? wait : 1 );
+
+        _retry_stats.retries++;
+        err = ( trigger == ESP_OK ) ? _unit_enviii_bus_run( "humidity fetch", _unit_enviii_bus_humidity_fetch, UNIT_ENVIII_BUS_PRIORITY_BACKGROUND, BUS_FETCH_US ) : trigger;
+        if ( err == ESP_OK )
+        {
+            ESP_LOGD( _TAG, "%s read recovered after %u retries", _humidity->name, attempt + 1 );
+            _retry_stats.recovered++;
+            return ESP_OK;
+        }
+        if ( err == ESP_ERR_INVALID_CRC )
+            _retry_stats.crc_errors++;
+
+        backoff_ms *= 2;
+        if ( backoff_ms > _retry_config.backoff_max_ms )
+            backoff_ms = _retry_config.backoff_max_ms;
     }
 
-    return sht3x_compute_values( raw_data, temperature, humidity );
+    ESP_LOGE( _TAG, "%s read failed after %u retries", _humidity->name, _retry_config.max_retries );
+    _retry_stats.failures++;
+
+    return err;
+}
+
+static esp_err_t _unit_enviii_pressure_read( unit_enviii_sample_t *sample )
+{
+    CHECK( _unit_enviii_bus_run( "pressure fetch", _unit_enviii_bus_pressure_fetch, UNIT_ENVIII_BUS_PRIORITY_BACKGROUND, BUS_FETCH_US ) );
+
+    return PRESSURE_OP( compensate )( sample );
+}
+
+/* Sensor reads are background transactions so they fill the gaps other Port A drivers leave */
+static esp_err_t _unit_enviii_bus_run( const char *name, esp_err_t ( *run )( void * ), unit_enviii_bus_priority_t priority, uint32_t duration_us )
+{
+#if UNIT_ENVIII_BUS_SCHEDULER
+    unit_enviii_bus_transaction_t transaction = {
+        .name = name,
+        .priority = priority,
+        .duration_us = duration_us,
+        .run = run,
+        .context = NULL
+    };
+
+    return unit_enviii_bus_submit( &transaction, portMAX_DELAY );
+#else
+    return run( NULL );
+#endif
+}
+
+static esp_err_t _unit_enviii_bus_humidity_trigger( void *context )
+{
+    return HUMIDITY_OP( trigger )();
+}
+
+static esp_err_t _unit_enviii_bus_humidity_fetch( void *context )
+{
+    return HUMIDITY_OP( fetch )();
+}
+
+static esp_err_t _unit_enviii_bus_pressure_trigger( void *context )
+{
+    return PRESSURE_OP( trigger )();
+}
+
+static esp_err_t _unit_enviii_bus_pressure_fetch( void *context )
+{
+    return PRESSURE_OP( fetch )();
 }
 
 esp_err_t unit_enviii_pressure_get( float *pressure )
 {
-    float *temp, zero_temp = 0.00;
-    temp = &zero_temp;
-    return _unit_enviii_qmp6988_get( pressure, temp );
+    unit_enviii_sample_t sample;
+
+    sample.channels = 0;
+    CHECK( _unit_enviii_pressure_read( &sample ) );
+    if ( !( sample.channels & UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_PRESSURE ) ) )
+        return ESP_ERR_NOT_SUPPORTED;
+
+    // 0.1 Pa to bar
+    *pressure = sample.value[ UNIT_ENVIII_CHANNEL_PRESSURE ] / 1000000.0f;
+
+    return ESP_OK;
 }
 
+#if UNIT_ENVIII_ALTITUDE
 esp_err_t unit_enviii_altitude_get( float *altitude )
+{
+    unit_enviii_sample_t sample;
+
+    sample.channels = 0;
+    CHECK( _unit_enviii_pressure_read( &sample ) );
+    if ( !( sample.channels & UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_PRESSURE ) ) )
+        return ESP_ERR_NOT_SUPPORTED;
+
+    // international standard atmosphere barometric formula
+    *altitude = 44330.0f * ( 1.0f - powf( ( float )sample.value[ UNIT_ENVIII_CHANNEL_PRESSURE ] / SEA_LEVEL_PRESSURE, 0.1903f ) );
+
+    return ESP_OK;
+}
+#endif
+
+#if PRESSURE_NONE
+static esp_err_t _unit_enviii_none_init( void )
 {
     return ESP_OK;
 }
 
-static esp_err_t unit_enviii_qmp6988_validate()
+static esp_err_t _unit_enviii_none_trigger( void )
 {
-    esp_err_t err = ESP_OK;
+    return ESP_OK;
+}
 
-    return err;
+static uint8_t _unit_enviii_none_duration_get( void )
+{
+    return 0;
 }
 
-static esp_err_t _unit_enviii_qmp6988_get( float *pressure, float *temperature )
+static esp_err_t _unit_enviii_none_fetch( void )
 {
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+static esp_err_t _unit_enviii_none_compensate( unit_enviii_sample_t *sample )
+{
+    return ESP_OK;
+}
+#endif
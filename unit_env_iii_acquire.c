@@ -0,0 +1,169 @@
+/*!
+ * @brief Multi-rate acquisition, each ENV III sensor sampled at its own cadence
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_timer.h>
+#include "unit_env_iii_acquire.h"
+#include "unit_env_iii_backend.h"
+#include "unit_env_iii_pipeline.h"
+#include "unit_env_iii_noheap.h"
+
+#define ACQUIRE_TICK_US     ( portTICK_PERIOD_MS * 1000LL )
+
+#define PRESSURE_NONE       ( !UNIT_ENVIII_BACKEND_QMP6988 && !UNIT_ENVIII_BACKEND_BMP280 )
+
+static void _unit_enviii_acquire_trigger( unit_enviii_acquire_t *acquire, unit_enviii_sensor_t sensor, int64_t now, esp_err_t *err );
+static TickType_t _unit_enviii_acquire_wait( const unit_enviii_acquire_t *acquire );
+
+esp_err_t unit_enviii_acquire_init( unit_enviii_acquire_t *acquire, uint32_t humidity_interval_ms, uint32_t pressure_interval_ms )
+{
+    if ( acquire == NULL )
+        return ESP_ERR_INVALID_ARG;
+#if PRESSURE_NONE
+    if ( pressure_interval_ms != 0 )
+        return ESP_ERR_NOT_SUPPORTED;
+#endif
+
+    int64_t now = esp_timer_get_time();
+
+    memset( acquire, 0, sizeof( unit_enviii_acquire_t ) );
+    acquire->interval_us[ UNIT_ENVIII_SENSOR_HUMIDITY ] = ( int64_t )humidity_interval_ms * 1000;
+    acquire->interval_us[ UNIT_ENVIII_SENSOR_PRESSURE ] = ( int64_t )pressure_interval_ms * 1000;
+    for ( uint8_t sensor = 0; sensor < UNIT_ENVIII_SENSOR_MAX; sensor++ )
+        acquire->next_us[ sensor ] = now;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_acquire_interval_set( unit_enviii_acquire_t *acquire, unit_enviii_sensor_t sensor, uint32_t interval_ms )
+{
+    if ( acquire == NULL || sensor >= UNIT_ENVIII_SENSOR_MAX )
+        return ESP_ERR_INVALID_ARG;
+#if PRESSURE_NONE
+    if ( sensor == UNIT_ENVIII_SENSOR_PRESSURE && interval_ms != 0 )
+        return ESP_ERR_NOT_SUPPORTED;
+#endif
+
+    acquire->interval_us[ sensor ] = ( int64_t )interval_ms * 1000;
+    acquire->next_us[ sensor ] = esp_timer_get_time() + acquire->interval_us[ sensor ];
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_acquire_poll( unit_enviii_acquire_t *acquire, unit_enviii_sample_t *sample, TickType_t *wait )
+{
+    if ( acquire == NULL || sample == NULL || wait == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err = ESP_ERR_NOT_FINISHED;
+    int64_t now = esp_timer_get_time();
+    int8_t ready = -1;
+
+    for ( uint8_t sensor = 0; sensor < UNIT_ENVIII_SENSOR_MAX; sensor++ )
+    {
+        if ( acquire->interval_us[ sensor ] != 0 && !acquire->pending[ sensor ] && now >= acquire->next_us[ sensor ] )
+            _unit_enviii_acquire_trigger( acquire, sensor, now, &err );
+
+        // oldest finished conversion first
+        if ( acquire->pending[ sensor ] && now >= acquire->ready_us[ sensor ] &&
+             ( ready < 0 || acquire->ready_us[ sensor ] < acquire->ready_us[ ready ] ) )
+            ready = sensor;
+    }
+
+    if ( ready >= 0 )
+    {
+        acquire->pending[ ready ] = false;
+        memset( sample, 0, sizeof( unit_enviii_sample_t ) );
+        sample->timestamp_us = unit_enviii_pipeline_timestamp_get();
+        err = unit_enviii_sensor_read( ( unit_enviii_sensor_t )ready, sample );
+        if ( err == ESP_OK )
+        {
+            acquire->stats[ ready ].samples++;
+            err = unit_enviii_pipeline_run( sample );
+        }
+        else
+            acquire->stats[ ready ].errors++;
+    }
+
+    *wait = _unit_enviii_acquire_wait( acquire );
+
+    return err;
+}
+
+esp_err_t unit_enviii_acquire_stats_get( const unit_enviii_acquire_t *acquire, unit_enviii_sensor_t sensor, unit_enviii_acquire_stats_t *stats )
+{
+    if ( acquire == NULL || sensor >= UNIT_ENVIII_SENSOR_MAX || stats == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    *stats = acquire->stats[ sensor ];
+
+    return ESP_OK;
+}
+
+static void _unit_enviii_acquire_trigger( unit_enviii_acquire_t *acquire, unit_enviii_sensor_t sensor, int64_t now, esp_err_t *err )
+{
+    int64_t interval_us = acquire->interval_us[ sensor ];
+    uint8_t duration = 0;
+
+    // stay on the cadence grid, slots missed by a late poll are dropped
+    acquire->next_us[ sensor ] += interval_us;
+    if ( acquire->next_us[ sensor ] <= now )
+    {
+        uint32_t missed = ( uint32_t )( ( now - acquire->next_us[ sensor ] ) / interval_us ) + 1;
+        acquire->next_us[ sensor ] += missed * interval_us;
+        acquire->stats[ sensor ].skipped += missed;
+    }
+
+    esp_err_t trigger = unit_enviii_sensor_trigger( sensor );
+    if ( trigger != ESP_OK )
+    {
+        acquire->stats[ sensor ].errors++;
+        *err = trigger;
+        return;
+    }
+
+    unit_enviii_sensor_duration_get( sensor, &duration );
+    acquire->ready_us[ sensor ] = now + duration * ACQUIRE_TICK_US;
+    acquire->pending[ sensor ] = true;
+}
+
+static TickType_t _unit_enviii_acquire_wait( const unit_enviii_acquire_t *acquire )
+{
+    int64_t now = esp_timer_get_time();
+    int64_t due = INT64_MAX;
+
+    for ( uint8_t sensor = 0; sensor < UNIT_ENVIII_SENSOR_MAX; sensor++ )
+    {
+        if ( acquire->pending[ sensor ] && acquire->ready_us[ sensor ] < due )
+            due = acquire->ready_us[ sensor ];
+        else if ( !acquire->pending[ sensor ] && acquire->interval_us[ sensor ] != 0 && acquire->next_us[ sensor ] < due )
+            due = acquire->next_us[ sensor ];
+    }
+
+    if ( due == INT64_MAX )
+        return portMAX_DELAY;
+    if ( due <= now )
+        return 0;
+
+    // round up so the task never wakes before the event is due
+    return ( TickType_t )( ( due - now + ACQUIRE_TICK_US - 1 ) / ACQUIRE_TICK_US );
+}
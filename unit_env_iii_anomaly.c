@@ -0,0 +1,138 @@
+/*!
+ * @brief Streaming fixed-point anomaly detection on ENV III sensor channels
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include "unit_env_iii_anomaly.h"
+#include "unit_env_iii_noheap.h"
+
+#define ANOMALY_MAX_SHIFT   16
+
+static const unit_enviii_anomaly_config_t _default_config[ UNIT_ENVIII_CHANNEL_MAX ] = {
+    [ UNIT_ENVIII_CHANNEL_TEMPERATURE ] = { .shift = 5, .z_x10 = 40, .min_stddev = 50, .cusum_k = 50, .cusum_h = 1000 },
+    [ UNIT_ENVIII_CHANNEL_HUMIDITY ] = { .shift = 5, .z_x10 = 40, .min_stddev = 200, .cusum_k = 200, .cusum_h = 4000 },
+    [ UNIT_ENVIII_CHANNEL_PRESSURE ] = { .shift = 5, .z_x10 = 40, .min_stddev = 20, .cusum_k = 20, .cusum_h = 500 }
+};
+
+esp_err_t unit_enviii_anomaly_init( unit_enviii_anomaly_t *detector, uint32_t channels, const unit_enviii_anomaly_config_t *config )
+{
+    if ( detector == NULL || ( channels & ~UNIT_ENVIII_CHANNEL_ALL ) )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( config == NULL )
+        config = _default_config;
+
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        if ( config[ channel ].shift > ANOMALY_MAX_SHIFT || config[ channel ].z_x10 == 0 || config[ channel ].min_stddev < 0 ||
+             config[ channel ].cusum_k < 0 || config[ channel ].cusum_h <= 0 )
+            return ESP_ERR_INVALID_ARG;
+    }
+
+    memset( detector, 0, sizeof( unit_enviii_anomaly_t ) );
+    detector->channels = channels;
+    memcpy( detector->config, config, sizeof( detector->config ) );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_anomaly_update( unit_enviii_anomaly_t *detector, unit_enviii_sample_t *sample )
+{
+    if ( detector == NULL || sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    uint32_t channels = detector->channels & sample->channels;
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        if ( !( channels & UNIT_ENVIII_CHANNEL_BIT( channel ) ) )
+            continue;
+
+        const unit_enviii_anomaly_config_t *config = &detector->config[ channel ];
+        unit_enviii_anomaly_state_t *state = &detector->state[ channel ];
+        int64_t value = ( int64_t )sample->value[ channel ] << 8;
+        uint32_t warmup = 1UL << config->shift;
+
+        if ( state->count == 0 )
+        {
+            state->mean = value;
+            state->variance = 0;
+            state->count = 1;
+            continue;
+        }
+
+        int64_t deviation = value - state->mean;
+        int64_t squared = deviation * deviation;
+
+        if ( state->count < warmup )
+        {
+            state->count++;
+            state->mean += deviation >> config->shift;
+            state->variance += ( squared - state->variance ) >> config->shift;
+            continue;
+        }
+
+        // z-score test without a square root: d^2 * 100 > z_x10^2 * var
+        int64_t floor = ( int64_t )config->min_stddev << 8;
+        int64_t variance = ( state->variance > floor * floor ) ? state->variance : floor * floor;
+        bool outlier = squared / ( ( int64_t )config->z_x10 * config->z_x10 ) > variance / 100;
+        if ( outlier )
+            sample->flags |= UNIT_ENVIII_SAMPLE_FLAG_OUTLIER( channel ) | UNIT_ENVIII_SAMPLE_FLAG_ANOMALY;
+
+        // two sided CUSUM against the mean before this sample, with each step
+        // clipped to half the threshold so a lone spike cannot trigger it
+        int64_t drift = ( int64_t )config->cusum_k << 8;
+        int64_t threshold = ( int64_t )config->cusum_h << 8;
+        int64_t step = deviation;
+        if ( step > threshold / 2 )
+            step = threshold / 2;
+        if ( step < -threshold / 2 )
+            step = -threshold / 2;
+        state->cusum_high = state->cusum_high + step - drift;
+        state->cusum_low = state->cusum_low - step - drift;
+        if ( state->cusum_high < 0 )
+            state->cusum_high = 0;
+        if ( state->cusum_low < 0 )
+            state->cusum_low = 0;
+
+        if ( state->cusum_high > threshold || state->cusum_low > threshold )
+        {
+            // accept the new level so it is reported once
+            sample->flags |= UNIT_ENVIII_SAMPLE_FLAG_CHANGE( channel ) | UNIT_ENVIII_SAMPLE_FLAG_ANOMALY;
+            state->cusum_high = 0;
+            state->cusum_low = 0;
+            state->mean = value;
+        }
+        else if ( !outlier )
+        {
+            // outliers are kept out of the statistics
+            state->mean += deviation >> config->shift;
+            state->variance += ( squared - state->variance ) >> config->shift;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_anomaly_stage_process( unit_enviii_sample_t *sample, void *context )
+{
+    return unit_enviii_anomaly_update( ( unit_enviii_anomaly_t * )context, sample );
+}
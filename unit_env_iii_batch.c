@@ -0,0 +1,451 @@
+/*!
+ * @brief Batching of ENV III samples for upload with backpressure
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_log.h>
+#include "freertos/task.h"
+#include "unit_env_iii_batch.h"
+#include "unit_env_iii_pipeline.h"
+#include "unit_env_iii_noheap.h"
+
+#if UNIT_ENVIII_ENCODERS
+
+/* version, count, base timestamp varint */
+#define BATCH_HEADER_MAX    12
+/* delta varint, channel byte, a varint per channel and the flags varint */
+#define BATCH_SAMPLE_MAX    ( 10 + 1 + 5 * UNIT_ENVIII_CHANNEL_MAX + 3 )
+#define BATCH_FLAGS_BIT     0x80
+
+#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
+
+static esp_err_t _unit_enviii_batch_publish( unit_enviii_batch_t *batch, TickType_t wait, bool force );
+static bool _unit_enviii_batch_due( unit_enviii_batch_t *batch, TickType_t *timeout );
+static uint16_t _unit_enviii_batch_encode( unit_enviii_batch_t *batch, size_t *length );
+static bool _unit_enviii_batch_append( unit_enviii_batch_t *batch, size_t *position, const uint8_t *data, size_t size );
+static void _unit_enviii_batch_drop_oldest( unit_enviii_batch_t *batch );
+static void _unit_enviii_batch_decimate( unit_enviii_batch_t *batch );
+static size_t _unit_enviii_batch_varint_put( uint8_t *buffer, uint64_t value );
+static bool _unit_enviii_batch_varint_get( const uint8_t *buffer, size_t length, size_t *position, uint64_t *value );
+static const char *_TAG = "UNIT_ENV_III_BATCH";
+
+#define ZIGZAG( x )     ( ( ( uint64_t )( x ) << 1 ) ^ ( uint64_t )( ( int64_t )( x ) >> 63 ) )
+#define UNZIGZAG( x )   ( ( int64_t )( ( x ) >> 1 ) ^ -( int64_t )( ( x ) & 1 ) )
+#define QUEUE_AT( batch, i )    ( &( batch )->queue[ ( ( batch )->head + ( i ) ) % UNIT_ENVIII_BATCH_CAPACITY ] )
+
+esp_err_t unit_enviii_batch_init( unit_enviii_batch_t *batch, const unit_enviii_batch_config_t *config )
+{
+    if ( batch == NULL || config == NULL || config->publish == NULL || config->max_samples == 0 ||
+         config->max_samples > UNIT_ENVIII_BATCH_CAPACITY || config->policy > UNIT_ENVIII_BATCH_DECIMATE )
+        return ESP_ERR_INVALID_ARG;
+
+    memset( batch, 0, sizeof( unit_enviii_batch_t ) );
+    batch->config = *config;
+    batch->lock = xSemaphoreCreateMutexStatic( &batch->lock_buffer );
+    batch->ready = xSemaphoreCreateBinaryStatic( &batch->ready_buffer );
+    batch->space = xSemaphoreCreateBinaryStatic( &batch->space_buffer );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_batch_stage_process( unit_enviii_sample_t *sample, void *context )
+{
+    unit_enviii_batch_t *batch = ( unit_enviii_batch_t * )context;
+
+    if ( sample == NULL || batch == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake( batch->lock, portMAX_DELAY );
+    if ( batch->count == UNIT_ENVIII_BATCH_CAPACITY )
+    {
+        switch ( batch->config.policy )
+        {
+        case UNIT_ENVIII_BATCH_BLOCK:
+            // published samples leave the queue and give space
+            while ( batch->count == UNIT_ENVIII_BATCH_CAPACITY )
+            {
+                xSemaphoreGive( batch->lock );
+                BaseType_t room = xSemaphoreTake( batch->space, batch->config.block_ticks );
+                xSemaphoreTake( batch->lock, portMAX_DELAY );
+                if ( room != pdTRUE )
+                    break;
+            }
+            break;
+        case UNIT_ENVIII_BATCH_DROP_OLDEST:
+            _unit_enviii_batch_drop_oldest( batch );
+            break;
+        case UNIT_ENVIII_BATCH_DECIMATE:
+            _unit_enviii_batch_decimate( batch );
+            break;
+        default:
+            break;
+        }
+    }
+
+    if ( batch->count == UNIT_ENVIII_BATCH_CAPACITY )
+    {
+        batch->stats.dropped++;
+        xSemaphoreGive( batch->lock );
+        ESP_LOGD( _TAG, "Queue full, sample dropped" );
+        return ESP_OK;
+    }
+
+    unit_enviii_batch_entry_t *entry = QUEUE_AT( batch, batch->count );
+    entry->timestamp_us = sample->timestamp_us;
+    memcpy( entry->value, sample->value, sizeof( entry->value ) );
+    entry->flags = ( uint16_t )sample->flags;
+    entry->channels = ( uint8_t )( sample->channels & UNIT_ENVIII_CHANNEL_ALL );
+    batch->count++;
+    if ( batch->count - batch->inflight >= batch->config.max_samples )
+        xSemaphoreGive( batch->ready );
+    xSemaphoreGive( batch->lock );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_batch_publish( unit_enviii_batch_t *batch, TickType_t wait )
+{
+    if ( batch == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    return _unit_enviii_batch_publish( batch, wait, false );
+}
+
+esp_err_t unit_enviii_batch_flush( unit_enviii_batch_t *batch )
+{
+    if ( batch == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    esp_err_t err = _unit_enviii_batch_publish( batch, 0, true );
+
+    return ( err == ESP_ERR_TIMEOUT ) ? ESP_OK : err;
+}
+
+esp_err_t unit_enviii_batch_stats_get( unit_enviii_batch_t *batch, unit_enviii_batch_stats_t *stats )
+{
+    if ( batch == NULL || stats == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake( batch->lock, portMAX_DELAY );
+    *stats = batch->stats;
+    xSemaphoreGive( batch->lock );
+
+    return ESP_OK;
+}
+
+/*
+ * Layout:
+ *  version u8, sample count u8, timestamp of the first sample in ms as an
+ *  unsigned LEB128 varint, then per sample
+ *  - milliseconds since the previous sample, zigzag varint, 0 for the first
+ *  - channel mask u8, bit 7 set when a flags varint follows the values
+ *  - per channel in the mask, zigzag varint of the change since the last
+ *    value of that channel in the batch, the value itself the first time
+ *  - the low 16 flag bits as a varint if bit 7 of the mask is set
+ */
+esp_err_t unit_enviii_batch_decode( const uint8_t *payload, size_t length, unit_enviii_sample_t *samples, size_t max, size_t *count )
+{
+    int32_t last[ UNIT_ENVIII_CHANNEL_MAX ] = { 0 };
+    uint32_t seen = 0;
+    uint64_t base_ms, delta, raw;
+    size_t position = 2;
+
+    if ( payload == NULL || samples == NULL || count == NULL )
+        return ESP_ERR_INVALID_ARG;
+    if ( length < 2 )
+        return ESP_ERR_INVALID_SIZE;
+    if ( payload[ 0 ] != UNIT_ENVIII_BATCH_VERSION )
+        return ESP_ERR_INVALID_VERSION;
+    if ( payload[ 1 ] > max )
+        return ESP_ERR_INVALID_SIZE;
+    if ( !_unit_enviii_batch_varint_get( payload, length, &position, &base_ms ) )
+        return ESP_ERR_INVALID_SIZE;
+
+    int64_t time_ms = ( int64_t )base_ms;
+    for ( uint8_t i = 0; i < payload[ 1 ]; i++ )
+    {
+        unit_enviii_sample_t *sample = &samples[ i ];
+
+        memset( sample, 0, sizeof( unit_enviii_sample_t ) );
+        if ( !_unit_enviii_batch_varint_get( payload, length, &position, &delta ) || position >= length )
+            return ESP_ERR_INVALID_SIZE;
+        time_ms += UNZIGZAG( delta );
+        sample->timestamp_us = time_ms * 1000;
+
+        uint8_t mask = payload[ position++ ];
+        sample->channels = mask & UNIT_ENVIII_CHANNEL_ALL;
+        for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+        {
+            if ( !( mask & UNIT_ENVIII_CHANNEL_BIT( channel ) ) )
+                continue;
+            if ( !_unit_enviii_batch_varint_get( payload, length, &position, &raw ) )
+                return ESP_ERR_INVALID_SIZE;
+            last[ channel ] = ( int32_t )( ( seen & UNIT_ENVIII_CHANNEL_BIT( channel ) ? last[ channel ] : 0 ) + UNZIGZAG( raw ) );
+            seen |= UNIT_ENVIII_CHANNEL_BIT( channel );
+            sample->value[ channel ] = last[ channel ];
+        }
+        if ( mask & BATCH_FLAGS_BIT )
+        {
+            if ( !_unit_enviii_batch_varint_get( payload, length, &position, &raw ) )
+                return ESP_ERR_INVALID_SIZE;
+            sample->flags = ( uint32_t )raw;
+        }
+    }
+    *count = payload[ 1 ];
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_batch_inflate( const uint8_t *payload, size_t length, uint8_t *out, size_t size, size_t *out_length )
+{
+    if ( payload == NULL || out == NULL || out_length == NULL )
+        return ESP_ERR_INVALID_ARG;
+    if ( length < 2 || size < 2 )
+        return ESP_ERR_INVALID_SIZE;
+
+    if ( !( payload[ 0 ] & UNIT_ENVIII_BATCH_COMPRESSED ) )
+    {
+        if ( length > size )
+            return ESP_ERR_INVALID_SIZE;
+        memcpy( out, payload, length );
+        *out_length = length;
+        return ESP_OK;
+    }
+
+    out[ 0 ] = payload[ 0 ] & ~UNIT_ENVIII_BATCH_COMPRESSED;
+    out[ 1 ] = payload[ 1 ];
+    CHECK( unit_enviii_lzss_decompress( payload + 2, length - 2, out + 2, size - 2, out_length ) );
+    *out_length += 2;
+
+    return ESP_OK;
+}
+
+static esp_err_t _unit_enviii_batch_publish( unit_enviii_batch_t *batch, TickType_t wait, bool force )
+{
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout;
+    size_t length;
+
+    for ( ;; )
+    {
+        xSemaphoreTake( batch->lock, portMAX_DELAY );
+        bool due = _unit_enviii_batch_due( batch, &timeout ) || ( force && batch->count > 0 );
+        if ( due )
+            break;
+        xSemaphoreGive( batch->lock );
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if ( wait != portMAX_DELAY && elapsed >= wait )
+            return ESP_ERR_TIMEOUT;
+        if ( wait != portMAX_DELAY && wait - elapsed < timeout )
+            timeout = wait - elapsed;
+        xSemaphoreTake( batch->ready, timeout );
+    }
+
+    // the samples stay queued while the callback runs, producers only drop newer ones
+    uint16_t samples = _unit_enviii_batch_encode( batch, &length );
+    batch->inflight = samples;
+    xSemaphoreGive( batch->lock );
+
+    esp_err_t err = batch->config.publish( batch->payload, length, samples, batch->config.user );
+
+    xSemaphoreTake( batch->lock, portMAX_DELAY );
+    if ( err == ESP_OK )
+    {
+        batch->head = ( batch->head + samples ) % UNIT_ENVIII_BATCH_CAPACITY;
+        batch->count -= samples;
+        batch->stats.batches++;
+        batch->stats.samples += samples;
+        batch->stats.bytes += length;
+    }
+    else
+    {
+        batch->stats.failures++;
+    }
+    batch->inflight = 0;
+    xSemaphoreGive( batch->lock );
+
+    if ( err == ESP_OK )
+        xSemaphoreGive( batch->space );
+    else
+        ESP_LOGW( _TAG, "Publishing %u samples failed, kept for the next attempt", samples );
+
+    return err;
+}
+
+/* Called with the lock held. Returns whether a batch is due, and otherwise
+ * how long until the oldest sample ages out */
+static bool _unit_enviii_batch_due( unit_enviii_batch_t *batch, TickType_t *timeout )
+{
+    *timeout = portMAX_DELAY;
+    if ( batch->count == 0 )
+        return false;
+    if ( batch->count >= batch->config.max_samples )
+        return true;
+    if ( batch->config.max_age_ms == 0 )
+        return false;
+
+    int64_t age_us = unit_enviii_pipeline_timestamp_get() - QUEUE_AT( batch, 0 )->timestamp_us;
+    int64_t left_us = ( int64_t )batch->config.max_age_ms * 1000 - age_us;
+    if ( left_us <= 0 )
+        return true;
+
+    *timeout = ( TickType_t )( ( left_us + portTICK_PERIOD_MS * 1000LL - 1 ) / ( portTICK_PERIOD_MS * 1000LL ) );
+
+    return false;
+}
+
+/* Called with the lock held. Encodes the oldest samples that fit into the payload */
+static uint16_t _unit_enviii_batch_encode( unit_enviii_batch_t *batch, size_t *length )
+{
+    uint8_t scratch[ BATCH_SAMPLE_MAX ];
+    int32_t last[ UNIT_ENVIII_CHANNEL_MAX ] = { 0 };
+    int64_t last_ms = QUEUE_AT( batch, 0 )->timestamp_us / 1000;
+    uint16_t limit = batch->count < batch->config.max_samples ? batch->count : batch->config.max_samples;
+    uint16_t samples = 0;
+    size_t position = 2;
+
+    if ( limit > UINT8_MAX )
+        limit = UINT8_MAX;
+
+    // version and count stay plain, the compressor writes everything after them
+    batch->payload[ 0 ] = UNIT_ENVIII_BATCH_VERSION | ( batch->config.compress ? UNIT_ENVIII_BATCH_COMPRESSED : 0 );
+    if ( batch->config.compress )
+        unit_enviii_lzss_init( &batch->lzss, batch->payload + 2, UNIT_ENVIII_BATCH_PAYLOAD_SIZE - 2 );
+    _unit_enviii_batch_append( batch, &position, scratch, _unit_enviii_batch_varint_put( scratch, ( uint64_t )last_ms ) );
+    for ( ; samples < limit; samples++ )
+    {
+        const unit_enviii_batch_entry_t *entry = QUEUE_AT( batch, samples );
+        int64_t time_ms = entry->timestamp_us / 1000;
+        size_t size = _unit_enviii_batch_varint_put( scratch, ZIGZAG( time_ms - last_ms ) );
+
+        scratch[ size++ ] = entry->channels | ( entry->flags ? BATCH_FLAGS_BIT : 0 );
+        for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+        {
+            if ( !( entry->channels & UNIT_ENVIII_CHANNEL_BIT( channel ) ) )
+                continue;
+            size += _unit_enviii_batch_varint_put( scratch + size, ZIGZAG( ( int64_t )entry->value[ channel ] - last[ channel ] ) );
+        }
+        if ( entry->flags )
+            size += _unit_enviii_batch_varint_put( scratch + size, entry->flags );
+
+        if ( !_unit_enviii_batch_append( batch, &position, scratch, size ) )
+            break;
+        last_ms = time_ms;
+        for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+        {
+            if ( entry->channels & UNIT_ENVIII_CHANNEL_BIT( channel ) )
+                last[ channel ] = entry->value[ channel ];
+        }
+    }
+    if ( batch->config.compress )
+    {
+        unit_enviii_lzss_finish( &batch->lzss, &position );
+        position += 2;
+    }
+    batch->payload[ 1 ] = ( uint8_t )samples;
+    *length = position;
+
+    return samples;
+}
+
+/* Called with the lock held. Adds the bytes of one sample to the payload if
+ * they are sure to fit, compressed or not */
+static bool _unit_enviii_batch_append( unit_enviii_batch_t *batch, size_t *position, const uint8_t *data, size_t size )
+{
+    if ( batch->config.compress )
+    {
+        if ( unit_enviii_lzss_bound( &batch->lzss, size ) > UNIT_ENVIII_BATCH_PAYLOAD_SIZE - 2 )
+            return false;
+        return unit_enviii_lzss_write( &batch->lzss, data, size ) == ESP_OK;
+    }
+
+    if ( *position + size > UNIT_ENVIII_BATCH_PAYLOAD_SIZE )
+        return false;
+    memcpy( batch->payload + *position, data, size );
+    *position += size;
+
+    return true;
+}
+
+/* Called with the lock held. Removes the oldest sample not being published */
+static void _unit_enviii_batch_drop_oldest( unit_enviii_batch_t *batch )
+{
+    if ( batch->count == batch->inflight )
+        return;
+
+    // move the samples being published up by one over the dropped one
+    for ( uint16_t i = batch->inflight; i > 0; i-- )
+        *QUEUE_AT( batch, i ) = *QUEUE_AT( batch, i - 1 );
+    batch->head = ( batch->head + 1 ) % UNIT_ENVIII_BATCH_CAPACITY;
+    batch->count--;
+    batch->stats.dropped++;
+}
+
+/* Called with the lock held. Keeps every other sample not being published */
+static void _unit_enviii_batch_decimate( unit_enviii_batch_t *batch )
+{
+    uint16_t kept = batch->inflight;
+
+    for ( uint16_t i = batch->inflight; i < batch->count; i++ )
+    {
+        if ( ( i - batch->inflight ) & 1 )
+            continue;
+        if ( kept != i )
+            *QUEUE_AT( batch, kept ) = *QUEUE_AT( batch, i );
+        kept++;
+    }
+    batch->stats.decimated += batch->count - kept;
+    batch->count = kept;
+}
+
+static size_t _unit_enviii_batch_varint_put( uint8_t *buffer, uint64_t value )
+{
+    size_t size = 0;
+
+    do
+    {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        buffer[ size++ ] = byte | ( value ? 0x80 : 0 );
+    } while ( value );
+
+    return size;
+}
+
+static bool _unit_enviii_batch_varint_get( const uint8_t *buffer, size_t length, size_t *position, uint64_t *value )
+{
+    uint8_t shift = 0, byte;
+
+    *value = 0;
+    do
+    {
+        if ( *position >= length || shift > 63 )
+            return false;
+        byte = buffer[ ( *position )++ ];
+        *value |= ( uint64_t )( byte & 0x7F ) << shift;
+        shift += 7;
+    } while ( byte & 0x80 );
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,180 @@
+/*!
+ * @brief BMP280 pressure backend of the ENV II and ENV IV units
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_log.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "i2cdev.h"
+#include "unit_env_iii_backend.h"
+#include "unit_env_iii_noheap.h"
+
+#if UNIT_ENVIII_BACKEND_BMP280
+
+#define BMP280_CHIP_ID              0x58
+#define BMP280_CHIP_ID_REG          0xD0
+#define BMP280_RESET_REG            0xE0
+#define BMP280_CTRLMEAS_REG         0xF4
+#define BMP280_CONFIG_REG           0xF5
+#define BMP280_PRESSURE_MSB_REG     0xF7
+#define BMP280_CALIBRATION_REG      0x88
+#define BMP280_CALIBRATION_LENGTH   24
+#define BMP280_RESET_CMD            0xB6
+#define BMP280_RESET_DURATION       3       /* ms */
+#define BMP280_RAW_DATA_SIZE        6
+
+/* Configured IIR filter and standby, temperature 1x as the compensation
+ * needs and configured pressure oversampling, normal mode */
+#define BMP280_CONFIG               ( ( UNIT_ENVIII_PRESSURE_STANDBY << 5 ) | ( UNIT_ENVIII_PRESSURE_FILTER << 2 ) )
+#define BMP280_CTRLMEAS             ( ( 0x01 << 5 ) | ( UNIT_ENVIII_PRESSURE_OVERSAMPLING << 2 ) | 0x03 )
+
+#define BMP280_CHANNELS             UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_PRESSURE )
+
+#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
+
+typedef struct
+{
+    uint16_t dig_T1;
+    int16_t dig_T2, dig_T3;
+    uint16_t dig_P1;
+    int16_t dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
+} bmp280_cali_data_t;
+
+static i2c_dev_t _dev;
+static bmp280_cali_data_t _cali;
+static uint8_t _raw_data[ BMP280_RAW_DATA_SIZE ];
+static const char *_TAG = "UNIT_ENV_III_BMP280";
+
+const unit_enviii_backend_t unit_enviii_backend_bmp280 = {
+    .name = "BMP280",
+    .channels = BMP280_CHANNELS,
+    .init = unit_enviii_bmp280_init,
+    .trigger = unit_enviii_bmp280_trigger,
+    .duration_get = unit_enviii_bmp280_duration_get,
+    .fetch = unit_enviii_bmp280_fetch,
+    .compensate = unit_enviii_bmp280_compensate
+};
+
+esp_err_t unit_enviii_bmp280_init( void )
+{
+    uint8_t value;
+    uint8_t cali[ BMP280_CALIBRATION_LENGTH ];
+
+    memset( &_dev, 0, sizeof( i2c_dev_t ) );
+    _dev.port = COMMON_I2C_EXTERNAL;
+    _dev.addr = UNIT_ENVIII_BMP280_I2C_ADDR;
+    _dev.cfg.sda_io_num = PORT_A_SDA_PIN;
+    _dev.cfg.scl_io_num = PORT_A_SCL_PIN;
+    _dev.cfg.master.clk_speed = UNIT_ENVIII_I2C_FREQ_HZ;
+    CHECK( i2c_dev_create_mutex( &_dev ) );
+    ESP_LOGD( _TAG, "Setting BMP280 initial device descriptor success" );
+
+    CHECK( i2c_dev_read_reg( &_dev, BMP280_CHIP_ID_REG, &value, 1 ) );
+    if ( value != BMP280_CHIP_ID )
+    {
+        ESP_LOGE( _TAG, "Unexpected BMP280 chip id 0x%02x", value );
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    value = BMP280_RESET_CMD;
+    CHECK( i2c_dev_write_reg( &_dev, BMP280_RESET_REG, &value, 1 ) );
+    vTaskDelay( pdMS_TO_TICKS( BMP280_RESET_DURATION ) + 1 );
+
+    // calibration words are little endian
+    CHECK( i2c_dev_read_reg( &_dev, BMP280_CALIBRATION_REG, cali, BMP280_CALIBRATION_LENGTH ) );
+    _cali.dig_T1 = ( uint16_t )( cali[ 1 ] << 8 | cali[ 0 ] );
+    _cali.dig_T2 = ( int16_t )( cali[ 3 ] << 8 | cali[ 2 ] );
+    _cali.dig_T3 = ( int16_t )( cali[ 5 ] << 8 | cali[ 4 ] );
+    _cali.dig_P1 = ( uint16_t )( cali[ 7 ] << 8 | cali[ 6 ] );
+    _cali.dig_P2 = ( int16_t )( cali[ 9 ] << 8 | cali[ 8 ] );
+    _cali.dig_P3 = ( int16_t )( cali[ 11 ] << 8 | cali[ 10 ] );
+    _cali.dig_P4 = ( int16_t )( cali[ 13 ] << 8 | cali[ 12 ] );
+    _cali.dig_P5 = ( int16_t )( cali[ 15 ] << 8 | cali[ 14 ] );
+    _cali.dig_P6 = ( int16_t )( cali[ 17 ] << 8 | cali[ 16 ] );
+    _cali.dig_P7 = ( int16_t )( cali[ 19 ] << 8 | cali[ 18 ] );
+    _cali.dig_P8 = ( int16_t )( cali[ 21 ] << 8 | cali[ 20 ] );
+    _cali.dig_P9 = ( int16_t )( cali[ 23 ] << 8 | cali[ 22 ] );
+
+    value = BMP280_CONFIG;
+    CHECK( i2c_dev_write_reg( &_dev, BMP280_CONFIG_REG, &value, 1 ) );
+    value = BMP280_CTRLMEAS;
+    CHECK( i2c_dev_write_reg( &_dev, BMP280_CTRLMEAS_REG, &value, 1 ) );
+    ESP_LOGD( _TAG, "Initializing BMP280 sensor success" );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_bmp280_trigger( void )
+{
+    // normal mode converts continuously
+    return ESP_OK;
+}
+
+uint8_t unit_enviii_bmp280_duration_get( void )
+{
+    return 0;
+}
+
+esp_err_t unit_enviii_bmp280_fetch( void )
+{
+    return i2c_dev_read_reg( &_dev, BMP280_PRESSURE_MSB_REG, _raw_data, BMP280_RAW_DATA_SIZE );
+}
+
+UNIT_ENVIII_HOT_ATTR esp_err_t unit_enviii_bmp280_compensate( unit_enviii_sample_t *sample )
+{
+    return unit_enviii_bmp280_decode( _raw_data, sample );
+}
+
+/* Integer compensation from the BMP280 datasheet, section 8.2 */
+UNIT_ENVIII_HOT_ATTR esp_err_t unit_enviii_bmp280_decode( const uint8_t *raw, unit_enviii_sample_t *sample )
+{
+    if ( raw == NULL || sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    int32_t adc_p = ( int32_t )( ( ( uint32_t )raw[ 0 ] << 12 ) | ( raw[ 1 ] << 4 ) | ( raw[ 2 ] >> 4 ) );
+    int32_t adc_t = ( int32_t )( ( ( uint32_t )raw[ 3 ] << 12 ) | ( raw[ 4 ] << 4 ) | ( raw[ 5 ] >> 4 ) );
+    int32_t t1 = _cali.dig_T1;
+
+    int32_t var1 = ( ( ( adc_t >> 3 ) - t1 * 2 ) * _cali.dig_T2 ) >> 11;
+    int32_t var2 = ( ( ( ( adc_t >> 4 ) - t1 ) * ( ( adc_t >> 4 ) - t1 ) >> 12 ) * _cali.dig_T3 ) >> 14;
+    int64_t fine = ( int64_t )var1 + var2 - 128000;
+
+    int64_t p2 = fine * fine * _cali.dig_P6 + fine * _cali.dig_P5 * 131072 + ( int64_t )_cali.dig_P4 * 34359738368LL;
+    int64_t p1 = ( ( fine * fine * _cali.dig_P3 ) >> 8 ) + fine * _cali.dig_P2 * 4096;
+    p1 = ( ( 140737488355328LL + p1 ) * _cali.dig_P1 ) >> 33;
+    if ( p1 == 0 )
+        return ESP_ERR_INVALID_RESPONSE;
+
+    int64_t p = 1048576 - adc_p;
+    p = ( ( p * 2147483648LL - p2 ) * 3125 ) / p1;
+    int64_t p9 = ( ( int64_t )_cali.dig_P9 * ( p >> 13 ) * ( p >> 13 ) ) >> 25;
+    int64_t p8 = ( ( int64_t )_cali.dig_P8 * p ) >> 19;
+    p = ( ( p + p9 + p8 ) >> 8 ) + ( int64_t )_cali.dig_P7 * 16;
+
+    // Pa in Q24.8 to 0.1 Pa
+    sample->value[ UNIT_ENVIII_CHANNEL_PRESSURE ] = ( int32_t )( ( p * 10 + 128 ) / 256 );
+    sample->channels |= BMP280_CHANNELS;
+
+    return ESP_OK;
+}
+
+#endif
@@ -0,0 +1,339 @@
+/*!
+ * @brief Port A bus scheduler shared by the ENV unit and co-resident I2C drivers
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include "unit_env_iii_bus.h"
+#include "unit_env_iii_noheap.h"
+
+/* The submitting tasks queue their transactions in one list. The task that
+ * finds the bus free leads: it runs transactions in priority order, including
+ * short ones of other tasks, and hands the bus to the owner of the next
+ * transaction once that one is long or the batch budget is used up. */
+
+#define BUS_STATE_PENDING   0
+#define BUS_STATE_LEADING   1
+#define BUS_STATE_RUNNING   2
+#define BUS_STATE_DONE      3
+
+#if UNIT_ENVIII_INSTRUMENTATION
+#define BUS_STAT(x)         ( x )
+#else
+#define BUS_STAT(x)         do { } while ( 0 )
+#endif
+
+static bool _unit_enviii_bus_eligible( unit_enviii_bus_transaction_t *transaction, int64_t now );
+static uint32_t _unit_enviii_bus_rank( const unit_enviii_bus_transaction_t *transaction, int64_t now );
+static unit_enviii_bus_transaction_t *_unit_enviii_bus_pick( int64_t now );
+static void _unit_enviii_bus_remove( unit_enviii_bus_transaction_t *transaction );
+static void _unit_enviii_bus_lead( unit_enviii_bus_transaction_t *self );
+static portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+static unit_enviii_bus_transaction_t *_pending;
+static bool _busy;
+static int64_t _reserved_us;
+static int64_t _stats_since_us;
+static unit_enviii_bus_stats_t _stats;
+static const char *_TAG = "UNIT_ENV_III_BUS";
+
+esp_err_t unit_enviii_bus_submit( unit_enviii_bus_transaction_t *transaction, TickType_t timeout )
+{
+    uint8_t taken = 0;
+
+    if ( transaction == NULL || transaction->run == NULL || transaction->priority >= UNIT_ENVIII_BUS_PRIORITY_MAX )
+        return ESP_ERR_INVALID_ARG;
+
+    transaction->next = NULL;
+    // a semaphore of its own leaves the notifications of the calling task alone
+    transaction->wake = xSemaphoreCreateCountingStatic( UINT8_MAX, 0, &transaction->wake_buffer );
+    transaction->signals = 0;
+    transaction->queued_us = esp_timer_get_time();
+    transaction->state = BUS_STATE_PENDING;
+    transaction->deferred = false;
+    transaction->result = ESP_OK;
+
+    TickType_t start = xTaskGetTickCount();
+
+    portENTER_CRITICAL( &_lock );
+    unit_enviii_bus_transaction_t **tail = &_pending;
+    while ( *tail != NULL )
+        tail = &( *tail )->next;
+    *tail = transaction;
+    if ( !_busy )
+    {
+        _busy = true;
+        transaction->state = BUS_STATE_LEADING;
+    }
+    portEXIT_CRITICAL( &_lock );
+
+    for ( ;; )
+    {
+        if ( transaction->state == BUS_STATE_LEADING )
+            _unit_enviii_bus_lead( transaction );
+
+        portENTER_CRITICAL( &_lock );
+        uint8_t state = transaction->state;
+        uint8_t signals = transaction->signals;
+        int64_t reserved = _reserved_us;
+        portEXIT_CRITICAL( &_lock );
+
+        if ( state == BUS_STATE_DONE )
+        {
+            // the leader touches wake until its give returns, so wait for every give announced
+            while ( taken < signals )
+            {
+                xSemaphoreTake( transaction->wake, portMAX_DELAY );
+                taken++;
+            }
+            return transaction->result;
+        }
+        if ( state == BUS_STATE_LEADING )
+            continue;
+
+        TickType_t wait = portMAX_DELAY;
+        // once another task runs the transaction it can no longer be withdrawn
+        if ( state == BUS_STATE_PENDING )
+        {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if ( timeout != portMAX_DELAY )
+                wait = elapsed < timeout ? timeout - elapsed : 0;
+
+            // a held background transaction has to look again once the reservation lapses
+            if ( transaction->priority == UNIT_ENVIII_BUS_PRIORITY_BACKGROUND && reserved != 0 )
+            {
+                int64_t lapse_us = reserved + UNIT_ENVIII_BUS_RESERVE_HOLD_US - esp_timer_get_time();
+                TickType_t lapse = lapse_us > 0 ? pdMS_TO_TICKS( lapse_us / 1000 ) + 1 : 1;
+                if ( lapse < wait )
+                    wait = lapse;
+            }
+        }
+
+        if ( wait > 0 && xSemaphoreTake( transaction->wake, wait ) == pdTRUE )
+            taken++;
+
+        portENTER_CRITICAL( &_lock );
+        if ( transaction->state == BUS_STATE_PENDING )
+        {
+            if ( !_busy )
+            {
+                _busy = true;
+                transaction->state = BUS_STATE_LEADING;
+            }
+            else if ( timeout != portMAX_DELAY && xTaskGetTickCount() - start >= timeout )
+            {
+                // out of the queue no further give is announced, but a hand off that raced
+                // the wait may still be inside its give, so drain it as on completion
+                _unit_enviii_bus_remove( transaction );
+                BUS_STAT( _stats.timeouts++ );
+                signals = transaction->signals;
+                portEXIT_CRITICAL( &_lock );
+                while ( taken < signals )
+                {
+                    xSemaphoreTake( transaction->wake, portMAX_DELAY );
+                    taken++;
+                }
+                ESP_LOGW( _TAG, "%s timed out waiting for the bus", transaction->name );
+                return ESP_ERR_TIMEOUT;
+            }
+        }
+        portEXIT_CRITICAL( &_lock );
+    }
+}
+
+esp_err_t unit_enviii_bus_reserve( uint32_t in_us )
+{
+    int64_t at = esp_timer_get_time() + in_us;
+
+    portENTER_CRITICAL( &_lock );
+    if ( _reserved_us == 0 || at < _reserved_us )
+        _reserved_us = at;
+    portEXIT_CRITICAL( &_lock );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_bus_stats_get( unit_enviii_bus_stats_t *stats )
+{
+    if ( stats == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+#if UNIT_ENVIII_INSTRUMENTATION
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL( &_lock );
+    *stats = _stats;
+    portEXIT_CRITICAL( &_lock );
+
+    stats->elapsed_us = now - _stats_since_us;
+    stats->utilization = stats->elapsed_us > 0 ? ( uint16_t )( stats->busy_us * 1000 / ( uint64_t )stats->elapsed_us ) : 0;
+
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t unit_enviii_bus_stats_reset( void )
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL( &_lock );
+    memset( &_stats, 0, sizeof( unit_enviii_bus_stats_t ) );
+    _stats_since_us = now;
+    portEXIT_CRITICAL( &_lock );
+
+    return ESP_OK;
+}
+
+/* Called with the lock held */
+static bool _unit_enviii_bus_eligible( unit_enviii_bus_transaction_t *transaction, int64_t now )
+{
+    if ( transaction->priority != UNIT_ENVIII_BUS_PRIORITY_BACKGROUND || _reserved_us == 0 )
+        return true;
+    if ( now + transaction->duration_us <= _reserved_us )
+        return true;
+
+    if ( !transaction->deferred )
+    {
+        transaction->deferred = true;
+        BUS_STAT( _stats.deferred++ );
+    }
+
+    return false;
+}
+
+/* Priority raised by one level per aging period spent waiting */
+static uint32_t _unit_enviii_bus_rank( const unit_enviii_bus_transaction_t *transaction, int64_t now )
+{
+    int64_t aged = ( now - transaction->queued_us ) / UNIT_ENVIII_BUS_AGING_US;
+
+    return transaction->priority + ( uint32_t )( aged < UNIT_ENVIII_BUS_PRIORITY_MAX ? aged : UNIT_ENVIII_BUS_PRIORITY_MAX );
+}
+
+/* Called with the lock held, highest rank first and submission order within a rank */
+static unit_enviii_bus_transaction_t *_unit_enviii_bus_pick( int64_t now )
+{
+    unit_enviii_bus_transaction_t *best = NULL;
+    uint32_t best_rank = 0;
+
+    if ( _reserved_us != 0 && now >= _reserved_us + UNIT_ENVIII_BUS_RESERVE_HOLD_US )
+        _reserved_us = 0;
+
+    for ( unit_enviii_bus_transaction_t *it = _pending; it != NULL; it = it->next )
+    {
+        uint32_t rank = _unit_enviii_bus_rank( it, now );
+        if ( ( best == NULL || rank > best_rank ) && _unit_enviii_bus_eligible( it, now ) )
+        {
+            best = it;
+            best_rank = rank;
+        }
+    }
+
+    return best;
+}
+
+/* Called with the lock held */
+static void _unit_enviii_bus_remove( unit_enviii_bus_transaction_t *transaction )
+{
+    for ( unit_enviii_bus_transaction_t **it = &_pending; *it != NULL; it = &( *it )->next )
+    {
+        if ( *it == transaction )
+        {
+            *it = transaction->next;
+            transaction->next = NULL;
+            return;
+        }
+    }
+}
+
+static void _unit_enviii_bus_lead( unit_enviii_bus_transaction_t *self )
+{
+    int64_t batch_start = esp_timer_get_time();
+
+    portENTER_CRITICAL( &_lock );
+    for ( ;; )
+    {
+        int64_t now = esp_timer_get_time();
+        unit_enviii_bus_transaction_t *transaction = _unit_enviii_bus_pick( now );
+
+        // nothing runnable, held background transactions take over once their reservation lapses
+        if ( transaction == NULL )
+        {
+            if ( self->state == BUS_STATE_LEADING )
+                self->state = BUS_STATE_PENDING;
+            _busy = false;
+            portEXIT_CRITICAL( &_lock );
+            return;
+        }
+
+        bool own = ( transaction == self );
+        if ( !own && ( transaction->duration_us > UNIT_ENVIII_BUS_SHORT_US || now - batch_start >= UNIT_ENVIII_BUS_BATCH_US ) )
+        {
+            if ( self->state == BUS_STATE_LEADING )
+                self->state = BUS_STATE_PENDING;
+            transaction->state = BUS_STATE_LEADING;
+            transaction->signals++;
+            BUS_STAT( _stats.handoffs++ );
+            SemaphoreHandle_t wake = transaction->wake;
+            portEXIT_CRITICAL( &_lock );
+            xSemaphoreGive( wake );
+            return;
+        }
+
+        _unit_enviii_bus_remove( transaction );
+        if ( transaction->priority != UNIT_ENVIII_BUS_PRIORITY_BACKGROUND && _reserved_us != 0 && now >= _reserved_us )
+            _reserved_us = 0;
+        transaction->state = BUS_STATE_RUNNING;
+        portEXIT_CRITICAL( &_lock );
+
+#if UNIT_ENVIII_INSTRUMENTATION
+        int64_t begin = esp_timer_get_time();
+        esp_err_t err = transaction->run( transaction->context );
+        int64_t end = esp_timer_get_time();
+
+        portENTER_CRITICAL( &_lock );
+        uint32_t waited = ( uint32_t )( begin - transaction->queued_us );
+        _stats.busy_us += end - begin;
+        _stats.transactions[ transaction->priority ]++;
+        _stats.wait_total_us[ transaction->priority ] += waited;
+        if ( waited > _stats.wait_max_us[ transaction->priority ] )
+            _stats.wait_max_us[ transaction->priority ] = waited;
+        if ( !own )
+            _stats.batched++;
+#else
+        esp_err_t err = transaction->run( transaction->context );
+
+        portENTER_CRITICAL( &_lock );
+#endif
+        transaction->result = err;
+        transaction->state = BUS_STATE_DONE;
+
+        if ( !own )
+        {
+            transaction->signals++;
+            SemaphoreHandle_t wake = transaction->wake;
+            portEXIT_CRITICAL( &_lock );
+            xSemaphoreGive( wake );
+            portENTER_CRITICAL( &_lock );
+        }
+    }
+}
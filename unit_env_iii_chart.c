@@ -0,0 +1,168 @@
+/*!
+ * @brief Incremental per-pixel-column chart feed for ENV III history on the Core2 display
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include "unit_env_iii_chart.h"
+#include "unit_env_iii_pack.h"
+#include "unit_env_iii_noheap.h"
+
+#if UNIT_ENVIII_HISTORY
+
+static void _unit_enviii_chart_column_clear( unit_enviii_chart_column_t *column );
+static void _unit_enviii_chart_add( unit_enviii_chart_t *chart, int64_t timestamp_us, int32_t min, int32_t max, int32_t last );
+
+static void _unit_enviii_chart_column_clear( unit_enviii_chart_column_t *column )
+{
+    column->min = INT32_MAX;
+    column->max = INT32_MIN;
+    column->last = 0;
+}
+
+static void _unit_enviii_chart_add( unit_enviii_chart_t *chart, int64_t timestamp_us, int32_t min, int32_t max, int32_t last )
+{
+    if ( chart->origin_us == INT64_MIN )
+    {
+        // first sample lands in the rightmost column
+        int64_t aligned = timestamp_us - ( ( timestamp_us % chart->column_us ) + chart->column_us ) % chart->column_us;
+        chart->origin_us = aligned - ( int64_t )( chart->width - 1 ) * chart->column_us;
+    }
+
+    if ( timestamp_us < chart->origin_us )
+        return;
+
+    int64_t x = ( timestamp_us - chart->origin_us ) / chart->column_us;
+    if ( x >= chart->width )
+    {
+        int64_t shift = x - ( chart->width - 1 );
+        if ( shift >= chart->width )
+        {
+            for ( uint16_t i = 0; i < chart->width; i++ )
+                _unit_enviii_chart_column_clear( &chart->column[ i ] );
+            chart->head = 0;
+        }
+        else
+        {
+            for ( int64_t i = 0; i < shift; i++ )
+            {
+                _unit_enviii_chart_column_clear( &chart->column[ chart->head ] );
+                chart->head = ( chart->head + 1 ) % chart->width;
+            }
+        }
+        chart->origin_us += shift * chart->column_us;
+        x = chart->width - 1;
+    }
+
+    unit_enviii_chart_column_t *column = &chart->column[ ( chart->head + x ) % chart->width ];
+    if ( min < column->min )
+        column->min = min;
+    if ( max > column->max )
+        column->max = max;
+    column->last = last;
+}
+
+esp_err_t unit_enviii_chart_init( unit_enviii_chart_t *chart, unit_enviii_channel_t channel, uint16_t width, uint32_t window_ms )
+{
+    if ( chart == NULL || channel >= UNIT_ENVIII_CHANNEL_MAX || width == 0 || width > UNIT_ENVIII_CHART_MAX_WIDTH || window_ms < width )
+        return ESP_ERR_INVALID_ARG;
+
+    memset( chart, 0, sizeof( unit_enviii_chart_t ) );
+    chart->channel = channel;
+    chart->width = width;
+    chart->column_us = ( int64_t )window_ms * 1000 / width;
+    chart->origin_us = INT64_MIN;
+    for ( uint16_t i = 0; i < width; i++ )
+        _unit_enviii_chart_column_clear( &chart->column[ i ] );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_chart_update( unit_enviii_chart_t *chart, const unit_enviii_sample_t *sample )
+{
+    if ( chart == NULL || sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( !( sample->channels & UNIT_ENVIII_CHANNEL_BIT( chart->channel ) ) )
+        return ESP_OK;
+
+    int32_t value = sample->value[ chart->channel ];
+    _unit_enviii_chart_add( chart, sample->timestamp_us, value, value, value );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_chart_history_load( unit_enviii_chart_t *chart, const unit_enviii_history_t *history )
+{
+    unit_enviii_history_bucket_t bucket;
+    int64_t start_us;
+
+    if ( chart == NULL || history == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    for ( uint16_t i = 0; i < history->count; i++ )
+    {
+        unit_enviii_history_bucket_get( history, i, &bucket, &start_us );
+        if ( !( bucket.channels & UNIT_ENVIII_CHANNEL_BIT( chart->channel ) ) )
+            continue;
+
+        int32_t min, max;
+        switch ( chart->channel )
+        {
+            case UNIT_ENVIII_CHANNEL_TEMPERATURE:
+                min = unit_enviii_unpack_temperature( bucket.temperature_min );
+                max = unit_enviii_unpack_temperature( bucket.temperature_max );
+                break;
+            case UNIT_ENVIII_CHANNEL_HUMIDITY:
+                min = unit_enviii_unpack_humidity( bucket.humidity_min );
+                max = unit_enviii_unpack_humidity( bucket.humidity_max );
+                break;
+            default:
+                min = ( int32_t )bucket.pressure_min;
+                max = ( int32_t )bucket.pressure_max;
+                break;
+        }
+        // a merged bucket keeps only its extremes, its last value is known only if they are equal
+        _unit_enviii_chart_add( chart, start_us + ( int64_t )bucket.span_ms * 1000, min, max, min == max ? min : UNIT_ENVIII_CHART_NO_LAST );
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_chart_column_get( const unit_enviii_chart_t *chart, uint16_t x, unit_enviii_chart_column_t *column )
+{
+    if ( chart == NULL || column == NULL || x >= chart->width )
+        return ESP_ERR_INVALID_ARG;
+
+    const unit_enviii_chart_column_t *stored = &chart->column[ ( chart->head + x ) % chart->width ];
+    if ( stored->min > stored->max )
+        return ESP_ERR_NOT_FOUND;
+
+    *column = *stored;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_chart_stage_process( unit_enviii_sample_t *sample, void *context )
+{
+    return unit_enviii_chart_update( ( unit_enviii_chart_t * )context, sample );
+}
+
+#endif
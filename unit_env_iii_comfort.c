@@ -0,0 +1,177 @@
+/*!
+ * @brief Thermal comfort classification of ENV III samples from a precomputed lookup grid
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <math.h>
+#include <string.h>
+#include "unit_env_iii_comfort.h"
+#include "unit_env_iii_noheap.h"
+
+#define COMFORT_AIR_SPEED       0.1f        /* m/s */
+#define COMFORT_ATMOSPHERE      101325.0f   /* Pa */
+#define COMFORT_HUMIDITY_RATIO  0.012f      /* kg/kg */
+#define COMFORT_DRY_LIMIT       30.0f       /* percent RH */
+
+static uint8_t _unit_enviii_comfort_zone( float temperature, float clo );
+static uint8_t _unit_enviii_comfort_pmv( float temperature, float humidity, float clo, float met );
+
+static uint8_t _unit_enviii_comfort_zone( float temperature, float clo )
+{
+    // zone of 20-24 degree Celsius at 1.0 clo and 23.5-27 at 0.5 clo, linear in between
+    float weight = ( clo - 0.5f ) / 0.5f;
+    if ( weight < 0.0f )
+        weight = 0.0f;
+    if ( weight > 1.0f )
+        weight = 1.0f;
+    float lower = 23.5f - 3.5f * weight;
+    float upper = 27.0f - 3.0f * weight;
+
+    if ( temperature < lower - 4.0f )
+        return UNIT_ENVIII_COMFORT_COLD;
+    if ( temperature < lower - 2.0f )
+        return UNIT_ENVIII_COMFORT_COOL;
+    if ( temperature < lower )
+        return UNIT_ENVIII_COMFORT_SLIGHTLY_COOL;
+    if ( temperature <= upper )
+        return UNIT_ENVIII_COMFORT_NEUTRAL;
+    if ( temperature <= upper + 2.0f )
+        return UNIT_ENVIII_COMFORT_SLIGHTLY_WARM;
+    if ( temperature <= upper + 4.0f )
+        return UNIT_ENVIII_COMFORT_WARM;
+
+    return UNIT_ENVIII_COMFORT_HOT;
+}
+
+/* ISO 7730 annex D, with radiant temperature equal to air temperature and no external work */
+static uint8_t _unit_enviii_comfort_pmv( float temperature, float humidity, float clo, float met )
+{
+    float pa = humidity * 10.0f * expf( 16.6536f - 4030.183f / ( temperature + 235.0f ) );
+    float icl = 0.155f * clo;
+    float m = met * 58.15f;
+    float fcl = ( icl <= 0.078f ) ? 1.0f + 1.29f * icl : 1.05f + 0.645f * icl;
+    float hcf = 12.1f * sqrtf( COMFORT_AIR_SPEED );
+    float taa = temperature + 273.0f;
+    float tcla = taa + ( 35.5f - temperature ) / ( 3.5f * icl + 0.1f );
+    float p1 = icl * fcl;
+    float p2 = p1 * 3.96f;
+    float p3 = p1 * 100.0f;
+    float p4 = p1 * taa;
+    float p5 = 308.7f - 0.028f * m + p2 * powf( taa / 100.0f, 4.0f );
+    float xn = tcla / 100.0f;
+    float xf = tcla / 50.0f;
+    float hc = hcf;
+
+    for ( int n = 0; n < 150 && fabsf( xn - xf ) > 0.00015f; n++ )
+    {
+        xf = ( xf + xn ) / 2.0f;
+        float hcn = 2.38f * powf( fabsf( 100.0f * xf - taa ), 0.25f );
+        hc = ( hcf > hcn ) ? hcf : hcn;
+        xn = ( p5 + p4 * hc - p2 * powf( xf, 4.0f ) ) / ( 100.0f + p3 * hc );
+    }
+
+    float tcl = 100.0f * xn - 273.0f;
+    float hl1 = 3.05e-3f * ( 5733.0f - 6.99f * m - pa );
+    float hl2 = ( m > 58.15f ) ? 0.42f * ( m - 58.15f ) : 0.0f;
+    float hl3 = 1.7e-5f * m * ( 5867.0f - pa );
+    float hl4 = 0.0014f * m * ( 34.0f - temperature );
+    float hl5 = 3.96f * fcl * ( powf( xn, 4.0f ) - powf( taa / 100.0f, 4.0f ) );
+    float hl6 = fcl * hc * ( tcl - temperature );
+    float ts = 0.303f * expf( -0.036f * m ) + 0.028f;
+    float pmv = ts * ( m - hl1 - hl2 - hl3 - hl4 - hl5 - hl6 );
+
+    if ( pmv < -2.5f )
+        return UNIT_ENVIII_COMFORT_COLD;
+    if ( pmv < -1.5f )
+        return UNIT_ENVIII_COMFORT_COOL;
+    if ( pmv < -0.5f )
+        return UNIT_ENVIII_COMFORT_SLIGHTLY_COOL;
+    if ( pmv <= 0.5f )
+        return UNIT_ENVIII_COMFORT_NEUTRAL;
+    if ( pmv <= 1.5f )
+        return UNIT_ENVIII_COMFORT_SLIGHTLY_WARM;
+    if ( pmv <= 2.5f )
+        return UNIT_ENVIII_COMFORT_WARM;
+
+    return UNIT_ENVIII_COMFORT_HOT;
+}
+
+esp_err_t unit_enviii_comfort_init( unit_enviii_comfort_t *comfort, unit_enviii_comfort_model_t model, float clo, float met )
+{
+    if ( comfort == NULL || model > UNIT_ENVIII_COMFORT_MODEL_PMV || !( clo >= 0.0f && clo <= 2.0f ) || !( met >= 0.8f && met <= 4.0f ) )
+        return ESP_ERR_INVALID_ARG;
+
+    for ( uint8_t h = 0; h < UNIT_ENVIII_COMFORT_HUMIDITY_POINTS; h++ )
+    {
+        float humidity = h * ( UNIT_ENVIII_COMFORT_HUMIDITY_STEP / 1000.0f );
+
+        for ( uint8_t t = 0; t < UNIT_ENVIII_COMFORT_TEMPERATURE_POINTS; t++ )
+        {
+            float temperature = ( UNIT_ENVIII_COMFORT_TEMPERATURE_MIN + t * UNIT_ENVIII_COMFORT_TEMPERATURE_STEP ) / 1000.0f;
+            uint8_t class = ( model == UNIT_ENVIII_COMFORT_MODEL_PMV ) ?
+                            _unit_enviii_comfort_pmv( temperature, humidity, clo, met ) :
+                            _unit_enviii_comfort_zone( temperature, clo );
+
+            // humidity ratio from the Magnus vapour pressure
+            float vapour = humidity / 100.0f * 611.2f * expf( 17.62f * temperature / ( 243.12f + temperature ) );
+            if ( 0.622f * vapour / ( COMFORT_ATMOSPHERE - vapour ) > COMFORT_HUMIDITY_RATIO )
+                class |= UNIT_ENVIII_COMFORT_HUMID;
+            if ( humidity < COMFORT_DRY_LIMIT )
+                class |= UNIT_ENVIII_COMFORT_DRY;
+
+            comfort->grid[ h ][ t ] = class;
+        }
+    }
+
+    return ESP_OK;
+}
+
+uint8_t unit_enviii_comfort_classify( const unit_enviii_comfort_t *comfort, int32_t temperature, int32_t humidity )
+{
+    int32_t t = ( temperature - UNIT_ENVIII_COMFORT_TEMPERATURE_MIN + UNIT_ENVIII_COMFORT_TEMPERATURE_STEP / 2 ) / UNIT_ENVIII_COMFORT_TEMPERATURE_STEP;
+    int32_t h = ( humidity + UNIT_ENVIII_COMFORT_HUMIDITY_STEP / 2 ) / UNIT_ENVIII_COMFORT_HUMIDITY_STEP;
+
+    if ( temperature < UNIT_ENVIII_COMFORT_TEMPERATURE_MIN || t < 0 )
+        t = 0;
+    if ( t >= UNIT_ENVIII_COMFORT_TEMPERATURE_POINTS )
+        t = UNIT_ENVIII_COMFORT_TEMPERATURE_POINTS - 1;
+    if ( humidity < 0 || h < 0 )
+        h = 0;
+    if ( h >= UNIT_ENVIII_COMFORT_HUMIDITY_POINTS )
+        h = UNIT_ENVIII_COMFORT_HUMIDITY_POINTS - 1;
+
+    return comfort->grid[ h ][ t ];
+}
+
+esp_err_t unit_enviii_comfort_stage_process( unit_enviii_sample_t *sample, void *context )
+{
+    const uint32_t needed = UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_TEMPERATURE ) |
+                            UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_HUMIDITY );
+    const unit_enviii_comfort_t *comfort = ( const unit_enviii_comfort_t * )context;
+
+    if ( sample == NULL || comfort == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( ( sample->channels & needed ) == needed )
+        sample->derived.comfort = unit_enviii_comfort_classify( comfort, sample->value[ UNIT_ENVIII_CHANNEL_TEMPERATURE ],
+                                                                sample->value[ UNIT_ENVIII_CHANNEL_HUMIDITY ] );
+
+    return ESP_OK;
+}
@@ -0,0 +1,212 @@
+/*!
+ * @brief Streaming CSV and NDJSON export of the ENV III history
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_timer.h>
+#include "unit_env_iii_export.h"
+#include "unit_env_iii_pack.h"
+#include "unit_env_iii_noheap.h"
+
+#if UNIT_ENVIII_HISTORY && UNIT_ENVIII_ENCODERS
+
+/* longest record, a NDJSON line with every field at its widest */
+#define EXPORT_MAX_RECORD   240
+
+#define EXPORT_CSV_HEADER   "timestamp_ms,span_ms,samples,temperature_min,temperature_max," \
+                            "humidity_min,humidity_max,pressure_min,pressure_max\n"
+
+_Static_assert( UNIT_ENVIII_EXPORT_CHUNK_SIZE >= EXPORT_MAX_RECORD, "Export chunk smaller than a record" );
+
+static char *_unit_enviii_export_str( char *out, const char *str );
+static char *_unit_enviii_export_u64( char *out, uint64_t value );
+static char *_unit_enviii_export_fixed( char *out, int32_t value, uint8_t decimals );
+static char *_unit_enviii_export_field( char *out, unit_enviii_export_format_t format, const char *key, bool valid, int32_t value, uint8_t decimals );
+static size_t _unit_enviii_export_record( const unit_enviii_export_t *exporter, char *out );
+static esp_err_t _unit_enviii_export_flush( unit_enviii_export_t *exporter, unit_enviii_export_write_t write, void *user );
+
+static char *_unit_enviii_export_str( char *out, const char *str )
+{
+    while ( *str )
+        *out++ = *str++;
+
+    return out;
+}
+
+static char *_unit_enviii_export_u64( char *out, uint64_t value )
+{
+    char digits[ 20 ];
+    uint8_t count = 0;
+
+    do
+    {
+        digits[ count++ ] = '0' + ( value % 10 );
+        value /= 10;
+    } while ( value );
+
+    while ( count )
+        *out++ = digits[ --count ];
+
+    return out;
+}
+
+static char *_unit_enviii_export_fixed( char *out, int32_t value, uint8_t decimals )
+{
+    uint32_t scale = 1;
+    uint32_t magnitude = ( value < 0 ) ? ( uint32_t )( -( int64_t )value ) : ( uint32_t )value;
+
+    for ( uint8_t i = 0; i < decimals; i++ )
+        scale *= 10;
+
+    if ( value < 0 )
+        *out++ = '-';
+    out = _unit_enviii_export_u64( out, magnitude / scale );
+    if ( decimals )
+    {
+        uint32_t fraction = magnitude % scale;
+        *out++ = '.';
+        for ( uint32_t digit = scale / 10; digit; digit /= 10 )
+        {
+            *out++ = '0' + ( fraction / digit );
+            fraction %= digit;
+        }
+    }
+
+    return out;
+}
+
+static char *_unit_enviii_export_field( char *out, unit_enviii_export_format_t format, const char *key, bool valid, int32_t value, uint8_t decimals )
+{
+    if ( format == UNIT_ENVIII_EXPORT_CSV )
+    {
+        *out++ = ',';
+        return valid ? _unit_enviii_export_fixed( out, value, decimals ) : out;
+    }
+
+    out = _unit_enviii_export_str( out, ",\"" );
+    out = _unit_enviii_export_str( out, key );
+    out = _unit_enviii_export_str( out, "\":" );
+
+    return valid ? _unit_enviii_export_fixed( out, value, decimals ) : _unit_enviii_export_str( out, "null" );
+}
+
+static size_t _unit_enviii_export_record( const unit_enviii_export_t *exporter, char *out )
+{
+    unit_enviii_history_bucket_t bucket;
+    int64_t start_us;
+    char *begin = out;
+    unit_enviii_export_format_t format = exporter->format;
+
+    unit_enviii_history_bucket_get( exporter->history, exporter->cursor, &bucket, &start_us );
+
+    bool temperature = bucket.channels & UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_TEMPERATURE );
+    bool humidity = bucket.channels & UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_HUMIDITY );
+    bool pressure = bucket.channels & UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_PRESSURE );
+
+    // temperature in degree Celsius, humidity in percent, pressure in hPa
+    if ( format == UNIT_ENVIII_EXPORT_NDJSON )
+        out = _unit_enviii_export_str( out, "{\"timestamp_ms\":" );
+    out = _unit_enviii_export_u64( out, ( uint64_t )( start_us < 0 ? 0 : start_us / 1000 ) );
+    out = _unit_enviii_export_field( out, format, "span_ms", true, ( int32_t )( bucket.span_ms > INT32_MAX ? INT32_MAX : bucket.span_ms ), 0 );
+    out = _unit_enviii_export_field( out, format, "samples", true, bucket.samples, 0 );
+    out = _unit_enviii_export_field( out, format, "temperature_min", temperature, bucket.temperature_min, 2 );
+    out = _unit_enviii_export_field( out, format, "temperature_max", temperature, bucket.temperature_max, 2 );
+    out = _unit_enviii_export_field( out, format, "humidity_min", humidity, unit_enviii_unpack_humidity( bucket.humidity_min ), 3 );
+    out = _unit_enviii_export_field( out, format, "humidity_max", humidity, unit_enviii_unpack_humidity( bucket.humidity_max ), 3 );
+    out = _unit_enviii_export_field( out, format, "pressure_min", pressure, ( int32_t )bucket.pressure_min, 3 );
+    out = _unit_enviii_export_field( out, format, "pressure_max", pressure, ( int32_t )bucket.pressure_max, 3 );
+    if ( format == UNIT_ENVIII_EXPORT_NDJSON )
+        *out++ = '}';
+    *out++ = '\n';
+
+    return out - begin;
+}
+
+static esp_err_t _unit_enviii_export_flush( unit_enviii_export_t *exporter, unit_enviii_export_write_t write, void *user )
+{
+    if ( exporter->fill == 0 )
+        return ESP_OK;
+
+    esp_err_t err = write( exporter->chunk, exporter->fill, user );
+    if ( err != ESP_OK )
+        return err;
+
+    exporter->bytes += exporter->fill;
+    exporter->fill = 0;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_export_begin( unit_enviii_export_t *exporter, const unit_enviii_history_t *history, unit_enviii_export_format_t format )
+{
+    if ( exporter == NULL || history == NULL || format > UNIT_ENVIII_EXPORT_NDJSON )
+        return ESP_ERR_INVALID_ARG;
+
+    memset( exporter, 0, sizeof( unit_enviii_export_t ) );
+    exporter->history = history;
+    exporter->format = format;
+    exporter->header_done = ( format != UNIT_ENVIII_EXPORT_CSV );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_export_step( unit_enviii_export_t *exporter, unit_enviii_export_write_t write, void *user )
+{
+    if ( exporter == NULL || exporter->history == NULL || write == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    int64_t start = esp_timer_get_time();
+
+    if ( !exporter->header_done )
+    {
+        char *end = _unit_enviii_export_str( exporter->chunk + exporter->fill, EXPORT_CSV_HEADER );
+        exporter->fill = end - exporter->chunk;
+        exporter->header_done = true;
+    }
+
+    while ( exporter->cursor < exporter->history->count && UNIT_ENVIII_EXPORT_CHUNK_SIZE - exporter->fill >= EXPORT_MAX_RECORD )
+    {
+        exporter->fill += _unit_enviii_export_record( exporter, exporter->chunk + exporter->fill );
+        exporter->cursor++;
+        exporter->records++;
+    }
+
+    esp_err_t err = _unit_enviii_export_flush( exporter, write, user );
+    exporter->elapsed_us += esp_timer_get_time() - start;
+    if ( err != ESP_OK )
+        return err;
+
+    return ( exporter->cursor < exporter->history->count ) ? ESP_ERR_NOT_FINISHED : ESP_OK;
+}
+
+esp_err_t unit_enviii_export_run( unit_enviii_export_t *exporter, unit_enviii_export_write_t write, void *user )
+{
+    esp_err_t err;
+
+    do
+    {
+        err = unit_enviii_export_step( exporter, write, user );
+    } while ( err == ESP_ERR_NOT_FINISHED );
+
+    return err;
+}
+
+#endif
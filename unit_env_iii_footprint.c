@@ -0,0 +1,91 @@
+/*!
+ * @brief Memory footprint report of the ENV III driver handles
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <esp_log.h>
+#include "unit_env_iii_footprint.h"
+#include "unit_env_iii_acquire.h"
+#include "unit_env_iii_anomaly.h"
+#include "unit_env_iii_batch.h"
+#include "unit_env_iii_backend.h"
+#include "unit_env_iii_bus.h"
+#include "unit_env_iii_chart.h"
+#include "unit_env_iii_comfort.h"
+#include "unit_env_iii_export.h"
+#include "unit_env_iii_history.h"
+#include "unit_env_iii_lzss.h"
+#include "unit_env_iii_median.h"
+#include "unit_env_iii_mold.h"
+#include "unit_env_iii_pack.h"
+#include "unit_env_iii_pipeline.h"
+#include "unit_env_iii_report.h"
+#include "unit_env_iii_resample.h"
+#include "unit_env_iii_rules.h"
+#include "unit_env_iii_sketch.h"
+#include "unit_env_iii_noheap.h"
+
+#if UNIT_ENVIII_INSTRUMENTATION
+
+#define FOOTPRINT_ENTRY( type ) { #type, sizeof( type ) }
+
+static const unit_enviii_footprint_entry_t _entries[] = {
+    FOOTPRINT_ENTRY( unit_enviii_sample_t ),
+    FOOTPRINT_ENTRY( unit_enviii_bus_transaction_t ),
+    FOOTPRINT_ENTRY( unit_enviii_acquire_t ),
+    FOOTPRINT_ENTRY( unit_enviii_median_stage_t ),
+    FOOTPRINT_ENTRY( unit_enviii_rules_t ),
+    FOOTPRINT_ENTRY( unit_enviii_anomaly_t ),
+    FOOTPRINT_ENTRY( unit_enviii_mold_t ),
+    FOOTPRINT_ENTRY( unit_enviii_comfort_t ),
+    FOOTPRINT_ENTRY( unit_enviii_sketch_stage_t ),
+    FOOTPRINT_ENTRY( unit_enviii_resample_t ),
+    FOOTPRINT_ENTRY( unit_enviii_report_t ),
+    FOOTPRINT_ENTRY( unit_enviii_pack_block_t ),
+    FOOTPRINT_ENTRY( unit_enviii_history_t ),
+    FOOTPRINT_ENTRY( unit_enviii_history_bucket_t ),
+    FOOTPRINT_ENTRY( unit_enviii_chart_t ),
+    FOOTPRINT_ENTRY( unit_enviii_export_t ),
+    FOOTPRINT_ENTRY( unit_enviii_batch_t ),
+    FOOTPRINT_ENTRY( unit_enviii_lzss_t ),
+    { "pipeline RTC snapshot", UNIT_ENVIII_PIPELINE_RTC_SNAPSHOT_SIZE }
+};
+static const char *_TAG = "UNIT_ENV_III_FOOTPRINT";
+
+esp_err_t unit_enviii_footprint_get( const unit_enviii_footprint_entry_t **entries, size_t *count )
+{
+    if ( entries == NULL || count == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    *entries = _entries;
+    *count = sizeof( _entries ) / sizeof( _entries[ 0 ] );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_footprint_log( void )
+{
+    for ( size_t i = 0; i < sizeof( _entries ) / sizeof( _entries[ 0 ] ); i++ )
+        ESP_LOGI( _TAG, "%-32s %6u bytes", _entries[ i ].name, ( unsigned )_entries[ i ].size );
+
+    return ESP_OK;
+}
+
+#endif
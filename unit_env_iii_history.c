@@ -0,0 +1,253 @@
+/*!
+ * @brief Memory-budgeted ENV III sample history with automatic downsampling
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_log.h>
+#include "unit_env_iii_history.h"
+#include "unit_env_iii_pack.h"
+#include "unit_env_iii_noheap.h"
+
+#if UNIT_ENVIII_HISTORY
+
+#define HISTORY_MIN_BUCKETS 4
+
+static void _unit_enviii_history_merge( unit_enviii_history_bucket_t *into, const unit_enviii_history_bucket_t *from );
+static void _unit_enviii_history_compact( unit_enviii_history_t *history );
+static void _unit_enviii_history_rebase( unit_enviii_history_t *history, int64_t timestamp_us );
+static const char *_TAG = "UNIT_ENV_III_HISTORY";
+
+esp_err_t unit_enviii_history_init( unit_enviii_history_t *history, void *buffer, size_t budget )
+{
+    if ( history == NULL || buffer == NULL || ( ( uintptr_t )buffer & 3 ) )
+        return ESP_ERR_INVALID_ARG;
+
+    size_t capacity = budget / sizeof( unit_enviii_history_bucket_t );
+    if ( capacity < HISTORY_MIN_BUCKETS )
+    {
+        ESP_LOGE( _TAG, "Budget of %u bytes holds less than %u buckets", ( unsigned )budget, HISTORY_MIN_BUCKETS );
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if ( capacity > UINT16_MAX )
+        capacity = UINT16_MAX;
+
+    memset( history, 0, sizeof( unit_enviii_history_t ) );
+    history->buckets = ( unit_enviii_history_bucket_t * )buffer;
+    history->capacity = ( uint16_t )capacity;
+    history->per_level = UNIT_ENVIII_HISTORY_BUCKETS_PER_LEVEL;
+    if ( history->per_level > history->capacity / 2 )
+        history->per_level = history->capacity / 2;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_history_append( unit_enviii_history_t *history, const unit_enviii_sample_t *sample )
+{
+    if ( history == NULL || sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( history->count == 0 )
+    {
+        history->epoch_us = sample->timestamp_us;
+    }
+    else
+    {
+        const unit_enviii_history_bucket_t *newest = &history->buckets[ history->count - 1 ];
+        if ( sample->timestamp_us < history->epoch_us + ( int64_t )( newest->start_ms + newest->span_ms ) * 1000 )
+            return ESP_ERR_INVALID_ARG;
+    }
+
+    if ( ( sample->timestamp_us - history->epoch_us ) / 1000 > UINT32_MAX )
+        _unit_enviii_history_rebase( history, sample->timestamp_us );
+
+    if ( history->count == history->capacity )
+        _unit_enviii_history_compact( history );
+
+    unit_enviii_history_bucket_t *bucket = &history->buckets[ history->count++ ];
+    uint32_t pressure = unit_enviii_pack_pressure( sample->value[ UNIT_ENVIII_CHANNEL_PRESSURE ] );
+
+    memset( bucket, 0, sizeof( unit_enviii_history_bucket_t ) );
+    bucket->start_ms = ( uint32_t )( ( sample->timestamp_us - history->epoch_us ) / 1000 );
+    bucket->temperature_min = bucket->temperature_max = unit_enviii_pack_temperature( sample->value[ UNIT_ENVIII_CHANNEL_TEMPERATURE ] );
+    bucket->humidity_min = bucket->humidity_max = unit_enviii_pack_humidity( sample->value[ UNIT_ENVIII_CHANNEL_HUMIDITY ] );
+    bucket->pressure_min = bucket->pressure_max = pressure;
+    bucket->samples = 1;
+    bucket->channels = sample->channels & UNIT_ENVIII_CHANNEL_ALL;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_history_bucket_get( const unit_enviii_history_t *history, uint16_t index, unit_enviii_history_bucket_t *bucket, int64_t *start_us )
+{
+    if ( history == NULL || bucket == NULL || index >= history->count )
+        return ESP_ERR_INVALID_ARG;
+
+    *bucket = history->buckets[ index ];
+    if ( start_us != NULL )
+        *start_us = history->epoch_us + ( int64_t )bucket->start_ms * 1000;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_history_stage_process( unit_enviii_sample_t *sample, void *context )
+{
+    return unit_enviii_history_append( ( unit_enviii_history_t * )context, sample );
+}
+
+static void _unit_enviii_history_merge( unit_enviii_history_bucket_t *into, const unit_enviii_history_bucket_t *from )
+{
+    uint8_t only_from = from->channels & ~into->channels;
+    uint8_t both = from->channels & into->channels;
+
+    if ( only_from & UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_TEMPERATURE ) )
+    {
+        into->temperature_min = from->temperature_min;
+        into->temperature_max = from->temperature_max;
+    }
+    else if ( both & UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_TEMPERATURE ) )
+    {
+        if ( from->temperature_min < into->temperature_min )
+            into->temperature_min = from->temperature_min;
+        if ( from->temperature_max > into->temperature_max )
+            into->temperature_max = from->temperature_max;
+    }
+
+    if ( only_from & UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_HUMIDITY ) )
+    {
+        into->humidity_min = from->humidity_min;
+        into->humidity_max = from->humidity_max;
+    }
+    else if ( both & UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_HUMIDITY ) )
+    {
+        if ( from->humidity_min < into->humidity_min )
+            into->humidity_min = from->humidity_min;
+        if ( from->humidity_max > into->humidity_max )
+            into->humidity_max = from->humidity_max;
+    }
+
+    if ( only_from & UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_PRESSURE ) )
+    {
+        into->pressure_min = from->pressure_min;
+        into->pressure_max = from->pressure_max;
+    }
+    else if ( both & UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_PRESSURE ) )
+    {
+        if ( from->pressure_min < into->pressure_min )
+            into->pressure_min = from->pressure_min;
+        if ( from->pressure_max > into->pressure_max )
+            into->pressure_max = from->pressure_max;
+    }
+
+    into->span_ms = from->start_ms + from->span_ms - into->start_ms;
+    into->samples = ( into->samples > UINT16_MAX - from->samples ) ? UINT16_MAX : into->samples + from->samples;
+    into->channels |= from->channels;
+    into->level++;
+}
+
+/*
+ * Levels only decrease from oldest to newest, so every level is a contiguous
+ * run. The finest level holding more than per_level buckets, or else the most
+ * populated one, is merged pairwise in a single pass, freeing half of its slots.
+ */
+static void _unit_enviii_history_compact( unit_enviii_history_t *history )
+{
+    unit_enviii_history_bucket_t *buckets = history->buckets;
+    uint16_t best_start = 0, best_len = 0;
+    uint16_t target_start = 0, target_len = 0;
+    uint16_t start = 0;
+
+    while ( start < history->count )
+    {
+        uint16_t end = start + 1;
+        while ( end < history->count && buckets[ end ].level == buckets[ start ].level )
+            end++;
+
+        uint16_t len = end - start;
+        if ( len > history->per_level )
+        {
+            // runs are scanned from coarse to fine, keep the finest
+            target_start = start;
+            target_len = len;
+        }
+        if ( len >= best_len )
+        {
+            best_start = start;
+            best_len = len;
+        }
+        start = end;
+    }
+
+    if ( target_len == 0 )
+    {
+        target_start = best_start;
+        target_len = best_len;
+    }
+    if ( target_len < 2 )
+    {
+        // every level holds a single bucket, fold the two oldest together
+        target_start = 0;
+        target_len = 2;
+    }
+
+    uint16_t write = target_start;
+    uint16_t read = target_start;
+    while ( read + 1 < target_start + target_len )
+    {
+        buckets[ write ] = buckets[ read ];
+        _unit_enviii_history_merge( &buckets[ write ], &buckets[ read + 1 ] );
+        write++;
+        read += 2;
+    }
+    memmove( &buckets[ write ], &buckets[ read ], ( history->count - read ) * sizeof( unit_enviii_history_bucket_t ) );
+    history->count -= read - write;
+}
+
+static void _unit_enviii_history_rebase( unit_enviii_history_t *history, int64_t timestamp_us )
+{
+    // drop the buckets falling out of the UINT32_MAX ms horizon, then move
+    // the epoch to the oldest remaining one
+    int64_t offset_ms = ( timestamp_us - history->epoch_us ) / 1000;
+    int64_t needed_ms = offset_ms - UINT32_MAX;
+    uint16_t drop = 0;
+
+    while ( drop < history->count && history->buckets[ drop ].start_ms < needed_ms )
+        drop++;
+
+    if ( drop > 0 )
+    {
+        ESP_LOGW( _TAG, "Dropping %u buckets older than the history horizon", drop );
+        memmove( &history->buckets[ 0 ], &history->buckets[ drop ], ( history->count - drop ) * sizeof( unit_enviii_history_bucket_t ) );
+        history->count -= drop;
+    }
+
+    if ( history->count == 0 )
+    {
+        history->epoch_us = timestamp_us;
+        return;
+    }
+
+    uint32_t shift_ms = history->buckets[ 0 ].start_ms;
+    for ( uint16_t i = 0; i < history->count; i++ )
+        history->buckets[ i ].start_ms -= shift_ms;
+    history->epoch_us += ( int64_t )shift_ms * 1000;
+}
+
+#endif
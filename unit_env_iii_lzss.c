@@ -0,0 +1,221 @@
+/*!
+ * @brief Small footprint LZSS compression of encoded payloads
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include "unit_env_iii_lzss.h"
+#include "unit_env_iii_config.h"
+#include "unit_env_iii_noheap.h"
+
+#if UNIT_ENVIII_ENCODERS
+
+/*
+ * Tokens are packed most significant bit first:
+ *  - literal: 1, then the byte
+ *  - match: 0, distance - 1 in WINDOW_BITS, length - MIN_MATCH in LENGTH_BITS
+ * A match may overlap the bytes it produces, so runs cost one token. The
+ * last byte is padded with zero bits, fewer than a literal needs.
+ */
+#define LZSS_LITERAL_BITS   9
+#define LZSS_MATCH_BITS     ( 1 + UNIT_ENVIII_LZSS_WINDOW_BITS + UNIT_ENVIII_LZSS_LENGTH_BITS )
+#define LZSS_WINDOW_MASK    ( UNIT_ENVIII_LZSS_WINDOW - 1 )
+
+static esp_err_t _unit_enviii_lzss_token( unit_enviii_lzss_t *lzss );
+static esp_err_t _unit_enviii_lzss_bits_put( unit_enviii_lzss_t *lzss, uint32_t value, uint8_t count );
+static uint8_t _unit_enviii_lzss_byte_get( const unit_enviii_lzss_t *lzss, uint16_t distance, uint8_t index );
+
+esp_err_t unit_enviii_lzss_init( unit_enviii_lzss_t *lzss, uint8_t *out, size_t size )
+{
+    if ( lzss == NULL || out == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    memset( lzss, 0, sizeof( unit_enviii_lzss_t ) );
+    lzss->out = out;
+    lzss->size = size;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_lzss_write( unit_enviii_lzss_t *lzss, const uint8_t *data, size_t length )
+{
+    if ( lzss == NULL || ( data == NULL && length > 0 ) )
+        return ESP_ERR_INVALID_ARG;
+
+    for ( size_t i = 0; i < length; i++ )
+    {
+        lzss->lookahead[ lzss->pending++ ] = data[ i ];
+        if ( lzss->pending == UNIT_ENVIII_LZSS_MAX_MATCH )
+        {
+            esp_err_t err = _unit_enviii_lzss_token( lzss );
+            if ( err != ESP_OK )
+                return err;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_lzss_finish( unit_enviii_lzss_t *lzss, size_t *length )
+{
+    esp_err_t err;
+
+    if ( lzss == NULL || length == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    while ( lzss->pending > 0 )
+    {
+        if ( ( err = _unit_enviii_lzss_token( lzss ) ) != ESP_OK )
+            return err;
+    }
+    if ( lzss->bit_count > 0 )
+    {
+        if ( ( err = _unit_enviii_lzss_bits_put( lzss, 0, 8 - lzss->bit_count ) ) != ESP_OK )
+            return err;
+    }
+    *length = lzss->length;
+
+    return ESP_OK;
+}
+
+size_t unit_enviii_lzss_bound( const unit_enviii_lzss_t *lzss, size_t length )
+{
+    if ( lzss == NULL )
+        return 0;
+
+    return lzss->length + ( lzss->bit_count + LZSS_LITERAL_BITS * ( lzss->pending + length ) + 7 ) / 8;
+}
+
+esp_err_t unit_enviii_lzss_decompress( const uint8_t *in, size_t in_length, uint8_t *out, size_t size, size_t *length )
+{
+    size_t bit = 0, written = 0;
+    size_t total = in_length * 8;
+
+    if ( in == NULL || out == NULL || length == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    // padding is shorter than any token
+    while ( total - bit >= LZSS_LITERAL_BITS )
+    {
+        bool literal = ( in[ bit / 8 ] >> ( 7 - bit % 8 ) ) & 1;
+        uint8_t count = literal ? 8 : UNIT_ENVIII_LZSS_WINDOW_BITS + UNIT_ENVIII_LZSS_LENGTH_BITS;
+        uint32_t value = 0;
+
+        if ( !literal && total - bit < LZSS_MATCH_BITS )
+            break;
+        bit++;
+        for ( uint8_t i = 0; i < count; i++, bit++ )
+            value = ( value << 1 ) | ( ( in[ bit / 8 ] >> ( 7 - bit % 8 ) ) & 1 );
+
+        if ( literal )
+        {
+            if ( written == size )
+                return ESP_ERR_INVALID_SIZE;
+            out[ written++ ] = ( uint8_t )value;
+            continue;
+        }
+
+        size_t distance = ( value >> UNIT_ENVIII_LZSS_LENGTH_BITS ) + 1;
+        size_t match = ( value & ( ( 1 << UNIT_ENVIII_LZSS_LENGTH_BITS ) - 1 ) ) + UNIT_ENVIII_LZSS_MIN_MATCH;
+        if ( distance > written )
+            return ESP_FAIL;
+        if ( match > size - written )
+            return ESP_ERR_INVALID_SIZE;
+        // byte by byte so overlapping matches repeat
+        for ( size_t i = 0; i < match; i++, written++ )
+            out[ written ] = out[ written - distance ];
+    }
+    *length = written;
+
+    return ESP_OK;
+}
+
+/* Emits the longest match for the start of the lookahead, or a literal */
+static esp_err_t _unit_enviii_lzss_token( unit_enviii_lzss_t *lzss )
+{
+    uint16_t best_distance = 0;
+    uint8_t best = 0;
+    esp_err_t err;
+
+    for ( uint16_t distance = 1; distance <= lzss->filled && best < lzss->pending; distance++ )
+    {
+        uint8_t match = 0;
+        while ( match < lzss->pending && _unit_enviii_lzss_byte_get( lzss, distance, match ) == lzss->lookahead[ match ] )
+            match++;
+        if ( match > best )
+        {
+            best = match;
+            best_distance = distance;
+        }
+    }
+
+    if ( best >= UNIT_ENVIII_LZSS_MIN_MATCH )
+    {
+        err = _unit_enviii_lzss_bits_put( lzss, ( ( uint32_t )( best_distance - 1 ) << UNIT_ENVIII_LZSS_LENGTH_BITS ) | ( best - UNIT_ENVIII_LZSS_MIN_MATCH ),
+                                          LZSS_MATCH_BITS );
+    }
+    else
+    {
+        best = 1;
+        err = _unit_enviii_lzss_bits_put( lzss, 0x100 | lzss->lookahead[ 0 ], LZSS_LITERAL_BITS );
+    }
+    if ( err != ESP_OK )
+        return err;
+
+    for ( uint8_t i = 0; i < best; i++ )
+    {
+        lzss->window[ lzss->head ] = lzss->lookahead[ i ];
+        lzss->head = ( lzss->head + 1 ) & LZSS_WINDOW_MASK;
+    }
+    if ( lzss->filled < UNIT_ENVIII_LZSS_WINDOW )
+        lzss->filled = ( lzss->filled + best < UNIT_ENVIII_LZSS_WINDOW ) ? lzss->filled + best : UNIT_ENVIII_LZSS_WINDOW;
+    lzss->pending -= best;
+    memmove( lzss->lookahead, lzss->lookahead + best, lzss->pending );
+
+    return ESP_OK;
+}
+
+static esp_err_t _unit_enviii_lzss_bits_put( unit_enviii_lzss_t *lzss, uint32_t value, uint8_t count )
+{
+    lzss->bits = ( lzss->bits << count ) | value;
+    lzss->bit_count += count;
+    while ( lzss->bit_count >= 8 )
+    {
+        if ( lzss->length == lzss->size )
+            return ESP_ERR_NO_MEM;
+        lzss->bit_count -= 8;
+        lzss->out[ lzss->length++ ] = ( uint8_t )( lzss->bits >> lzss->bit_count );
+    }
+    lzss->bits &= ( 1UL << lzss->bit_count ) - 1;
+
+    return ESP_OK;
+}
+
+/* Byte at index of a match starting distance bytes back, running on into
+ * the lookahead when the match overlaps it */
+static uint8_t _unit_enviii_lzss_byte_get( const unit_enviii_lzss_t *lzss, uint16_t distance, uint8_t index )
+{
+    if ( index < distance )
+        return lzss->window[ ( lzss->head - distance + index ) & LZSS_WINDOW_MASK ];
+
+    return lzss->lookahead[ index - distance ];
+}
+
+#endif
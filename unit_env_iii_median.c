@@ -0,0 +1,179 @@
+/*!
+ * @brief Streaming median-of-N filter for the ENV III unit sensor channels
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "unit_env_iii_median.h"
+#include "unit_env_iii_noheap.h"
+
+// heap positions of slots in the upper heap carry this flag in the index
+#define MEDIAN_UPPER    0x80
+
+_Static_assert( UNIT_ENVIII_MEDIAN_MAX_WINDOW < MEDIAN_UPPER, "Median window too large for the heap index" );
+
+static inline bool _unit_enviii_median_above( const unit_enviii_median_t *filter, bool upper, uint8_t slot_a, uint8_t slot_b );
+static inline void _unit_enviii_median_place( unit_enviii_median_t *filter, bool upper, uint8_t pos, uint8_t slot );
+static void _unit_enviii_median_sift( unit_enviii_median_t *filter, bool upper, uint8_t pos );
+
+static inline bool _unit_enviii_median_above( const unit_enviii_median_t *filter, bool upper, uint8_t slot_a, uint8_t slot_b )
+{
+    // true when slot_a belongs closer to the top of its heap than slot_b
+    return upper ? filter->ring[ slot_a ] < filter->ring[ slot_b ] : filter->ring[ slot_a ] > filter->ring[ slot_b ];
+}
+
+static inline void _unit_enviii_median_place( unit_enviii_median_t *filter, bool upper, uint8_t pos, uint8_t slot )
+{
+    if ( upper )
+    {
+        filter->upper[ pos ] = slot;
+        filter->index[ slot ] = pos | MEDIAN_UPPER;
+    }
+    else
+    {
+        filter->lower[ pos ] = slot;
+        filter->index[ slot ] = pos;
+    }
+}
+
+static void _unit_enviii_median_sift( unit_enviii_median_t *filter, bool upper, uint8_t pos )
+{
+    uint8_t *heap = upper ? filter->upper : filter->lower;
+    uint8_t count = upper ? filter->upper_count : filter->lower_count;
+    uint8_t slot = heap[ pos ];
+
+    while ( pos > 0 && _unit_enviii_median_above( filter, upper, slot, heap[ ( pos - 1 ) / 2 ] ) )
+    {
+        _unit_enviii_median_place( filter, upper, pos, heap[ ( pos - 1 ) / 2 ] );
+        pos = ( pos - 1 ) / 2;
+    }
+    while ( 2 * pos + 1 < count )
+    {
+        uint8_t child = 2 * pos + 1;
+        if ( child + 1 < count && _unit_enviii_median_above( filter, upper, heap[ child + 1 ], heap[ child ] ) )
+            child++;
+        if ( !_unit_enviii_median_above( filter, upper, heap[ child ], slot ) )
+            break;
+        _unit_enviii_median_place( filter, upper, pos, heap[ child ] );
+        pos = child;
+    }
+    _unit_enviii_median_place( filter, upper, pos, slot );
+}
+
+esp_err_t unit_enviii_median_init( unit_enviii_median_t *filter, uint8_t window )
+{
+    if ( filter == NULL || window == 0 || window > UNIT_ENVIII_MEDIAN_MAX_WINDOW )
+        return ESP_ERR_INVALID_ARG;
+
+    memset( filter, 0, sizeof( unit_enviii_median_t ) );
+    filter->window = window;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_median_update( unit_enviii_median_t *filter, int32_t value, int32_t *median )
+{
+    uint8_t slot;
+
+    if ( filter == NULL || median == NULL || filter->window == 0 )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( filter->lower_count + filter->upper_count < filter->window )
+    {
+        // still filling, the ring slots are taken in order and the lower heap gets the odd one
+        slot = filter->lower_count + filter->upper_count;
+        filter->ring[ slot ] = value;
+        if ( filter->lower_count <= filter->upper_count )
+        {
+            _unit_enviii_median_place( filter, false, filter->lower_count++, slot );
+            _unit_enviii_median_sift( filter, false, filter->lower_count - 1 );
+        }
+        else
+        {
+            _unit_enviii_median_place( filter, true, filter->upper_count++, slot );
+            _unit_enviii_median_sift( filter, true, filter->upper_count - 1 );
+        }
+    }
+    else
+    {
+        // overwrite the oldest sample where it sits in its heap and sift it from there
+        slot = filter->head;
+        filter->head = ( filter->head + 1 ) % filter->window;
+        filter->ring[ slot ] = value;
+        _unit_enviii_median_sift( filter, filter->index[ slot ] & MEDIAN_UPPER, filter->index[ slot ] & ~MEDIAN_UPPER );
+    }
+
+    // the new sample can only have crossed the median, one exchange of the tops restores the halves
+    if ( filter->upper_count > 0 && filter->ring[ filter->lower[ 0 ] ] > filter->ring[ filter->upper[ 0 ] ] )
+    {
+        uint8_t lower_top = filter->lower[ 0 ];
+
+        _unit_enviii_median_place( filter, false, 0, filter->upper[ 0 ] );
+        _unit_enviii_median_place( filter, true, 0, lower_top );
+        _unit_enviii_median_sift( filter, false, 0 );
+        _unit_enviii_median_sift( filter, true, 0 );
+    }
+
+    if ( filter->lower_count > filter->upper_count )
+    {
+        *median = filter->ring[ filter->lower[ 0 ] ];
+    }
+    else
+    {
+        int64_t sum = ( int64_t )filter->ring[ filter->lower[ 0 ] ] + filter->ring[ filter->upper[ 0 ] ];
+        *median = ( int32_t )( sum / 2 );
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_median_stage_init( unit_enviii_median_stage_t *stage, uint32_t channels, uint8_t window )
+{
+    if ( stage == NULL || ( channels & ~UNIT_ENVIII_CHANNEL_ALL ) )
+        return ESP_ERR_INVALID_ARG;
+
+    stage->channels = channels;
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        esp_err_t err = unit_enviii_median_init( &stage->filter[ channel ], window );
+        if ( err != ESP_OK )
+            return err;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_median_stage_process( unit_enviii_sample_t *sample, void *context )
+{
+    unit_enviii_median_stage_t *stage = ( unit_enviii_median_stage_t * )context;
+
+    if ( sample == NULL || stage == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    uint32_t channels = stage->channels & sample->channels;
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        if ( channels & UNIT_ENVIII_CHANNEL_BIT( channel ) )
+            unit_enviii_median_update( &stage->filter[ channel ], sample->value[ channel ], &sample->value[ channel ] );
+    }
+
+    return ESP_OK;
+}
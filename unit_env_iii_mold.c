@@ -0,0 +1,211 @@
+/*!
+ * @brief Dew point margin and mold risk index for ENV III storage room monitoring
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include "unit_env_iii_mold.h"
+#include "unit_env_iii_noheap.h"
+
+#define PSAT_TABLE_MIN          -40000  /* first saturation pressure entry, 0.001 degree Celsius */
+#define PSAT_TABLE_STEP         1000
+#define PSAT_TABLE_SIZE         101
+#define ISOPLETH_TABLE_SIZE     21      /* 0 to 20 degree Celsius, 80 percent above */
+#define ISOPLETH_ABOVE_TABLE    80000
+#define MOLD_MAX_GAP_US         ( 6LL * 3600 * 1000000 )
+#define MOLD_INDEX_SCALE        1000000LL   /* state units per reported 0.001 */
+
+/* Saturation vapour pressure over water in 0.1 Pa from -40 to 60 degree
+ * Celsius in 1 degree steps, Magnus formula 611.2 exp( 17.62 T / ( 243.12 + T ) ) */
+static const uint32_t _psat[ PSAT_TABLE_SIZE ] = {
+    190, 211, 234, 259, 286, 316, 348, 384,
+    423, 465, 512, 562, 617, 676, 741, 811,
+    887, 970, 1059, 1155, 1260, 1372, 1494, 1625,
+    1766, 1919, 2083, 2259, 2448, 2652, 2870, 3105,
+    3356, 3625, 3913, 4222, 4552, 4904, 5281, 5683,
+    6112, 6569, 7057, 7576, 8129, 8717, 9343, 10008,
+    10714, 11464, 12260, 13105, 14000, 14948, 15953, 17017,
+    18142, 19333, 20591, 21921, 23326, 24809, 26374, 28025,
+    29766, 31601, 33533, 35569, 37711, 39966, 42337, 44830,
+    47450, 50203, 53094, 56128, 59313, 62653, 66156, 69827,
+    73675, 77704, 81924, 86341, 90963, 95797, 100852, 106137,
+    111659, 117427, 123452, 129741, 136304, 143152, 150294, 157742,
+    165504, 173593, 182020, 190796, 199933
+};
+
+/* Lowest isopleth for mold growth in 0.001 percent RH from 0 to 20 degree
+ * Celsius in 1 degree steps, VTT model -0.00267 T^3 + 0.160 T^2 - 3.13 T + 100 */
+static const uint32_t _isopleth[ ISOPLETH_TABLE_SIZE ] = {
+    100000, 97027, 94359, 91978, 89869, 88016, 86403, 85014,
+    83833, 82844, 82030, 81376, 80866, 80484, 80214, 80039,
+    79944, 79912, 79929, 79976, 80040
+};
+
+static uint32_t _unit_enviii_mold_psat( int32_t temperature );
+static int32_t _unit_enviii_mold_psat_inverse( uint32_t pressure );
+static uint32_t _unit_enviii_mold_isopleth( int32_t temperature );
+
+static uint32_t _unit_enviii_mold_psat( int32_t temperature )
+{
+    int32_t offset = temperature - PSAT_TABLE_MIN;
+
+    if ( offset <= 0 )
+        return _psat[ 0 ];
+    if ( offset >= ( PSAT_TABLE_SIZE - 1 ) * PSAT_TABLE_STEP )
+        return _psat[ PSAT_TABLE_SIZE - 1 ];
+
+    int32_t i = offset / PSAT_TABLE_STEP;
+    int32_t fraction = offset % PSAT_TABLE_STEP;
+
+    return _psat[ i ] + ( uint32_t )( ( ( uint64_t )( _psat[ i + 1 ] - _psat[ i ] ) * fraction ) / PSAT_TABLE_STEP );
+}
+
+static int32_t _unit_enviii_mold_psat_inverse( uint32_t pressure )
+{
+    if ( pressure <= _psat[ 0 ] )
+        return PSAT_TABLE_MIN;
+    if ( pressure >= _psat[ PSAT_TABLE_SIZE - 1 ] )
+        return PSAT_TABLE_MIN + ( PSAT_TABLE_SIZE - 1 ) * PSAT_TABLE_STEP;
+
+    // last entry not above the pressure
+    int32_t low = 0, high = PSAT_TABLE_SIZE - 1;
+    while ( high - low > 1 )
+    {
+        int32_t mid = ( low + high ) / 2;
+        if ( _psat[ mid ] <= pressure )
+            low = mid;
+        else
+            high = mid;
+    }
+
+    return PSAT_TABLE_MIN + low * PSAT_TABLE_STEP +
+           ( int32_t )( ( ( uint64_t )( pressure - _psat[ low ] ) * PSAT_TABLE_STEP ) / ( _psat[ high ] - _psat[ low ] ) );
+}
+
+static uint32_t _unit_enviii_mold_isopleth( int32_t temperature )
+{
+    if ( temperature <= 0 )
+        return _isopleth[ 0 ];
+    if ( temperature >= ( ISOPLETH_TABLE_SIZE - 1 ) * 1000 )
+        return ISOPLETH_ABOVE_TABLE;
+
+    int32_t i = temperature / 1000;
+    int32_t fraction = temperature % 1000;
+
+    return ( uint32_t )( ( int32_t )_isopleth[ i ] + ( ( ( int32_t )_isopleth[ i + 1 ] - ( int32_t )_isopleth[ i ] ) * fraction ) / 1000 );
+}
+
+esp_err_t unit_enviii_dew_point_get( int32_t temperature, int32_t humidity, int32_t *dew_point )
+{
+    if ( dew_point == NULL || humidity < 0 )
+        return ESP_ERR_INVALID_ARG;
+
+    uint32_t vapour = ( uint32_t )( ( ( uint64_t )_unit_enviii_mold_psat( temperature ) * ( uint32_t )humidity ) / 100000 );
+    *dew_point = _unit_enviii_mold_psat_inverse( vapour );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_mold_init( unit_enviii_mold_t *mold )
+{
+    if ( mold == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    memset( mold, 0, sizeof( unit_enviii_mold_t ) );
+    mold->growth_rate = UNIT_ENVIII_MOLD_DEFAULT_GROWTH;
+    mold->decay_rate = UNIT_ENVIII_MOLD_DEFAULT_DECAY;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_mold_surface_temperature_set( unit_enviii_mold_t *mold, int32_t temperature )
+{
+    if ( mold == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    mold->surface_temperature = temperature;
+    mold->surface_valid = true;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_mold_update( unit_enviii_mold_t *mold, unit_enviii_sample_t *sample )
+{
+    const uint32_t needed = UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_TEMPERATURE ) |
+                            UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_HUMIDITY );
+
+    if ( mold == NULL || sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( ( sample->channels & needed ) != needed )
+        return ESP_OK;
+
+    int32_t air = sample->value[ UNIT_ENVIII_CHANNEL_TEMPERATURE ];
+    int32_t humidity = sample->value[ UNIT_ENVIII_CHANNEL_HUMIDITY ];
+    int32_t surface = mold->surface_valid ? mold->surface_temperature : air;
+    if ( humidity < 0 )
+        humidity = 0;
+
+    // the vapour pressure of the air carries over to the surface
+    uint32_t vapour = ( uint32_t )( ( ( uint64_t )_unit_enviii_mold_psat( air ) * ( uint32_t )humidity ) / 100000 );
+    uint64_t surface_humidity = ( ( uint64_t )vapour * 100000 ) / _unit_enviii_mold_psat( surface );
+    if ( surface_humidity > 100000 )
+        surface_humidity = 100000;
+
+    int32_t dew_point = _unit_enviii_mold_psat_inverse( vapour );
+    sample->derived.dew_point = dew_point;
+    sample->derived.dew_point_margin = surface - dew_point;
+    if ( sample->derived.dew_point_margin <= 0 )
+        sample->flags |= UNIT_ENVIII_SAMPLE_FLAG_CONDENSATION;
+
+    // integrate the index over the time since the previous sample
+    unit_enviii_mold_state_t *state = &mold->state;
+    int64_t elapsed = ( state->last_us == 0 ) ? 0 : sample->timestamp_us - state->last_us;
+    if ( elapsed < 0 )
+        elapsed = 0;
+    if ( elapsed > MOLD_MAX_GAP_US )
+        elapsed = MOLD_MAX_GAP_US;
+    state->last_us = sample->timestamp_us;
+
+    int64_t isopleth = _unit_enviii_mold_isopleth( surface );
+    if ( surface > 0 && ( int64_t )surface_humidity >= isopleth )
+    {
+        int64_t excess = ( int64_t )surface_humidity - isopleth;
+        state->index += ( ( int64_t )mold->growth_rate * excess * elapsed ) / 3600000000LL;
+        sample->flags |= UNIT_ENVIII_SAMPLE_FLAG_MOLD_GROWTH;
+    }
+    else
+    {
+        state->index -= ( ( int64_t )mold->decay_rate * elapsed ) / 3600000LL;
+    }
+
+    if ( state->index < 0 )
+        state->index = 0;
+    if ( state->index > UNIT_ENVIII_MOLD_INDEX_MAX * MOLD_INDEX_SCALE )
+        state->index = UNIT_ENVIII_MOLD_INDEX_MAX * MOLD_INDEX_SCALE;
+    sample->derived.mold_index = ( int32_t )( state->index / MOLD_INDEX_SCALE );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_mold_stage_process( unit_enviii_sample_t *sample, void *context )
+{
+    return unit_enviii_mold_update( ( unit_enviii_mold_t * )context, sample );
+}
@@ -0,0 +1,39 @@
+/*!
+ * @brief Compile time guard against heap allocation in the ENV III driver and stages
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#ifndef _UNIT_ENV_III_NOHEAP_H_
+#define _UNIT_ENV_III_NOHEAP_H_
+
+/* Every source of the component includes this header after its other
+ * includes, so with the guard enabled any heap call in the driver or a
+ * stage fails the build on the target and on a host build alike. Sensor
+ * descriptors take their I2C mutex through i2cdev at init, outside this
+ * guard. */
+#include "unit_env_iii_config.h"
+
+#if UNIT_ENVIII_NO_HEAP
+#pragma GCC poison malloc calloc realloc free strdup
+#pragma GCC poison heap_caps_malloc heap_caps_calloc heap_caps_realloc heap_caps_free
+#pragma GCC poison pvPortMalloc vPortFree
+#endif
+
+#endif
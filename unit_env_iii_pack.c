@@ -0,0 +1,99 @@
+/*!
+ * @brief Bit-packed columnar storage format for ENV III sample history
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include "unit_env_iii_pack.h"
+#include "unit_env_iii_noheap.h"
+
+#if UNIT_ENVIII_ENCODERS
+
+esp_err_t unit_enviii_pack_block_init( unit_enviii_pack_block_t *block )
+{
+    if ( block == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    memset( block, 0, sizeof( unit_enviii_pack_block_t ) );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_pack_block_append( unit_enviii_pack_block_t *block, const unit_enviii_sample_t *sample )
+{
+    uint16_t delta_ms = 0;
+
+    if ( block == NULL || sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( block->count >= UNIT_ENVIII_PACK_BLOCK_SAMPLES )
+        return ESP_ERR_NO_MEM;
+
+    if ( block->count == 0 )
+    {
+        block->base_us = sample->timestamp_us;
+    }
+    else
+    {
+        int64_t delta_us = sample->timestamp_us - block->last_us;
+        if ( delta_us < 0 )
+            return ESP_ERR_INVALID_ARG;
+        if ( delta_us / 1000 > UINT16_MAX )
+            return ESP_ERR_INVALID_SIZE;
+        delta_ms = ( uint16_t )( delta_us / 1000 );
+    }
+
+    uint16_t i = block->count;
+    uint32_t pressure = unit_enviii_pack_pressure( sample->value[ UNIT_ENVIII_CHANNEL_PRESSURE ] );
+
+    block->delta_ms[ i ] = delta_ms;
+    block->temperature[ i ] = unit_enviii_pack_temperature( sample->value[ UNIT_ENVIII_CHANNEL_TEMPERATURE ] );
+    block->humidity[ i ] = unit_enviii_pack_humidity( sample->value[ UNIT_ENVIII_CHANNEL_HUMIDITY ] );
+    block->pressure_lo[ i ] = pressure & 0xFFFF;
+    block->pressure_hi[ i ] = pressure >> 16;
+    block->channels[ i ] = sample->channels & UNIT_ENVIII_CHANNEL_ALL;
+
+    // keep the stored time base so truncating to milliseconds does not drift
+    block->last_us = ( i == 0 ) ? sample->timestamp_us : block->last_us + ( int64_t )delta_ms * 1000;
+    block->count++;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_pack_block_get( const unit_enviii_pack_block_t *block, uint16_t index, unit_enviii_sample_t *sample )
+{
+    if ( block == NULL || sample == NULL || index >= block->count )
+        return ESP_ERR_INVALID_ARG;
+
+    int64_t offset_ms = 0;
+    for ( uint16_t i = 1; i <= index; i++ )
+        offset_ms += block->delta_ms[ i ];
+
+    memset( sample, 0, sizeof( unit_enviii_sample_t ) );
+    sample->timestamp_us = block->base_us + offset_ms * 1000;
+    sample->value[ UNIT_ENVIII_CHANNEL_TEMPERATURE ] = unit_enviii_unpack_temperature( block->temperature[ index ] );
+    sample->value[ UNIT_ENVIII_CHANNEL_HUMIDITY ] = unit_enviii_unpack_humidity( block->humidity[ index ] );
+    sample->value[ UNIT_ENVIII_CHANNEL_PRESSURE ] = block->pressure_lo[ index ] | ( ( int32_t )block->pressure_hi[ index ] << 16 );
+    sample->channels = block->channels[ index ];
+
+    return ESP_OK;
+}
+
+#endif
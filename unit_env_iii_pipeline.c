@@ -0,0 +1,338 @@
+/*!
+ * @brief Per-sample processing pipeline for the ENV III unit
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_attr.h>
+#include "unit_env_iii_pipeline.h"
+#include "unit_env_iii_subscribe.h"
+#include "unit_env_iii_noheap.h"
+
+#define SNAPSHOT_MAGIC          0x53503345  /* "E3PS" */
+#define SNAPSHOT_HEADER_SIZE    24
+#define SNAPSHOT_RECORD_SIZE    6
+#define FNV_OFFSET_BASIS        0x811C9DC5
+#define FNV_PRIME               0x01000193
+#define CRC32_POLYNOM           0xEDB88320
+
+typedef struct
+{
+    unit_enviii_stage_t stage;
+    unit_enviii_stage_stats_t stats;
+} _unit_enviii_pipeline_slot_t;
+
+static uint32_t _unit_enviii_pipeline_name_hash( const char *name );
+static uint32_t _unit_enviii_pipeline_crc32( const uint8_t *data, size_t len );
+static void _unit_enviii_pipeline_u32_put( uint8_t *buffer, uint32_t value );
+static uint32_t _unit_enviii_pipeline_u32_get( const uint8_t *buffer );
+static _unit_enviii_pipeline_slot_t _stages[ UNIT_ENVIII_PIPELINE_MAX_STAGES ];
+static uint8_t _stage_count;
+static int64_t _time_offset_us;
+RTC_NOINIT_ATTR static uint8_t _rtc_snapshot[ UNIT_ENVIII_PIPELINE_RTC_SNAPSHOT_SIZE ];
+static const char *_TAG = "UNIT_ENV_III_PIPELINE";
+
+esp_err_t unit_enviii_pipeline_stage_register( const unit_enviii_stage_t *stage )
+{
+    if ( stage == NULL || stage->process == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( _stage_count >= UNIT_ENVIII_PIPELINE_MAX_STAGES )
+    {
+        ESP_LOGE( _TAG, "No free pipeline slot for stage %s", stage->name ? stage->name : "" );
+        return ESP_ERR_NO_MEM;
+    }
+
+    _unit_enviii_pipeline_slot_t *slot = &_stages[ _stage_count ];
+    memset( slot, 0, sizeof( _unit_enviii_pipeline_slot_t ) );
+    slot->stage = *stage;
+    slot->stats.name = stage->name;
+    _stage_count++;
+    ESP_LOGD( _TAG, "Registered pipeline stage %s", stage->name ? stage->name : "" );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_pipeline_clear( void )
+{
+    memset( _stages, 0, sizeof( _stages ) );
+    _stage_count = 0;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_pipeline_run( unit_enviii_sample_t *sample )
+{
+    if ( sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    for ( uint8_t i = 0; i < _stage_count; i++ )
+    {
+        _unit_enviii_pipeline_slot_t *slot = &_stages[ i ];
+
+#if UNIT_ENVIII_INSTRUMENTATION
+        int64_t start = esp_timer_get_time();
+        esp_err_t err = slot->stage.process( sample, slot->stage.context );
+        uint32_t elapsed = ( uint32_t )( esp_timer_get_time() - start );
+
+        slot->stats.last_us = elapsed;
+        slot->stats.total_us += elapsed;
+        if ( elapsed > slot->stats.max_us )
+            slot->stats.max_us = elapsed;
+#else
+        esp_err_t err = slot->stage.process( sample, slot->stage.context );
+#endif
+        slot->stats.runs++;
+
+        if ( err != ESP_OK )
+        {
+            slot->stats.errors++;
+            ESP_LOGD( _TAG, "Pipeline stopped at stage %s", slot->stage.name ? slot->stage.name : "" );
+            return err;
+        }
+    }
+
+    return unit_enviii_subscribe_dispatch( sample );
+}
+
+esp_err_t unit_enviii_pipeline_stage_count_get( uint8_t *count )
+{
+    if ( count == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    *count = _stage_count;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_pipeline_stage_stats_get( uint8_t index, unit_enviii_stage_stats_t *stats )
+{
+    if ( stats == NULL || index >= _stage_count )
+        return ESP_ERR_INVALID_ARG;
+
+    *stats = _stages[ index ].stats;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_pipeline_stats_reset( void )
+{
+    for ( uint8_t i = 0; i < _stage_count; i++ )
+    {
+        memset( &_stages[ i ].stats, 0, sizeof( unit_enviii_stage_stats_t ) );
+        _stages[ i ].stats.name = _stages[ i ].stage.name;
+    }
+
+    return ESP_OK;
+}
+
+int64_t unit_enviii_pipeline_timestamp_get( void )
+{
+    return esp_timer_get_time() + _time_offset_us;
+}
+
+esp_err_t unit_enviii_pipeline_snapshot_size_get( size_t *size )
+{
+    if ( size == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    *size = SNAPSHOT_HEADER_SIZE;
+    for ( uint8_t i = 0; i < _stage_count; i++ )
+    {
+        if ( _stages[ i ].stage.state != NULL )
+            *size += SNAPSHOT_RECORD_SIZE + _stages[ i ].stage.state_size;
+    }
+
+    return ESP_OK;
+}
+
+/*
+ * Blob layout, little endian:
+ *  header : magic u32, version u8, record count u8, reserved u16,
+ *           length u32, timestamp u64, crc32 of everything after the header u32
+ *  record : stage name hash u32, state size u16, state bytes
+ */
+esp_err_t unit_enviii_pipeline_snapshot_save( uint8_t *buffer, size_t size, size_t *written )
+{
+    size_t needed;
+
+    if ( buffer == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    unit_enviii_pipeline_snapshot_size_get( &needed );
+    if ( size < needed )
+    {
+        ESP_LOGE( _TAG, "Snapshot needs %u bytes, buffer holds %u", ( unsigned )needed, ( unsigned )size );
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint8_t records = 0;
+    uint8_t *cursor = buffer + SNAPSHOT_HEADER_SIZE;
+    for ( uint8_t i = 0; i < _stage_count; i++ )
+    {
+        const unit_enviii_stage_t *stage = &_stages[ i ].stage;
+        if ( stage->state == NULL )
+            continue;
+
+        _unit_enviii_pipeline_u32_put( cursor, _unit_enviii_pipeline_name_hash( stage->name ) );
+        cursor[ 4 ] = stage->state_size & 0xFF;
+        cursor[ 5 ] = stage->state_size >> 8;
+        memcpy( cursor + SNAPSHOT_RECORD_SIZE, stage->state, stage->state_size );
+        cursor += SNAPSHOT_RECORD_SIZE + stage->state_size;
+        records++;
+    }
+
+    uint64_t timestamp = ( uint64_t )unit_enviii_pipeline_timestamp_get();
+    _unit_enviii_pipeline_u32_put( buffer, SNAPSHOT_MAGIC );
+    buffer[ 4 ] = UNIT_ENVIII_PIPELINE_SNAPSHOT_VERSION;
+    buffer[ 5 ] = records;
+    buffer[ 6 ] = 0;
+    buffer[ 7 ] = 0;
+    _unit_enviii_pipeline_u32_put( buffer + 8, ( uint32_t )needed );
+    _unit_enviii_pipeline_u32_put( buffer + 12, ( uint32_t )timestamp );
+    _unit_enviii_pipeline_u32_put( buffer + 16, ( uint32_t )( timestamp >> 32 ) );
+    _unit_enviii_pipeline_u32_put( buffer + 20, _unit_enviii_pipeline_crc32( buffer + SNAPSHOT_HEADER_SIZE, needed - SNAPSHOT_HEADER_SIZE ) );
+
+    if ( written != NULL )
+        *written = needed;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_pipeline_snapshot_restore( const uint8_t *buffer, size_t size, int64_t elapsed_us )
+{
+    if ( buffer == NULL || elapsed_us < 0 )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( size < SNAPSHOT_HEADER_SIZE || _unit_enviii_pipeline_u32_get( buffer ) != SNAPSHOT_MAGIC )
+        return ESP_ERR_INVALID_CRC;
+
+    if ( buffer[ 4 ] != UNIT_ENVIII_PIPELINE_SNAPSHOT_VERSION )
+    {
+        ESP_LOGW( _TAG, "Snapshot version %u not supported", buffer[ 4 ] );
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    size_t length = _unit_enviii_pipeline_u32_get( buffer + 8 );
+    if ( length < SNAPSHOT_HEADER_SIZE || length > size )
+        return ESP_ERR_INVALID_SIZE;
+
+    if ( _unit_enviii_pipeline_crc32( buffer + SNAPSHOT_HEADER_SIZE, length - SNAPSHOT_HEADER_SIZE ) != _unit_enviii_pipeline_u32_get( buffer + 20 ) )
+    {
+        ESP_LOGW( _TAG, "Snapshot CRC check failed" );
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    // records are matched to the stages holding state in registration order
+    const uint8_t *cursor = buffer + SNAPSHOT_HEADER_SIZE;
+    const uint8_t *end = buffer + length;
+    uint8_t records = buffer[ 5 ];
+    uint8_t stage_index = 0;
+    for ( uint8_t record = 0; record < records; record++ )
+    {
+        if ( end - cursor < SNAPSHOT_RECORD_SIZE )
+            return ESP_ERR_INVALID_SIZE;
+
+        uint32_t hash = _unit_enviii_pipeline_u32_get( cursor );
+        uint16_t state_size = cursor[ 4 ] | ( cursor[ 5 ] << 8 );
+        cursor += SNAPSHOT_RECORD_SIZE;
+        if ( end - cursor < state_size )
+            return ESP_ERR_INVALID_SIZE;
+
+        while ( stage_index < _stage_count && _stages[ stage_index ].stage.state == NULL )
+            stage_index++;
+
+        if ( stage_index < _stage_count )
+        {
+            const unit_enviii_stage_t *stage = &_stages[ stage_index ].stage;
+            if ( hash == _unit_enviii_pipeline_name_hash( stage->name ) && state_size == stage->state_size )
+                memcpy( stage->state, cursor, state_size );
+            else
+                ESP_LOGW( _TAG, "Snapshot does not match stage %s, keeping fresh state", stage->name ? stage->name : "" );
+            stage_index++;
+        }
+        cursor += state_size;
+    }
+
+    // continue the sample timebase from where the snapshot was taken
+    int64_t saved_us = ( int64_t )( _unit_enviii_pipeline_u32_get( buffer + 12 ) |
+                                    ( ( uint64_t )_unit_enviii_pipeline_u32_get( buffer + 16 ) << 32 ) );
+    _time_offset_us = saved_us + elapsed_us - esp_timer_get_time();
+    ESP_LOGD( _TAG, "Restored %u stage snapshots", records );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_pipeline_snapshot_rtc_save( void )
+{
+    return unit_enviii_pipeline_snapshot_save( _rtc_snapshot, sizeof( _rtc_snapshot ), NULL );
+}
+
+esp_err_t unit_enviii_pipeline_snapshot_rtc_restore( int64_t elapsed_us )
+{
+    esp_err_t err = unit_enviii_pipeline_snapshot_restore( _rtc_snapshot, sizeof( _rtc_snapshot ), elapsed_us );
+
+    // invalidate so a later reset without a new save starts fresh
+    memset( _rtc_snapshot, 0, SNAPSHOT_HEADER_SIZE );
+
+    return err;
+}
+
+static uint32_t _unit_enviii_pipeline_name_hash( const char *name )
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+
+    while ( name != NULL && *name )
+    {
+        hash ^= ( uint8_t )*name++;
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static uint32_t _unit_enviii_pipeline_crc32( const uint8_t *data, size_t len )
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    for ( size_t i = 0; i < len; i++ )
+    {
+        crc ^= data[ i ];
+        for ( int bit = 0; bit < 8; bit++ )
+            crc = ( crc >> 1 ) ^ ( ( crc & 1 ) ? CRC32_POLYNOM : 0 );
+    }
+
+    return ~crc;
+}
+
+static void _unit_enviii_pipeline_u32_put( uint8_t *buffer, uint32_t value )
+{
+    buffer[ 0 ] = value & 0xFF;
+    buffer[ 1 ] = ( value >> 8 ) & 0xFF;
+    buffer[ 2 ] = ( value >> 16 ) & 0xFF;
+    buffer[ 3 ] = value >> 24;
+}
+
+static uint32_t _unit_enviii_pipeline_u32_get( const uint8_t *buffer )
+{
+    return buffer[ 0 ] | ( buffer[ 1 ] << 8 ) | ( buffer[ 2 ] << 16 ) | ( ( uint32_t )buffer[ 3 ] << 24 );
+}
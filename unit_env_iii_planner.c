@@ -0,0 +1,374 @@
+/*!
+ * @brief Energy budget planner choosing the cheapest sensor configuration
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <math.h>
+#include "unit_env_iii_planner.h"
+#include "unit_env_iii_noheap.h"
+
+/* Bus time of a trigger and a fetch, the estimates the driver hands the bus scheduler */
+#define PLANNER_TRIGGER_US          150
+#define PLANNER_FETCH_US            300
+/* Port A pull-ups, 4.7 kOhm per line at 3.3 V, each low about half of a transfer */
+#define PLANNER_BUS_NA              700000
+
+#define PLANNER_REPEATABILITIES     3
+#define PLANNER_OVERSAMPLING_MAX    5
+#define PLANNER_FILTER_MAX          4
+#define PLANNER_PERIODS             8
+
+/* Datasheet model of a temperature and humidity sensor */
+typedef struct
+{
+    uint32_t measure_us[ PLANNER_REPEATABILITIES ];         /* conversion time, the wait the driver uses */
+    uint32_t measure_na;                                    /* current while converting */
+    uint32_t idle_na;                                       /* current between single shot conversions */
+    uint32_t periodic_idle_na;                              /* current between periodic conversions, 0 without periodic mode */
+    uint32_t heater_na;                                     /* current of the lowest heater setting */
+    uint32_t period_ms[ PLANNER_PERIODS ];                  /* periodic mode conversion periods, 0 terminated */
+    int32_t temperature_noise[ PLANNER_REPEATABILITIES ];   /* repeatability, 0.001 degree Celsius */
+    int32_t humidity_noise[ PLANNER_REPEATABILITIES ];      /* repeatability, 0.001 percent */
+} _unit_enviii_planner_humidity_model_t;
+
+/* Datasheet model of a pressure sensor with temperature 1x oversampling */
+typedef struct
+{
+    uint32_t base_us;                       /* conversion time without pressure samples */
+    uint32_t sample_us;                     /* conversion time added per pressure sample */
+    uint32_t measure_na;                    /* current while converting */
+    uint32_t sleep_na;                      /* current in sleep mode between forced conversions */
+    uint32_t standby_na;                    /* current in standby between normal mode conversions */
+    uint32_t standby_us[ PLANNER_PERIODS ]; /* normal mode standby times */
+    int32_t noise;                          /* RMS noise at 1x without filter, 0.1 Pa */
+} _unit_enviii_planner_pressure_model_t;
+
+static const _unit_enviii_planner_humidity_model_t _sht3x = {
+    .measure_us = { 15000, 6000, 4000 },
+    .measure_na = 600000,
+    .idle_na = 200,
+    .periodic_idle_na = 45000,
+    .heater_na = 3600000,
+    .period_ms = { 100, 250, 500, 1000, 2000 },
+    .temperature_noise = { 40, 80, 150 },
+    .humidity_noise = { 100, 150, 250 }
+};
+
+static const _unit_enviii_planner_humidity_model_t _sht4x = {
+    .measure_us = { 10000, 5000, 2000 },
+    .measure_na = 320000,
+    .idle_na = 80,
+    .heater_na = 6100000,
+    .temperature_noise = { 40, 70, 100 },
+    .humidity_noise = { 80, 150, 250 }
+};
+
+static const _unit_enviii_planner_pressure_model_t _qmp6988 = {
+    .base_us = 3600,
+    .sample_us = 950,
+    .measure_na = 360000,
+    .sleep_na = 500,
+    .standby_na = 1000,
+    .standby_us = { 1000, 5000, 50000, 250000, 500000, 1000000, 2000000, 4000000 },
+    .noise = 19
+};
+
+static const _unit_enviii_planner_pressure_model_t _bmp280 = {
+    .base_us = 4125,
+    .sample_us = 2300,
+    .measure_na = 700000,
+    .sleep_na = 100,
+    .standby_na = 200,
+    .standby_us = { 500, 62500, 125000, 250000, 500000, 1000000, 2000000, 4000000 },
+    .noise = 26
+};
+
+/* Conversions an IIR filter needs to follow 75 percent of a step, by filter setting */
+static const uint8_t _filter_settle[ PLANNER_FILTER_MAX + 1 ] = { 1, 2, 5, 11, 22 };
+
+static bool _unit_enviii_planner_meets( const unit_enviii_planner_channel_t *channel, const unit_enviii_planner_estimate_t *estimate );
+static bool _unit_enviii_planner_better( uint64_t current_na, uint32_t latency_us, uint64_t best_na, uint32_t best_latency_us, bool found );
+static uint32_t _unit_enviii_planner_interval( const unit_enviii_planner_channel_t *a, const unit_enviii_planner_channel_t *b );
+static bool _unit_enviii_planner_humidity( const unit_enviii_planner_request_t *request, const _unit_enviii_planner_humidity_model_t *model, unit_enviii_planner_config_t *config, uint64_t *current_na );
+static bool _unit_enviii_planner_pressure( const unit_enviii_planner_request_t *request, const _unit_enviii_planner_pressure_model_t *model, unit_enviii_planner_config_t *config, uint64_t *current_na );
+
+esp_err_t unit_enviii_planner_plan( const unit_enviii_planner_request_t *request, unit_enviii_planner_config_t *config )
+{
+    if ( request == NULL || config == NULL || request->variant > UNIT_ENVIII_VARIANT_ENV_IV || request->heater_duty > 1000 )
+        return ESP_ERR_INVALID_ARG;
+
+    const _unit_enviii_planner_humidity_model_t *humidity = ( request->variant == UNIT_ENVIII_VARIANT_ENV_IV ) ? &_sht4x : &_sht3x;
+    const _unit_enviii_planner_pressure_model_t *pressure = ( request->variant == UNIT_ENVIII_VARIANT_ENV_III ) ? &_qmp6988 : &_bmp280;
+    uint64_t humidity_na = 0;
+    uint64_t pressure_na = 0;
+
+    memset( config, 0, sizeof( unit_enviii_planner_config_t ) );
+    if ( !_unit_enviii_planner_humidity( request, humidity, config, &humidity_na ) ||
+         !_unit_enviii_planner_pressure( request, pressure, config, &pressure_na ) )
+        return ESP_ERR_NOT_FOUND;
+
+    uint64_t current_na = humidity_na + pressure_na;
+    uint64_t budget_na = 0;
+
+    config->current_na = current_na > UINT32_MAX ? UINT32_MAX : ( uint32_t )current_na;
+    if ( request->battery_mah != 0 && current_na != 0 )
+    {
+        uint64_t hours = ( uint64_t )request->battery_mah * 1000000 / current_na;
+        config->life_hours = hours > UINT32_MAX ? UINT32_MAX : ( uint32_t )hours;
+    }
+
+    if ( request->budget_ua != 0 )
+        budget_na = ( uint64_t )request->budget_ua * 1000;
+    else if ( request->battery_mah != 0 && request->life_hours != 0 )
+        budget_na = ( uint64_t )request->battery_mah * 1000000 / request->life_hours;
+
+    return ( budget_na != 0 && current_na > budget_na ) ? ESP_FAIL : ESP_OK;
+}
+
+static bool _unit_enviii_planner_meets( const unit_enviii_planner_channel_t *channel, const unit_enviii_planner_estimate_t *estimate )
+{
+    if ( channel->interval_ms == 0 )
+        return true;
+    if ( channel->max_latency_us != 0 && estimate->latency_us > channel->max_latency_us )
+        return false;
+    if ( channel->max_age_us != 0 && estimate->age_us > channel->max_age_us )
+        return false;
+
+    return channel->max_noise == 0 || estimate->noise <= channel->max_noise;
+}
+
+/* Cheaper wins, the lower latency breaks a tie */
+static bool _unit_enviii_planner_better( uint64_t current_na, uint32_t latency_us, uint64_t best_na, uint32_t best_latency_us, bool found )
+{
+    if ( !found || current_na < best_na )
+        return true;
+
+    return current_na == best_na && latency_us < best_latency_us;
+}
+
+/* Shortest interval of two channels read from the same sensor, 0 if neither is needed */
+static uint32_t _unit_enviii_planner_interval( const unit_enviii_planner_channel_t *a, const unit_enviii_planner_channel_t *b )
+{
+    if ( a->interval_ms == 0 )
+        return b->interval_ms;
+    if ( b->interval_ms == 0 || a->interval_ms < b->interval_ms )
+        return a->interval_ms;
+
+    return b->interval_ms;
+}
+
+static bool _unit_enviii_planner_humidity( const unit_enviii_planner_request_t *request, const _unit_enviii_planner_humidity_model_t *model, unit_enviii_planner_config_t *config, uint64_t *current_na )
+{
+    uint32_t interval_ms = _unit_enviii_planner_interval( &request->temperature, &request->humidity );
+    uint64_t interval_us = ( uint64_t )interval_ms * 1000;
+    unit_enviii_planner_config_t best;
+    uint64_t best_na = 0;
+    bool found = false;
+
+    if ( interval_ms == 0 )
+        return true;
+
+    memset( &best, 0, sizeof( best ) );
+    for ( uint8_t repeatability = 0; repeatability < PLANNER_REPEATABILITIES; repeatability++ )
+    {
+        uint32_t measure_us = model->measure_us[ repeatability ];
+
+        for ( unit_enviii_planner_mode_t mode = UNIT_ENVIII_PLANNER_MODE_SINGLE_SHOT; mode <= UNIT_ENVIII_PLANNER_MODE_PERIODIC; mode++ )
+        {
+            for ( uint8_t p = 0; p < PLANNER_PERIODS; p++ )
+            {
+                unit_enviii_planner_estimate_t estimate;
+                uint64_t period_us = interval_us;
+                uint64_t sensor_na;
+                uint64_t access;
+
+                if ( mode == UNIT_ENVIII_PLANNER_MODE_PERIODIC )
+                {
+                    if ( model->periodic_idle_na == 0 || model->period_ms[ p ] == 0 )
+                        break;
+                    period_us = ( uint64_t )model->period_ms[ p ] * 1000;
+                    if ( period_us > interval_us )
+                        break;
+                    // the sensor converts on its own, a read only fetches the latest result
+                    sensor_na = model->periodic_idle_na + ( uint64_t )model->measure_na * measure_us / period_us;
+                    access = ( uint64_t )( PLANNER_BUS_NA + request->host_active_ua * 1000ULL ) * PLANNER_FETCH_US;
+                    estimate.latency_us = PLANNER_FETCH_US;
+                    estimate.age_us = ( uint32_t )period_us + PLANNER_FETCH_US;
+                }
+                else
+                {
+                    if ( p > 0 || PLANNER_TRIGGER_US + measure_us + PLANNER_FETCH_US > interval_us )
+                        break;
+                    sensor_na = model->idle_na + ( uint64_t )model->measure_na * measure_us / interval_us;
+                    access = ( uint64_t )PLANNER_BUS_NA * ( PLANNER_TRIGGER_US + PLANNER_FETCH_US );
+                    if ( mode == UNIT_ENVIII_PLANNER_MODE_SINGLE_SHOT )
+                    {
+                        // the host stays awake through the conversion
+                        access += request->host_active_ua * 1000ULL * ( PLANNER_TRIGGER_US + measure_us + PLANNER_FETCH_US );
+                        estimate.latency_us = PLANNER_TRIGGER_US + measure_us + PLANNER_FETCH_US;
+                        estimate.age_us = PLANNER_FETCH_US;
+                    }
+                    else
+                    {
+                        // fetch the previous conversion and trigger the next one in the same wake up
+                        access += request->host_active_ua * 1000ULL * ( PLANNER_TRIGGER_US + PLANNER_FETCH_US );
+                        estimate.latency_us = PLANNER_FETCH_US;
+                        estimate.age_us = ( uint32_t )interval_us + PLANNER_FETCH_US;
+                    }
+                }
+
+                unit_enviii_planner_estimate_t temperature = estimate;
+                unit_enviii_planner_estimate_t humidity = estimate;
+                temperature.noise = model->temperature_noise[ repeatability ];
+                humidity.noise = model->humidity_noise[ repeatability ];
+                if ( !_unit_enviii_planner_meets( &request->temperature, &temperature ) ||
+                     !_unit_enviii_planner_meets( &request->humidity, &humidity ) )
+                    continue;
+
+                uint64_t total_na = sensor_na + access / interval_us + ( uint64_t )model->heater_na * request->heater_duty / 1000;
+                if ( !_unit_enviii_planner_better( total_na, estimate.latency_us, best_na, best.temperature.latency_us, found ) )
+                    continue;
+
+                found = true;
+                best_na = total_na;
+                best.humidity_mode = mode;
+                best.repeatability = repeatability;
+                best.humidity_period_ms = ( uint32_t )( period_us / 1000 );
+                best.temperature = temperature;
+                best.humidity = humidity;
+            }
+        }
+    }
+
+    if ( !found )
+        return false;
+
+    config->humidity_mode = best.humidity_mode;
+    config->repeatability = best.repeatability;
+    config->humidity_period_ms = best.humidity_period_ms;
+    config->heater_duty = request->heater_duty;
+    config->temperature = best.temperature;
+    config->humidity = best.humidity;
+    *current_na = best_na;
+
+    return true;
+}
+
+static bool _unit_enviii_planner_pressure( const unit_enviii_planner_request_t *request, const _unit_enviii_planner_pressure_model_t *model, unit_enviii_planner_config_t *config, uint64_t *current_na )
+{
+    uint64_t interval_us = ( uint64_t )request->pressure.interval_ms * 1000;
+    unit_enviii_planner_config_t best;
+    uint64_t best_na = 0;
+    bool found = false;
+
+    if ( interval_us == 0 )
+        return true;
+
+    memset( &best, 0, sizeof( best ) );
+    for ( uint8_t oversampling = 1; oversampling <= PLANNER_OVERSAMPLING_MAX; oversampling++ )
+    {
+        uint32_t samples = 1U << ( oversampling - 1 );
+        uint32_t measure_us = model->base_us + model->sample_us * samples;
+
+        for ( uint8_t filter = 0; filter <= PLANNER_FILTER_MAX; filter++ )
+        {
+            // oversampling averages white noise, an IIR filter with coefficient c keeps 1 / ( 2c - 1 ) of its power
+            uint32_t coefficient = 1U << filter;
+            int32_t noise = ( int32_t )lroundf( model->noise / sqrtf( ( float )( samples * ( 2 * coefficient - 1 ) ) ) );
+
+            for ( unit_enviii_planner_mode_t mode = UNIT_ENVIII_PLANNER_MODE_SINGLE_SHOT; mode <= UNIT_ENVIII_PLANNER_MODE_PERIODIC; mode++ )
+            {
+                for ( uint8_t p = 0; p < PLANNER_PERIODS; p++ )
+                {
+                    unit_enviii_planner_estimate_t estimate;
+                    uint64_t period_us = interval_us;
+                    uint64_t sensor_na;
+                    uint64_t access;
+                    uint32_t standby_us = 0;
+
+                    if ( mode == UNIT_ENVIII_PLANNER_MODE_PERIODIC )
+                    {
+                        // normal mode, conversions separated by the standby time
+                        standby_us = model->standby_us[ p ];
+                        period_us = measure_us + standby_us;
+                        if ( period_us > interval_us )
+                            break;
+                        sensor_na = ( ( uint64_t )model->measure_na * measure_us + ( uint64_t )model->standby_na * standby_us ) / period_us;
+                        access = ( uint64_t )( PLANNER_BUS_NA + request->host_active_ua * 1000ULL ) * PLANNER_FETCH_US;
+                        estimate.latency_us = PLANNER_FETCH_US;
+                        estimate.age_us = ( uint32_t )period_us + PLANNER_FETCH_US;
+                    }
+                    else
+                    {
+                        // forced mode, one conversion per read
+                        if ( p > 0 || PLANNER_TRIGGER_US + measure_us + PLANNER_FETCH_US > interval_us )
+                            break;
+                        sensor_na = model->sleep_na + ( uint64_t )model->measure_na * measure_us / interval_us;
+                        access = ( uint64_t )PLANNER_BUS_NA * ( PLANNER_TRIGGER_US + PLANNER_FETCH_US );
+                        if ( mode == UNIT_ENVIII_PLANNER_MODE_SINGLE_SHOT )
+                        {
+                            access += request->host_active_ua * 1000ULL * ( PLANNER_TRIGGER_US + measure_us + PLANNER_FETCH_US );
+                            estimate.latency_us = PLANNER_TRIGGER_US + measure_us + PLANNER_FETCH_US;
+                            estimate.age_us = PLANNER_FETCH_US;
+                        }
+                        else
+                        {
+                            access += request->host_active_ua * 1000ULL * ( PLANNER_TRIGGER_US + PLANNER_FETCH_US );
+                            estimate.latency_us = PLANNER_FETCH_US;
+                            estimate.age_us = ( uint32_t )interval_us + PLANNER_FETCH_US;
+                        }
+                    }
+
+                    // the filter output lags the input by the conversions it needs to settle
+                    uint64_t age_us = estimate.age_us + ( uint64_t )( _filter_settle[ filter ] - 1 ) * period_us;
+                    estimate.age_us = age_us > UINT32_MAX ? UINT32_MAX : ( uint32_t )age_us;
+                    estimate.noise = noise;
+                    if ( !_unit_enviii_planner_meets( &request->pressure, &estimate ) )
+                        continue;
+
+                    uint64_t total_na = sensor_na + access / interval_us;
+                    if ( !_unit_enviii_planner_better( total_na, estimate.latency_us, best_na, best.pressure.latency_us, found ) )
+                        continue;
+
+                    found = true;
+                    best_na = total_na;
+                    best.pressure_mode = mode;
+                    best.oversampling = oversampling;
+                    best.filter = filter;
+                    best.pressure_standby_us = standby_us;
+                    best.pressure = estimate;
+                }
+            }
+        }
+    }
+
+    if ( !found )
+        return false;
+
+    config->pressure_mode = best.pressure_mode;
+    config->oversampling = best.oversampling;
+    config->filter = best.filter;
+    config->pressure_standby_us = best.pressure_standby_us;
+    config->pressure = best.pressure;
+    *current_na = best_na;
+
+    return true;
+}
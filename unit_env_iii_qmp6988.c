@@ -0,0 +1,325 @@
+/*!
+ * @brief QMP6988 pressure backend of the ENV III unit
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_log.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "i2cdev.h"
+#include "unit_env_iii_backend.h"
+#include "unit_env_iii_noheap.h"
+
+#if UNIT_ENVIII_BACKEND_QMP6988
+
+#define QMP6988_SLAVE_ADDRESS_L (0x70)
+#define QMP6988_SLAVE_ADDRESS_H (0x56)
+
+#define QMP6988_U16_t unsigned short
+#define QMP6988_S16_t short
+#define QMP6988_U32_t unsigned int
+#define QMP6988_S32_t int
+#define QMP6988_U64_t unsigned long long
+#define QMP6988_S64_t long long
+
+#define QMP6988_CHIP_ID 0x5C
+
+#define QMP6988_CHIP_ID_REG     0xD1
+#define QMP6988_RESET_REG       0xE0 /* Device reset register */
+#define QMP6988_DEVICE_STAT_REG 0xF3 /* Device state register */
+#define QMP6988_CTRLMEAS_REG    0xF4 /* Measurement Condition Control Register */
+#define QMP6988_IO_SETUP_REG    0xF5 /* Standby time and interface setup Register */
+/* data */
+#define QMP6988_PRESSURE_MSB_REG    0xF7 /* Pressure MSB Register */
+#define QMP6988_TEMPERATURE_MSB_REG 0xFA /* Temperature MSB Reg */
+
+/* compensation calculation */
+#define QMP6988_CALIBRATION_DATA_START \
+    0xA0 /* QMP6988 compensation coefficients */
+#define QMP6988_CALIBRATION_DATA_LENGTH 25
+
+#define SHIFT_RIGHT_4_POSITION 4
+#define SHIFT_LEFT_2_POSITION  2
+#define SHIFT_LEFT_4_POSITION  4
+#define SHIFT_LEFT_5_POSITION  5
+#define SHIFT_LEFT_8_POSITION  8
+#define SHIFT_LEFT_12_POSITION 12
+#define SHIFT_LEFT_16_POSITION 16
+
+/* power mode */
+#define QMP6988_SLEEP_MODE  0x00
+#define QMP6988_FORCED_MODE 0x01
+#define QMP6988_NORMAL_MODE 0x03
+
+#define QMP6988_CTRLMEAS_REG_MODE__POS 0
+#define QMP6988_CTRLMEAS_REG_MODE__MSK 0x03
+#define QMP6988_CTRLMEAS_REG_MODE__LEN 2
+
+#define QMP6988_IO_SETUP_REG_STANDBY__POS 5
+
+/* oversampling */
+#define QMP6988_OVERSAMPLING_SKIPPED 0x00
+#define QMP6988_OVERSAMPLING_1X      0x01
+#define QMP6988_OVERSAMPLING_2X      0x02
+#define QMP6988_OVERSAMPLING_4X      0x03
+#define QMP6988_OVERSAMPLING_8X      0x04
+#define QMP6988_OVERSAMPLING_16X     0x05
+#define QMP6988_OVERSAMPLING_32X     0x06
+#define QMP6988_OVERSAMPLING_64X     0x07
+
+/* the compensation needs one temperature conversion per pressure
+ * conversion, more temperature samples only add conversion time */
+#define QMP6988_TEMPERATURE_OVERSAMPLING QMP6988_OVERSAMPLING_1X
+
+#define QMP6988_CTRLMEAS_REG_OSRST__POS 5
+#define QMP6988_CTRLMEAS_REG_OSRST__MSK 0xE0
+#define QMP6988_CTRLMEAS_REG_OSRST__LEN 3
+
+#define QMP6988_CTRLMEAS_REG_OSRSP__POS 2
+#define QMP6988_CTRLMEAS_REG_OSRSP__MSK 0x1C
+#define QMP6988_CTRLMEAS_REG_OSRSP__LEN 3
+
+/* filter */
+#define QMP6988_FILTERCOEFF_OFF 0x00
+#define QMP6988_FILTERCOEFF_2   0x01
+#define QMP6988_FILTERCOEFF_4   0x02
+#define QMP6988_FILTERCOEFF_8   0x03
+#define QMP6988_FILTERCOEFF_16  0x04
+#define QMP6988_FILTERCOEFF_32  0x05
+
+#define QMP6988_CONFIG_REG             0xF1 /*IIR filter co-efficient setting Register*/
+#define QMP6988_CONFIG_REG_FILTER__POS 0
+#define QMP6988_CONFIG_REG_FILTER__MSK 0x07
+#define QMP6988_CONFIG_REG_FILTER__LEN 3
+
+#define SUBTRACTOR 8388608
+
+typedef struct _qmp6988_cali_data {
+    QMP6988_S32_t COE_a0;
+    QMP6988_S16_t COE_a1;
+    QMP6988_S16_t COE_a2;
+    QMP6988_S32_t COE_b00;
+    QMP6988_S16_t COE_bt1;
+    QMP6988_S16_t COE_bt2;
+    QMP6988_S16_t COE_bp1;
+    QMP6988_S16_t COE_b11;
+    QMP6988_S16_t COE_bp2;
+    QMP6988_S16_t COE_b12;
+    QMP6988_S16_t COE_b21;
+    QMP6988_S16_t COE_bp3;
+} qmp6988_cali_data_t;
+
+typedef struct _qmp6988_ik_data {
+    QMP6988_S32_t a0, b00;
+    QMP6988_S32_t a1, a2;
+    QMP6988_S64_t bt1, bt2, bp1, b11, bp2, b12, b21, bp3;
+} qmp6988_ik_data_t;
+
+#define QMP6988_RESET_CMD           0xE6
+#define QMP6988_RESET_DURATION      20      /* ms */
+#define QMP6988_RAW_DATA_SIZE       6
+
+#define QMP6988_CHANNELS            UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_PRESSURE )
+
+#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
+
+static QMP6988_S16_t _unit_enviii_qmp6988_temperature( QMP6988_S32_t dt );
+static QMP6988_S32_t _unit_enviii_qmp6988_pressure( QMP6988_S32_t dp, QMP6988_S16_t tx );
+static i2c_dev_t _dev;
+static qmp6988_ik_data_t _ik;
+static uint8_t _raw_data[ QMP6988_RAW_DATA_SIZE ];
+static const char *_TAG = "UNIT_ENV_III_QMP6988";
+
+const unit_enviii_backend_t unit_enviii_backend_qmp6988 = {
+    .name = "QMP6988",
+    .channels = QMP6988_CHANNELS,
+    .init = unit_enviii_qmp6988_init,
+    .trigger = unit_enviii_qmp6988_trigger,
+    .duration_get = unit_enviii_qmp6988_duration_get,
+    .fetch = unit_enviii_qmp6988_fetch,
+    .compensate = unit_enviii_qmp6988_compensate
+};
+
+esp_err_t unit_enviii_qmp6988_init( void )
+{
+    uint8_t value;
+    uint8_t cali[ QMP6988_CALIBRATION_DATA_LENGTH ];
+    qmp6988_cali_data_t coe;
+
+    memset( &_dev, 0, sizeof( i2c_dev_t ) );
+    _dev.port = COMMON_I2C_EXTERNAL;
+    _dev.addr = UNIT_ENVIII_QMP6988_I2C_ADDR;
+    _dev.cfg.sda_io_num = PORT_A_SDA_PIN;
+    _dev.cfg.scl_io_num = PORT_A_SCL_PIN;
+    _dev.cfg.master.clk_speed = UNIT_ENVIII_I2C_FREQ_HZ;
+    CHECK( i2c_dev_create_mutex( &_dev ) );
+    ESP_LOGD( _TAG, "Setting QMP6988 initial device descriptor success" );
+
+    CHECK( i2c_dev_read_reg( &_dev, QMP6988_CHIP_ID_REG, &value, 1 ) );
+    if ( value != QMP6988_CHIP_ID )
+    {
+        ESP_LOGE( _TAG, "Unexpected QMP6988 chip id 0x%02x", value );
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    value = QMP6988_RESET_CMD;
+    CHECK( i2c_dev_write_reg( &_dev, QMP6988_RESET_REG, &value, 1 ) );
+    vTaskDelay( pdMS_TO_TICKS( QMP6988_RESET_DURATION ) + 1 );
+    value = 0;
+    CHECK( i2c_dev_write_reg( &_dev, QMP6988_RESET_REG, &value, 1 ) );
+
+    CHECK( i2c_dev_read_reg( &_dev, QMP6988_CALIBRATION_DATA_START, cali, QMP6988_CALIBRATION_DATA_LENGTH ) );
+
+    // 20 bit coefficients are sign extended from bit 19
+    coe.COE_a0 = ( QMP6988_S32_t )( ( ( ( QMP6988_U32_t )cali[ 18 ] << SHIFT_LEFT_12_POSITION ) |
+                                      ( cali[ 19 ] << SHIFT_LEFT_4_POSITION ) | ( cali[ 24 ] & 0x0F ) ) << 12 ) >> 12;
+    coe.COE_a1 = ( QMP6988_S16_t )( ( cali[ 20 ] << SHIFT_LEFT_8_POSITION ) | cali[ 21 ] );
+    coe.COE_a2 = ( QMP6988_S16_t )( ( cali[ 22 ] << SHIFT_LEFT_8_POSITION ) | cali[ 23 ] );
+    coe.COE_b00 = ( QMP6988_S32_t )( ( ( ( QMP6988_U32_t )cali[ 0 ] << SHIFT_LEFT_12_POSITION ) |
+                                       ( cali[ 1 ] << SHIFT_LEFT_4_POSITION ) | ( ( cali[ 24 ] & 0xF0 ) >> SHIFT_RIGHT_4_POSITION ) ) << 12 ) >> 12;
+    coe.COE_bt1 = ( QMP6988_S16_t )( ( cali[ 2 ] << SHIFT_LEFT_8_POSITION ) | cali[ 3 ] );
+    coe.COE_bt2 = ( QMP6988_S16_t )( ( cali[ 4 ] << SHIFT_LEFT_8_POSITION ) | cali[ 5 ] );
+    coe.COE_bp1 = ( QMP6988_S16_t )( ( cali[ 6 ] << SHIFT_LEFT_8_POSITION ) | cali[ 7 ] );
+    coe.COE_b11 = ( QMP6988_S16_t )( ( cali[ 8 ] << SHIFT_LEFT_8_POSITION ) | cali[ 9 ] );
+    coe.COE_bp2 = ( QMP6988_S16_t )( ( cali[ 10 ] << SHIFT_LEFT_8_POSITION ) | cali[ 11 ] );
+    coe.COE_b12 = ( QMP6988_S16_t )( ( cali[ 12 ] << SHIFT_LEFT_8_POSITION ) | cali[ 13 ] );
+    coe.COE_b21 = ( QMP6988_S16_t )( ( cali[ 14 ] << SHIFT_LEFT_8_POSITION ) | cali[ 15 ] );
+    coe.COE_bp3 = ( QMP6988_S16_t )( ( cali[ 16 ] << SHIFT_LEFT_8_POSITION ) | cali[ 17 ] );
+
+    // integer conversion factors from the QMP6988 datasheet, Q formats in the comments
+    _ik.a0 = coe.COE_a0;                                        // 20Q4
+    _ik.b00 = coe.COE_b00;                                      // 20Q4
+    _ik.a1 = 3608L * ( QMP6988_S32_t )coe.COE_a1 - 1731677965L; // 31Q23
+    _ik.a2 = 16889L * ( QMP6988_S32_t )coe.COE_a2 - 87619360L;  // 30Q47
+    _ik.bt1 = 2982LL * coe.COE_bt1 + 107370906LL;               // 28Q15
+    _ik.bt2 = 329854LL * coe.COE_bt2 + 108083093LL;             // 34Q38
+    _ik.bp1 = 19923LL * coe.COE_bp1 + 1133836764LL;             // 31Q20
+    _ik.b11 = 2406LL * coe.COE_b11 + 118215883LL;               // 28Q34
+    _ik.bp2 = 3079LL * coe.COE_bp2 - 181579595LL;               // 29Q43
+    _ik.b12 = 6846LL * coe.COE_b12 + 85590281LL;                // 29Q53
+    _ik.b21 = 13836LL * coe.COE_b21 + 79333336LL;               // 29Q60
+    _ik.bp3 = 2915LL * coe.COE_bp3 + 157155561LL;               // 28Q65
+
+    // configured IIR filter, standby and pressure oversampling, temperature 1x, free running
+    value = UNIT_ENVIII_PRESSURE_FILTER << QMP6988_CONFIG_REG_FILTER__POS;
+    CHECK( i2c_dev_write_reg( &_dev, QMP6988_CONFIG_REG, &value, 1 ) );
+    value = UNIT_ENVIII_PRESSURE_STANDBY << QMP6988_IO_SETUP_REG_STANDBY__POS;
+    CHECK( i2c_dev_write_reg( &_dev, QMP6988_IO_SETUP_REG, &value, 1 ) );
+    value = ( QMP6988_TEMPERATURE_OVERSAMPLING << QMP6988_CTRLMEAS_REG_OSRST__POS ) |
+            ( UNIT_ENVIII_PRESSURE_OVERSAMPLING << QMP6988_CTRLMEAS_REG_OSRSP__POS ) |
+            ( QMP6988_NORMAL_MODE << QMP6988_CTRLMEAS_REG_MODE__POS );
+    CHECK( i2c_dev_write_reg( &_dev, QMP6988_CTRLMEAS_REG, &value, 1 ) );
+    ESP_LOGD( _TAG, "Initializing QMP6988 sensor success" );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_qmp6988_trigger( void )
+{
+    // normal mode converts continuously
+    return ESP_OK;
+}
+
+uint8_t unit_enviii_qmp6988_duration_get( void )
+{
+    return 0;
+}
+
+esp_err_t unit_enviii_qmp6988_fetch( void )
+{
+    return i2c_dev_read_reg( &_dev, QMP6988_PRESSURE_MSB_REG, _raw_data, QMP6988_RAW_DATA_SIZE );
+}
+
+UNIT_ENVIII_HOT_ATTR esp_err_t unit_enviii_qmp6988_compensate( unit_enviii_sample_t *sample )
+{
+    return unit_enviii_qmp6988_decode( _raw_data, sample );
+}
+
+UNIT_ENVIII_HOT_ATTR esp_err_t unit_enviii_qmp6988_decode( const uint8_t *raw, unit_enviii_sample_t *sample )
+{
+    if ( raw == NULL || sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    QMP6988_S32_t dp = ( QMP6988_S32_t )( ( ( QMP6988_U32_t )raw[ 0 ] << SHIFT_LEFT_16_POSITION ) |
+                                          ( raw[ 1 ] << SHIFT_LEFT_8_POSITION ) | raw[ 2 ] ) - SUBTRACTOR;
+    QMP6988_S32_t dt = ( QMP6988_S32_t )( ( ( QMP6988_U32_t )raw[ 3 ] << SHIFT_LEFT_16_POSITION ) |
+                                          ( raw[ 4 ] << SHIFT_LEFT_8_POSITION ) | raw[ 5 ] ) - SUBTRACTOR;
+    QMP6988_S32_t pressure = _unit_enviii_qmp6988_pressure( dp, _unit_enviii_qmp6988_temperature( dt ) );
+
+    // Pa in Q4 to 0.1 Pa
+    sample->value[ UNIT_ENVIII_CHANNEL_PRESSURE ] = ( pressure * 10 + 8 ) / 16;
+    sample->channels |= QMP6988_CHANNELS;
+
+    return ESP_OK;
+}
+
+/* Temperature in 1/256 degree Celsius */
+static UNIT_ENVIII_HOT_ATTR QMP6988_S16_t _unit_enviii_qmp6988_temperature( QMP6988_S32_t dt )
+{
+    QMP6988_S64_t wk1, wk2;
+
+    wk1 = ( QMP6988_S64_t )_ik.a1 * dt;                     // 54Q23
+    wk2 = ( ( QMP6988_S64_t )_ik.a2 * dt ) >> 14;           // 39Q33
+    wk2 = ( wk2 * dt ) >> 10;                               // 52Q23
+    wk2 = ( ( wk1 + wk2 ) / 32767 ) >> 19;                  // 20Q4
+
+    return ( QMP6988_S16_t )( ( _ik.a0 + wk2 ) >> 4 );
+}
+
+/* Pressure in Pa Q4 */
+static UNIT_ENVIII_HOT_ATTR QMP6988_S32_t _unit_enviii_qmp6988_pressure( QMP6988_S32_t dp, QMP6988_S16_t tx )
+{
+    QMP6988_S64_t wk1, wk2, wk3;
+
+    wk1 = _ik.bt1 * tx;                                     // 43Q15
+    wk2 = ( _ik.bp1 * dp ) >> 5;                            // 49Q15
+    wk1 += wk2;                                             // 50Q15
+    wk2 = ( _ik.bt2 * tx ) >> 1;                            // 48Q37
+    wk2 = ( wk2 * tx ) >> 8;                                // 55Q29
+    wk3 = wk2;
+    wk2 = ( _ik.b11 * tx ) >> 4;                            // 39Q30
+    wk2 = ( wk2 * dp ) >> 1;                                // 61Q29
+    wk3 += wk2;
+    wk2 = ( _ik.bp2 * dp ) >> 13;                           // 39Q30
+    wk2 = ( wk2 * dp ) >> 1;                                // 61Q29
+    wk3 += wk2;                                             // 63Q29
+    wk1 += wk3 >> 14;                                       // Q15
+    wk2 = _ik.b12 * tx;                                     // 45Q53
+    wk2 = ( wk2 * tx ) >> 22;                               // 39Q31
+    wk2 = ( wk2 * dp ) >> 1;                                // 61Q30
+    wk3 = wk2;
+    wk2 = ( _ik.b21 * tx ) >> 6;                            // 39Q54
+    wk2 = ( wk2 * dp ) >> 23;                               // 39Q31
+    wk2 = ( wk2 * dp ) >> 1;                                // 61Q30
+    wk3 += wk2;
+    wk2 = ( _ik.bp3 * dp ) >> 12;                           // 40Q53
+    wk2 = ( wk2 * dp ) >> 23;                               // 40Q30
+    wk2 = wk2 * dp;                                         // 62Q30
+    wk3 += wk2;                                             // 63Q30
+    wk1 += wk3 >> 15;                                       // Q15
+    wk1 /= 32767L;
+    wk1 >>= 11;                                             // Q4
+    wk1 += _ik.b00;                                         // 20Q4
+
+    return ( QMP6988_S32_t )wk1;
+}
+
+#endif
@@ -0,0 +1,159 @@
+/*!
+ * @brief Model based reporting of ENV III samples
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_log.h>
+#include "unit_env_iii_report.h"
+#include "unit_env_iii_noheap.h"
+
+#define REPORT_MS_PER_HOUR  3600000LL
+
+static int32_t _unit_enviii_report_slope( const unit_enviii_report_model_t *model, int64_t timestamp_us, int32_t value );
+static const char *_TAG = "UNIT_ENV_III_REPORT";
+
+esp_err_t unit_enviii_report_init( unit_enviii_report_t *report, const unit_enviii_report_config_t *config )
+{
+    if ( report == NULL || config == NULL || config->publish == NULL || config->mode > UNIT_ENVIII_REPORT_PREDICTIVE ||
+         ( config->channels & ~UNIT_ENVIII_CHANNEL_ALL ) != 0 )
+        return ESP_ERR_INVALID_ARG;
+
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        if ( config->tolerance[ channel ] < 0 )
+            return ESP_ERR_INVALID_ARG;
+    }
+
+    memset( report, 0, sizeof( unit_enviii_report_t ) );
+    report->config = *config;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_report_stage_process( unit_enviii_sample_t *sample, void *context )
+{
+    unit_enviii_report_t *report = ( unit_enviii_report_t * )context;
+    unit_enviii_report_update_t update = { 0 };
+    int32_t predicted;
+    uint8_t values = 0;
+
+    if ( sample == NULL || report == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    uint32_t channels = sample->channels & report->config.channels;
+    if ( channels == 0 )
+        return ESP_OK;
+
+    report->samples++;
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        const unit_enviii_report_model_t *model = &report->state.model[ channel ];
+        int32_t value = sample->value[ channel ];
+        bool due;
+
+        if ( !( channels & UNIT_ENVIII_CHANNEL_BIT( channel ) ) )
+            continue;
+
+        int64_t elapsed_us = sample->timestamp_us - model->timestamp_us;
+        if ( !( report->state.channels & UNIT_ENVIII_CHANNEL_BIT( channel ) ) )
+            due = true;
+        else if ( report->config.heartbeat_ms > 0 && elapsed_us >= ( int64_t )report->config.heartbeat_ms * 1000 )
+            due = true;
+        else if ( report->config.mode == UNIT_ENVIII_REPORT_FIXED )
+            due = elapsed_us >= ( int64_t )report->config.interval_ms * 1000;
+        else
+        {
+            // a deadband model has no slope and predicts the value reported
+            unit_enviii_report_predict( model, sample->timestamp_us, &predicted );
+            int64_t error = ( int64_t )value - predicted;
+            due = error > report->config.tolerance[ channel ] || -error > report->config.tolerance[ channel ];
+        }
+        if ( !due )
+            continue;
+
+        update.channels |= UNIT_ENVIII_CHANNEL_BIT( channel );
+        values++;
+        update.model[ channel ].timestamp_us = sample->timestamp_us;
+        update.model[ channel ].value = value;
+        // the slope of the last stretch is the best guess for the next one
+        if ( report->config.mode == UNIT_ENVIII_REPORT_PREDICTIVE && ( report->state.channels & UNIT_ENVIII_CHANNEL_BIT( channel ) ) )
+            update.model[ channel ].slope = _unit_enviii_report_slope( model, sample->timestamp_us, value );
+    }
+    if ( update.channels == 0 )
+        return ESP_OK;
+
+    esp_err_t err = report->config.publish( &update, report->config.user );
+    if ( err != ESP_OK )
+    {
+        report->failures++;
+        ESP_LOGD( _TAG, "Update of channels 0x%x failed", ( unsigned )update.channels );
+        return err;
+    }
+    unit_enviii_report_apply( &report->state, &update );
+    report->updates++;
+    report->values += values;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_report_predict( const unit_enviii_report_model_t *model, int64_t timestamp_us, int32_t *value )
+{
+    if ( model == NULL || value == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    // milliseconds keep slope times elapsed in range for years
+    int64_t elapsed_ms = ( timestamp_us - model->timestamp_us ) / 1000;
+    int64_t change = ( int64_t )model->slope * elapsed_ms;
+    change = ( change >= 0 ) ? ( change + REPORT_MS_PER_HOUR / 2 ) / REPORT_MS_PER_HOUR : ( change - REPORT_MS_PER_HOUR / 2 ) / REPORT_MS_PER_HOUR;
+    int64_t predicted = model->value + change;
+
+    *value = ( predicted > INT32_MAX ) ? INT32_MAX : ( predicted < INT32_MIN ) ? INT32_MIN : ( int32_t )predicted;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_report_apply( unit_enviii_report_update_t *state, const unit_enviii_report_update_t *update )
+{
+    if ( state == NULL || update == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        if ( update->channels & UNIT_ENVIII_CHANNEL_BIT( channel ) )
+            state->model[ channel ] = update->model[ channel ];
+    }
+    state->channels |= update->channels & UNIT_ENVIII_CHANNEL_ALL;
+
+    return ESP_OK;
+}
+
+/* Change per hour between the reported value and the new one */
+static int32_t _unit_enviii_report_slope( const unit_enviii_report_model_t *model, int64_t timestamp_us, int32_t value )
+{
+    int64_t elapsed_ms = ( timestamp_us - model->timestamp_us ) / 1000;
+
+    if ( elapsed_ms <= 0 )
+        return 0;
+
+    int64_t slope = ( ( int64_t )value - model->value ) * REPORT_MS_PER_HOUR / elapsed_ms;
+
+    return ( slope > INT32_MAX ) ? INT32_MAX : ( slope < INT32_MIN ) ? INT32_MIN : ( int32_t )slope;
+}
@@ -0,0 +1,159 @@
+/*!
+ * @brief Resampling of the ENV III sensor channels onto a common time grid
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include "unit_env_iii_resample.h"
+#include "unit_env_iii_noheap.h"
+
+#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
+
+static esp_err_t _unit_enviii_resample_start( unit_enviii_resample_t *resample );
+static esp_err_t _unit_enviii_resample_fill( unit_enviii_resample_t *resample, uint8_t channel, int64_t timestamp_us, int32_t value );
+static esp_err_t _unit_enviii_resample_emit( unit_enviii_resample_t *resample );
+
+esp_err_t unit_enviii_resample_init( unit_enviii_resample_t *resample, uint32_t channels, uint32_t step_ms, unit_enviii_resample_emit_t emit, void *user )
+{
+    if ( resample == NULL || channels == 0 || ( channels & ~UNIT_ENVIII_CHANNEL_ALL ) || step_ms == 0 || emit == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    memset( resample, 0, sizeof( unit_enviii_resample_t ) );
+    resample->channels = channels;
+    resample->step_us = ( int64_t )step_ms * 1000;
+    resample->emit = emit;
+    resample->user = user;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_resample_stage_process( unit_enviii_sample_t *sample, void *context )
+{
+    unit_enviii_resample_t *resample = ( unit_enviii_resample_t * )context;
+
+    if ( sample == NULL || resample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    uint32_t channels = resample->channels & sample->channels;
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        if ( !( channels & UNIT_ENVIII_CHANNEL_BIT( channel ) ) )
+            continue;
+
+        unit_enviii_resample_channel_t *state = &resample->channel[ channel ];
+        if ( resample->started && sample->timestamp_us > state->last_us )
+            CHECK( _unit_enviii_resample_fill( resample, channel, sample->timestamp_us, sample->value[ channel ] ) );
+        state->last_us = sample->timestamp_us;
+        state->last_value = sample->value[ channel ];
+        state->seen = true;
+    }
+
+    if ( !resample->started )
+        return _unit_enviii_resample_start( resample );
+
+    // rows every channel has a value for
+    for ( ;; )
+    {
+        for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+        {
+            if ( ( resample->channels & UNIT_ENVIII_CHANNEL_BIT( channel ) ) && resample->channel[ channel ].count == 0 )
+                return ESP_OK;
+        }
+        CHECK( _unit_enviii_resample_emit( resample ) );
+    }
+}
+
+/* The grid starts at the first instant after the latest first sample, so
+ * every channel has a sample before each instant to interpolate from */
+static esp_err_t _unit_enviii_resample_start( unit_enviii_resample_t *resample )
+{
+    int64_t latest = INT64_MIN;
+
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        if ( !( resample->channels & UNIT_ENVIII_CHANNEL_BIT( channel ) ) )
+            continue;
+        if ( !resample->channel[ channel ].seen )
+            return ESP_OK;
+        if ( resample->channel[ channel ].last_us > latest )
+            latest = resample->channel[ channel ].last_us;
+    }
+
+    int64_t floor_us = latest - ( ( latest % resample->step_us ) + resample->step_us ) % resample->step_us;
+    resample->next_us = floor_us + resample->step_us;
+    resample->started = true;
+
+    return ESP_OK;
+}
+
+/* Interpolate the channel at the grid instants between its last sample and this one */
+static esp_err_t _unit_enviii_resample_fill( unit_enviii_resample_t *resample, uint8_t channel, int64_t timestamp_us, int32_t value )
+{
+    unit_enviii_resample_channel_t *state = &resample->channel[ channel ];
+    int64_t span = timestamp_us - state->last_us;
+
+    for ( ;; )
+    {
+        int64_t instant = resample->next_us + ( int64_t )state->count * resample->step_us;
+        if ( instant > timestamp_us )
+            return ESP_OK;
+
+        // no room left, the oldest row goes out without the channels still missing
+        if ( state->count == UNIT_ENVIII_RESAMPLE_DEPTH )
+        {
+            CHECK( _unit_enviii_resample_emit( resample ) );
+            continue;
+        }
+
+        // rounded to the nearest step of the channel unit
+        int64_t delta = ( ( int64_t )value - state->last_value ) * ( instant - state->last_us );
+        delta = ( delta >= 0 ) ? ( delta + span / 2 ) / span : ( delta - span / 2 ) / span;
+        int32_t interpolated = state->last_value + ( int32_t )delta;
+        state->value[ ( state->head + state->count ) % UNIT_ENVIII_RESAMPLE_DEPTH ] = interpolated;
+        state->count++;
+    }
+}
+
+/* Emit the row of the oldest pending instant with the channels holding a value for it */
+static esp_err_t _unit_enviii_resample_emit( unit_enviii_resample_t *resample )
+{
+    unit_enviii_sample_t row;
+
+    memset( &row, 0, sizeof( unit_enviii_sample_t ) );
+    row.timestamp_us = resample->next_us;
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        unit_enviii_resample_channel_t *state = &resample->channel[ channel ];
+
+        if ( !( resample->channels & UNIT_ENVIII_CHANNEL_BIT( channel ) ) || state->count == 0 )
+            continue;
+        row.value[ channel ] = state->value[ state->head ];
+        row.channels |= UNIT_ENVIII_CHANNEL_BIT( channel );
+        state->head = ( state->head + 1 ) % UNIT_ENVIII_RESAMPLE_DEPTH;
+        state->count--;
+    }
+
+    resample->next_us += resample->step_us;
+    resample->rows++;
+    if ( row.channels != resample->channels )
+        resample->partial++;
+
+    return resample->emit( &row, resample->user );
+}
@@ -0,0 +1,256 @@
+/*!
+ * @brief Threshold and trend alert rules evaluated per ENV III sample
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_log.h>
+#include "unit_env_iii_rules.h"
+#include "unit_env_iii_noheap.h"
+
+/* opcodes, below/drop rules are compiled to negated loads so every rule is a greater-than test */
+#define RULES_OP_VALUE          0x01
+#define RULES_OP_NEG_VALUE      0x02
+#define RULES_OP_DELTA          0x03
+#define RULES_OP_NEG_DELTA      0x04
+
+/* instruction word layout */
+#define RULES_WORD_OP           0
+#define RULES_WORD_SET          1
+#define RULES_WORD_CLEAR        2
+#define RULES_WORD_DURATION     3
+
+#define RULES_NOT_PENDING       INT64_MIN
+#define RULES_MAX_DURATION_S    ( INT32_MAX / 1000 )
+
+static esp_err_t _unit_enviii_rules_trend_get( unit_enviii_rules_program_t *program, unit_enviii_channel_t channel, uint32_t window_s, uint8_t *trend );
+static void _unit_enviii_rules_trend_update( unit_enviii_rules_t *rules, const unit_enviii_sample_t *sample, int32_t *delta );
+static const char *_TAG = "UNIT_ENV_III_RULES";
+
+static esp_err_t _unit_enviii_rules_trend_get( unit_enviii_rules_program_t *program, unit_enviii_channel_t channel, uint32_t window_s, uint8_t *trend )
+{
+    int64_t interval_us = ( int64_t )window_s * 1000000 / UNIT_ENVIII_RULES_TREND_POINTS;
+
+    for ( uint8_t i = 0; i < program->trend_count; i++ )
+    {
+        if ( program->trend_channel[ i ] == channel && program->trend_interval_us[ i ] == interval_us )
+        {
+            *trend = i;
+            return ESP_OK;
+        }
+    }
+
+    if ( program->trend_count >= UNIT_ENVIII_RULES_MAX_TRENDS )
+        return ESP_ERR_NO_MEM;
+
+    *trend = program->trend_count++;
+    program->trend_channel[ *trend ] = channel;
+    program->trend_interval_us[ *trend ] = interval_us;
+
+    return ESP_OK;
+}
+
+static void _unit_enviii_rules_trend_update( unit_enviii_rules_t *rules, const unit_enviii_sample_t *sample, int32_t *delta )
+{
+    unit_enviii_rules_program_t *program = &rules->program;
+    unit_enviii_rules_state_t *state = &rules->state;
+
+    for ( uint8_t i = 0; i < program->trend_count; i++ )
+    {
+        uint8_t channel = program->trend_channel[ i ];
+        if ( !( sample->channels & UNIT_ENVIII_CHANNEL_BIT( channel ) ) )
+            continue;
+
+        int32_t value = sample->value[ channel ];
+
+        // checkpoint every window / UNIT_ENVIII_RULES_TREND_POINTS, the extra slot
+        // makes the oldest checkpoint at least one full window old once filled
+        if ( state->trend_fill[ i ] == 0 || sample->timestamp_us >= state->trend_next_us[ i ] )
+        {
+            uint8_t slot = ( state->trend_head[ i ] + state->trend_fill[ i ] ) % ( UNIT_ENVIII_RULES_TREND_POINTS + 1 );
+            state->trend_point[ i ][ slot ] = value;
+            if ( state->trend_fill[ i ] <= UNIT_ENVIII_RULES_TREND_POINTS )
+                state->trend_fill[ i ]++;
+            else
+                state->trend_head[ i ] = ( state->trend_head[ i ] + 1 ) % ( UNIT_ENVIII_RULES_TREND_POINTS + 1 );
+            state->trend_next_us[ i ] = sample->timestamp_us + program->trend_interval_us[ i ];
+        }
+
+        delta[ i ] = value - state->trend_point[ i ][ state->trend_head[ i ] ];
+    }
+}
+
+esp_err_t unit_enviii_rules_compile( unit_enviii_rules_t *rules, const unit_enviii_rule_t *definitions, uint16_t count )
+{
+    if ( rules == NULL || ( definitions == NULL && count > 0 ) )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( count > UNIT_ENVIII_RULES_MAX )
+    {
+        ESP_LOGE( _TAG, "%u rules exceed the maximum of %u", count, UNIT_ENVIII_RULES_MAX );
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset( rules, 0, sizeof( unit_enviii_rules_t ) );
+
+    for ( uint16_t i = 0; i < count; i++ )
+    {
+        const unit_enviii_rule_t *rule = &definitions[ i ];
+        int32_t *code = &rules->program.code[ i * UNIT_ENVIII_RULES_WORDS ];
+        uint8_t opcode, trend = 0;
+        int64_t threshold = rule->threshold;
+
+        if ( rule->channel >= UNIT_ENVIII_CHANNEL_MAX || rule->hysteresis < 0 || rule->duration_s > RULES_MAX_DURATION_S )
+        {
+            ESP_LOGE( _TAG, "Invalid definition for rule %u", i );
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        switch ( rule->type )
+        {
+            case UNIT_ENVIII_RULE_ABOVE:
+                opcode = RULES_OP_VALUE;
+                break;
+            case UNIT_ENVIII_RULE_BELOW:
+                opcode = RULES_OP_NEG_VALUE;
+                threshold = -threshold;
+                break;
+            case UNIT_ENVIII_RULE_RISE:
+            case UNIT_ENVIII_RULE_DROP:
+                if ( rule->window_s == 0 )
+                {
+                    ESP_LOGE( _TAG, "Rule %u needs a window", i );
+                    return ESP_ERR_INVALID_ARG;
+                }
+                if ( _unit_enviii_rules_trend_get( &rules->program, rule->channel, rule->window_s, &trend ) != ESP_OK )
+                {
+                    ESP_LOGE( _TAG, "No free change tracker for rule %u", i );
+                    return ESP_ERR_NO_MEM;
+                }
+                opcode = ( rule->type == UNIT_ENVIII_RULE_RISE ) ? RULES_OP_DELTA : RULES_OP_NEG_DELTA;
+                break;
+            default:
+                ESP_LOGE( _TAG, "Invalid type for rule %u", i );
+                return ESP_ERR_INVALID_ARG;
+        }
+
+        int64_t clear = threshold - rule->hysteresis;
+        if ( threshold > INT32_MAX || clear < INT32_MIN )
+        {
+            ESP_LOGE( _TAG, "Threshold out of range for rule %u", i );
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        code[ RULES_WORD_OP ] = opcode | ( rule->channel << 8 ) | ( trend << 16 );
+        code[ RULES_WORD_SET ] = ( int32_t )threshold;
+        code[ RULES_WORD_CLEAR ] = ( int32_t )clear;
+        code[ RULES_WORD_DURATION ] = ( int32_t )( rule->duration_s * 1000 );
+        rules->state.since_us[ i ] = RULES_NOT_PENDING;
+    }
+    rules->program.count = count;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_rules_evaluate( unit_enviii_rules_t *rules, unit_enviii_sample_t *sample )
+{
+    int32_t delta[ UNIT_ENVIII_RULES_MAX_TRENDS ];
+    bool changed = false;
+
+    if ( rules == NULL || sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    _unit_enviii_rules_trend_update( rules, sample, delta );
+
+    const int32_t *code = rules->program.code;
+    unit_enviii_rules_state_t *state = &rules->state;
+    int64_t now = sample->timestamp_us;
+
+    for ( uint16_t i = 0; i < rules->program.count; i++, code += UNIT_ENVIII_RULES_WORDS )
+    {
+        uint32_t op = ( uint32_t )code[ RULES_WORD_OP ];
+        uint8_t channel = ( op >> 8 ) & 0xFF;
+        uint8_t trend = ( op >> 16 ) & 0xFF;
+        int32_t value;
+
+        if ( !( sample->channels & UNIT_ENVIII_CHANNEL_BIT( channel ) ) )
+            continue;
+
+        switch ( op & 0xFF )
+        {
+            case RULES_OP_VALUE:        value = sample->value[ channel ]; break;
+            case RULES_OP_NEG_VALUE:    value = -sample->value[ channel ]; break;
+            case RULES_OP_DELTA:        value = delta[ trend ]; break;
+            default:                    value = -delta[ trend ]; break;
+        }
+
+        uint32_t bit = 1UL << ( i & 31 );
+        bool active = state->active[ i >> 5 ] & bit;
+
+        if ( value <= code[ active ? RULES_WORD_CLEAR : RULES_WORD_SET ] )
+        {
+            state->since_us[ i ] = RULES_NOT_PENDING;
+            if ( active )
+            {
+                state->active[ i >> 5 ] &= ~bit;
+                changed = true;
+            }
+            continue;
+        }
+        if ( active )
+            continue;
+
+        if ( state->since_us[ i ] == RULES_NOT_PENDING )
+            state->since_us[ i ] = now;
+        if ( now - state->since_us[ i ] >= ( int64_t )code[ RULES_WORD_DURATION ] * 1000 )
+        {
+            state->active[ i >> 5 ] |= bit;
+            changed = true;
+        }
+    }
+
+    for ( uint16_t i = 0; i < ( UNIT_ENVIII_RULES_MAX + 31 ) / 32; i++ )
+    {
+        if ( state->active[ i ] )
+        {
+            sample->flags |= UNIT_ENVIII_SAMPLE_FLAG_RULE_ACTIVE;
+            break;
+        }
+    }
+    if ( changed )
+        sample->flags |= UNIT_ENVIII_SAMPLE_FLAG_RULE_CHANGED;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_rules_active_get( const unit_enviii_rules_t *rules, uint16_t index, bool *active )
+{
+    if ( rules == NULL || active == NULL || index >= rules->program.count )
+        return ESP_ERR_INVALID_ARG;
+
+    *active = rules->state.active[ index >> 5 ] & ( 1UL << ( index & 31 ) );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_rules_stage_process( unit_enviii_sample_t *sample, void *context )
+{
+    return unit_enviii_rules_evaluate( ( unit_enviii_rules_t * )context, sample );
+}
@@ -0,0 +1,185 @@
+/*!
+ * @brief SHT30 temperature and humidity backend of the ENV II and ENV III units
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include "unit_env_iii_backend.h"
+
+#if UNIT_ENVIII_BACKEND_SHT3X
+
+#include "sht3x.h"
+#include "unit_env_iii_noheap.h"
+
+#define REPEATABILITY_MODE              ( ( sht3x_repeat_t )UNIT_ENVIII_SHT_REPEATABILITY )
+#define SHT3X_FETCH_DATA_CMD            0xE000
+#define SHT3X_MEAS_DURATION_REP_HIGH    15
+#define SHT3X_MEAS_DURATION_REP_MEDIUM  6
+#define SHT3X_MEAS_DURATION_REP_LOW     4
+
+#define SHT3X_CHANNELS                  ( UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_TEMPERATURE ) | UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_HUMIDITY ) )
+
+static const uint16_t SHT3X_MEAS_DURATION_US[3];
+static inline uint16_t shuffle(uint16_t val);
+static inline bool is_measuring(sht3x_t *dev);
+static sht3x_t _dev;
+static sht3x_raw_data_t _raw_data;
+static void _unit_enviii_sht3x_convert( const uint8_t *raw, unit_enviii_sample_t *sample );
+static const char *_TAG = "UNIT_ENV_III_SHT3X";
+
+const unit_enviii_backend_t unit_enviii_backend_sht3x = {
+    .name = "SHT30",
+    .channels = SHT3X_CHANNELS,
+    .init = unit_enviii_sht3x_init,
+    .trigger = unit_enviii_sht3x_trigger,
+    .duration_get = unit_enviii_sht3x_duration_get,
+    .fetch = unit_enviii_sht3x_fetch,
+    .compensate = unit_enviii_sht3x_compensate
+};
+
+// measurement durations in us
+static const uint16_t SHT3X_MEAS_DURATION_US[3] = {
+        SHT3X_MEAS_DURATION_REP_HIGH   * 1000,
+        SHT3X_MEAS_DURATION_REP_MEDIUM * 1000,
+        SHT3X_MEAS_DURATION_REP_LOW    * 1000
+};
+
+static inline uint16_t shuffle(uint16_t val)
+{
+    return (val >> 8) | (val << 8);
+}
+
+static inline bool is_measuring(sht3x_t *dev)
+{
+    // not running if measurement is not started at all or
+    // it is not the first measurement in periodic mode
+    if (!dev->meas_started || !dev->meas_first)
+      return false;
+
+    // not running if time elapsed is greater than duration
+    uint64_t elapsed = esp_timer_get_time() - dev->meas_start_time;
+
+    return elapsed < SHT3X_MEAS_DURATION_US[dev->repeatability];
+}
+
+esp_err_t unit_enviii_sht3x_init( void )
+{
+    memset( &_dev, 0, sizeof( sht3x_t ) );
+
+    ESP_ERROR_CHECK( sht3x_init_desc( &_dev, UNIT_ENVIII_SHT3X_I2C_ADDR, COMMON_I2C_EXTERNAL, PORT_A_SDA_PIN, PORT_A_SCL_PIN ) );
+    ESP_LOGD( _TAG, "Setting SHT30 initial device descriptor success" );
+    ESP_ERROR_CHECK( sht3x_init( &_dev ) );
+    ESP_LOGD( _TAG, "Initializing SHT30 sensor success" );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_sht3x_trigger( void )
+{
+    // periodic mode keeps converting in the sensor
+    if ( _dev.mode != SHT3X_SINGLE_SHOT && _dev.meas_started )
+        return ESP_OK;
+
+    esp_err_t err = sht3x_start_measurement( &_dev, SHT3X_SINGLE_SHOT, REPEATABILITY_MODE );
+    ESP_LOGD( _TAG, "Start single measurement from SHT30 with repeatability %d", REPEATABILITY_MODE );
+
+    return err;
+}
+
+uint8_t unit_enviii_sht3x_duration_get( void )
+{
+    return sht3x_get_measurement_duration( REPEATABILITY_MODE );
+}
+
+esp_err_t unit_enviii_sht3x_fetch( void )
+{
+    if ( !_dev.meas_started )
+    {
+        ESP_LOGE( _TAG, "Measurement is not started" );
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (is_measuring(&_dev))
+    {
+        ESP_LOGE( _TAG, "Measurement is still running" );
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // read raw data
+    uint16_t cmd = shuffle( SHT3X_FETCH_DATA_CMD );
+    esp_err_t err = i2c_dev_read( &( _dev.i2c_dev ), &cmd, 1, _raw_data, sizeof( sht3x_raw_data_t ) );
+    if ( err != ESP_OK )
+        return err;
+
+    // reset first measurement flag
+    _dev.meas_first = false;
+
+    // reset measurement started flag in single shot mode
+    if ( _dev.mode == SHT3X_SINGLE_SHOT )
+        _dev.meas_started = false;
+
+    // check temperature crc
+    if ( unit_enviii_backend_crc8( _raw_data, 2 ) != _raw_data[ 2 ] )
+    {
+        ESP_LOGW( _TAG, "CRC check for temperature data failed" );
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    // check humidity crc
+    if ( unit_enviii_backend_crc8( _raw_data + 3, 2 ) != _raw_data[ 5 ] )
+    {
+        ESP_LOGW( _TAG, "CRC check for humidity data failed" );
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    return ESP_OK;
+}
+
+UNIT_ENVIII_HOT_ATTR esp_err_t unit_enviii_sht3x_compensate( unit_enviii_sample_t *sample )
+{
+    _unit_enviii_sht3x_convert( _raw_data, sample );
+
+    return ESP_OK;
+}
+
+UNIT_ENVIII_HOT_ATTR esp_err_t unit_enviii_sht3x_decode( const uint8_t *raw, unit_enviii_sample_t *sample )
+{
+    if ( raw == NULL || sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+    if ( unit_enviii_backend_crc8( raw, 2 ) != raw[ 2 ] || unit_enviii_backend_crc8( raw + 3, 2 ) != raw[ 5 ] )
+        return ESP_ERR_INVALID_CRC;
+
+    _unit_enviii_sht3x_convert( raw, sample );
+
+    return ESP_OK;
+}
+
+static UNIT_ENVIII_HOT_ATTR void _unit_enviii_sht3x_convert( const uint8_t *raw, unit_enviii_sample_t *sample )
+{
+    int64_t raw_temperature = ( ( uint16_t )raw[ 0 ] << 8 ) | raw[ 1 ];
+    int64_t raw_humidity = ( ( uint16_t )raw[ 3 ] << 8 ) | raw[ 4 ];
+
+    sample->value[ UNIT_ENVIII_CHANNEL_TEMPERATURE ] = ( int32_t )( ( 175000 * raw_temperature + 32767 ) / 65535 ) - 45000;
+    sample->value[ UNIT_ENVIII_CHANNEL_HUMIDITY ] = ( int32_t )( ( 100000 * raw_humidity + 32767 ) / 65535 );
+    sample->channels |= SHT3X_CHANNELS;
+}
+
+#endif
@@ -0,0 +1,182 @@
+/*!
+ * @brief SHT40 temperature and humidity backend of the ENV IV unit
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "i2cdev.h"
+#include "unit_env_iii_backend.h"
+#include "unit_env_iii_noheap.h"
+
+#if UNIT_ENVIII_BACKEND_SHT4X
+
+#define SHT4X_CMD_MEASURE_HIGH      0xFD
+#define SHT4X_CMD_MEASURE_MEDIUM    0xF6
+#define SHT4X_CMD_MEASURE_LOW       0xE0
+#define SHT4X_CMD_SOFT_RESET        0x94
+#define SHT4X_MEAS_DURATION_HIGH    10      /* ms, 8.3 ms max in the datasheet */
+#define SHT4X_MEAS_DURATION_MEDIUM  5       /* ms, 4.5 ms max */
+#define SHT4X_MEAS_DURATION_LOW     2       /* ms, 1.6 ms max */
+
+#if UNIT_ENVIII_SHT_REPEATABILITY == 0
+#define SHT4X_CMD_MEASURE           SHT4X_CMD_MEASURE_HIGH
+#define SHT4X_MEAS_DURATION         SHT4X_MEAS_DURATION_HIGH
+#elif UNIT_ENVIII_SHT_REPEATABILITY == 1
+#define SHT4X_CMD_MEASURE           SHT4X_CMD_MEASURE_MEDIUM
+#define SHT4X_MEAS_DURATION         SHT4X_MEAS_DURATION_MEDIUM
+#else
+#define SHT4X_CMD_MEASURE           SHT4X_CMD_MEASURE_LOW
+#define SHT4X_MEAS_DURATION         SHT4X_MEAS_DURATION_LOW
+#endif
+#define SHT4X_RESET_DURATION        2       /* ms */
+#define SHT4X_RAW_DATA_SIZE         6
+
+#define SHT4X_CHANNELS              ( UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_TEMPERATURE ) | UNIT_ENVIII_CHANNEL_BIT( UNIT_ENVIII_CHANNEL_HUMIDITY ) )
+
+#define CHECK(x) do { esp_err_t __; if ((__ = x) != ESP_OK) return __; } while (0)
+
+static i2c_dev_t _dev;
+static bool _meas_started;
+static int64_t _meas_start_time;
+static uint8_t _raw_data[ SHT4X_RAW_DATA_SIZE ];
+static void _unit_enviii_sht4x_convert( const uint8_t *raw, unit_enviii_sample_t *sample );
+static const char *_TAG = "UNIT_ENV_III_SHT4X";
+
+const unit_enviii_backend_t unit_enviii_backend_sht4x = {
+    .name = "SHT40",
+    .channels = SHT4X_CHANNELS,
+    .init = unit_enviii_sht4x_init,
+    .trigger = unit_enviii_sht4x_trigger,
+    .duration_get = unit_enviii_sht4x_duration_get,
+    .fetch = unit_enviii_sht4x_fetch,
+    .compensate = unit_enviii_sht4x_compensate
+};
+
+esp_err_t unit_enviii_sht4x_init( void )
+{
+    const uint8_t cmd = SHT4X_CMD_SOFT_RESET;
+
+    memset( &_dev, 0, sizeof( i2c_dev_t ) );
+    _dev.port = COMMON_I2C_EXTERNAL;
+    _dev.addr = UNIT_ENVIII_SHT4X_I2C_ADDR;
+    _dev.cfg.sda_io_num = PORT_A_SDA_PIN;
+    _dev.cfg.scl_io_num = PORT_A_SCL_PIN;
+    _dev.cfg.master.clk_speed = UNIT_ENVIII_I2C_FREQ_HZ;
+    CHECK( i2c_dev_create_mutex( &_dev ) );
+    ESP_LOGD( _TAG, "Setting SHT40 initial device descriptor success" );
+
+    CHECK( i2c_dev_write( &_dev, NULL, 0, &cmd, 1 ) );
+    vTaskDelay( pdMS_TO_TICKS( SHT4X_RESET_DURATION ) + 1 );
+    _meas_started = false;
+    ESP_LOGD( _TAG, "Initializing SHT40 sensor success" );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_sht4x_trigger( void )
+{
+    const uint8_t cmd = SHT4X_CMD_MEASURE;
+
+    CHECK( i2c_dev_write( &_dev, NULL, 0, &cmd, 1 ) );
+    _meas_start_time = esp_timer_get_time();
+    _meas_started = true;
+    ESP_LOGD( _TAG, "Start single measurement from SHT40 with precision %d", UNIT_ENVIII_SHT_REPEATABILITY );
+
+    return ESP_OK;
+}
+
+uint8_t unit_enviii_sht4x_duration_get( void )
+{
+    TickType_t duration = pdMS_TO_TICKS( SHT4X_MEAS_DURATION );
+
+    return duration == 0 ? 1 : duration;
+}
+
+esp_err_t unit_enviii_sht4x_fetch( void )
+{
+    if ( !_meas_started )
+    {
+        ESP_LOGE( _TAG, "Measurement is not started" );
+        return ESP_ERR_INVALID_STATE;
+    }
+    if ( esp_timer_get_time() - _meas_start_time < SHT4X_MEAS_DURATION * 1000 )
+    {
+        ESP_LOGE( _TAG, "Measurement is still running" );
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    CHECK( i2c_dev_read( &_dev, NULL, 0, _raw_data, SHT4X_RAW_DATA_SIZE ) );
+    _meas_started = false;
+
+    if ( unit_enviii_backend_crc8( _raw_data, 2 ) != _raw_data[ 2 ] )
+    {
+        ESP_LOGW( _TAG, "CRC check for temperature data failed" );
+        return ESP_ERR_INVALID_CRC;
+    }
+    if ( unit_enviii_backend_crc8( _raw_data + 3, 2 ) != _raw_data[ 5 ] )
+    {
+        ESP_LOGW( _TAG, "CRC check for humidity data failed" );
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    return ESP_OK;
+}
+
+UNIT_ENVIII_HOT_ATTR esp_err_t unit_enviii_sht4x_compensate( unit_enviii_sample_t *sample )
+{
+    _unit_enviii_sht4x_convert( _raw_data, sample );
+
+    return ESP_OK;
+}
+
+UNIT_ENVIII_HOT_ATTR esp_err_t unit_enviii_sht4x_decode( const uint8_t *raw, unit_enviii_sample_t *sample )
+{
+    if ( raw == NULL || sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+    if ( unit_enviii_backend_crc8( raw, 2 ) != raw[ 2 ] || unit_enviii_backend_crc8( raw + 3, 2 ) != raw[ 5 ] )
+        return ESP_ERR_INVALID_CRC;
+
+    _unit_enviii_sht4x_convert( raw, sample );
+
+    return ESP_OK;
+}
+
+static UNIT_ENVIII_HOT_ATTR void _unit_enviii_sht4x_convert( const uint8_t *raw, unit_enviii_sample_t *sample )
+{
+    int64_t raw_temperature = ( ( uint16_t )raw[ 0 ] << 8 ) | raw[ 1 ];
+    int64_t raw_humidity = ( ( uint16_t )raw[ 3 ] << 8 ) | raw[ 4 ];
+    int32_t humidity = ( int32_t )( ( 125000 * raw_humidity + 32767 ) / 65535 ) - 6000;
+
+    // the SHT4x transfer function reaches past 0 and 100 percent
+    if ( humidity < 0 )
+        humidity = 0;
+    if ( humidity > 100000 )
+        humidity = 100000;
+
+    sample->value[ UNIT_ENVIII_CHANNEL_TEMPERATURE ] = ( int32_t )( ( 175000 * raw_temperature + 32767 ) / 65535 ) - 45000;
+    sample->value[ UNIT_ENVIII_CHANNEL_HUMIDITY ] = humidity;
+    sample->channels |= SHT4X_CHANNELS;
+}
+
+#endif
@@ -0,0 +1,339 @@
+/*!
+ * @brief Mergeable fixed-memory quantile sketch for ENV III sensor channels
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <math.h>
+#include <string.h>
+#include "unit_env_iii_sketch.h"
+#include "unit_env_iii_noheap.h"
+
+#define SKETCH_EMPTY            INT32_MIN
+#define SKETCH_HEADER_SIZE      32
+
+#define SKETCH_TEMPERATURE_ALPHA    0.002f
+#define SKETCH_TEMPERATURE_OFFSET   50000
+#define SKETCH_HUMIDITY_ALPHA       0.002f
+#define SKETCH_HUMIDITY_OFFSET      1000
+#define SKETCH_PRESSURE_ALPHA       0.0001f
+#define SKETCH_PRESSURE_OFFSET      0
+
+static void _unit_enviii_sketch_bin_add( unit_enviii_sketch_t *sketch, int32_t index, uint32_t count );
+static void _unit_enviii_sketch_u32_put( uint8_t *buffer, uint32_t value );
+static uint32_t _unit_enviii_sketch_u32_get( const uint8_t *buffer );
+
+static void _unit_enviii_sketch_bin_add( unit_enviii_sketch_t *sketch, int32_t index, uint32_t count )
+{
+    if ( sketch->first_index == SKETCH_EMPTY )
+        sketch->first_index = index - UNIT_ENVIII_SKETCH_BINS / 2;
+
+    if ( index >= sketch->first_index + UNIT_ENVIII_SKETCH_BINS )
+    {
+        // slide the window up, collapsing the bins falling off into the lowest one
+        int32_t shift = index - UNIT_ENVIII_SKETCH_BINS + 1 - sketch->first_index;
+        uint32_t collapsed = 0;
+        int32_t folded = ( shift < UNIT_ENVIII_SKETCH_BINS ) ? shift : UNIT_ENVIII_SKETCH_BINS;
+
+        for ( int32_t i = 0; i < folded; i++ )
+            collapsed += sketch->bins[ i ];
+        if ( shift < UNIT_ENVIII_SKETCH_BINS )
+        {
+            memmove( &sketch->bins[ 0 ], &sketch->bins[ shift ], ( UNIT_ENVIII_SKETCH_BINS - shift ) * sizeof( uint32_t ) );
+            memset( &sketch->bins[ UNIT_ENVIII_SKETCH_BINS - shift ], 0, shift * sizeof( uint32_t ) );
+            sketch->bins[ 0 ] += collapsed;
+        }
+        else
+        {
+            memset( sketch->bins, 0, sizeof( sketch->bins ) );
+            sketch->bins[ 0 ] = collapsed;
+        }
+        sketch->first_index += shift;
+    }
+    else if ( index < sketch->first_index )
+    {
+        int32_t highest = UNIT_ENVIII_SKETCH_BINS - 1;
+        while ( highest > 0 && sketch->bins[ highest ] == 0 )
+            highest--;
+
+        int32_t shift = sketch->first_index - index;
+        if ( highest + shift < UNIT_ENVIII_SKETCH_BINS )
+        {
+            // room above, slide the window down
+            memmove( &sketch->bins[ shift ], &sketch->bins[ 0 ], ( UNIT_ENVIII_SKETCH_BINS - shift ) * sizeof( uint32_t ) );
+            memset( &sketch->bins[ 0 ], 0, shift * sizeof( uint32_t ) );
+            sketch->first_index = index;
+        }
+        else
+        {
+            index = sketch->first_index;
+        }
+    }
+
+    uint32_t *bin = &sketch->bins[ index - sketch->first_index ];
+    *bin = ( *bin > UINT32_MAX - count ) ? UINT32_MAX : *bin + count;
+}
+
+esp_err_t unit_enviii_sketch_init( unit_enviii_sketch_t *sketch, float alpha, int32_t offset )
+{
+    if ( sketch == NULL || !( alpha > 0.0f && alpha < 1.0f ) )
+        return ESP_ERR_INVALID_ARG;
+
+    memset( sketch, 0, sizeof( unit_enviii_sketch_t ) );
+    sketch->alpha = alpha;
+    sketch->log_gamma = logf( ( 1.0f + alpha ) / ( 1.0f - alpha ) );
+    sketch->offset = offset;
+    sketch->min = INT32_MAX;
+    sketch->max = INT32_MIN;
+    sketch->first_index = SKETCH_EMPTY;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_sketch_add( unit_enviii_sketch_t *sketch, int32_t value )
+{
+    if ( sketch == NULL || sketch->log_gamma <= 0.0f )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( value < sketch->min )
+        sketch->min = value;
+    if ( value > sketch->max )
+        sketch->max = value;
+    sketch->count++;
+
+    int64_t shifted = ( int64_t )value + sketch->offset;
+    if ( shifted <= 0 )
+    {
+        sketch->zero_count++;
+        return ESP_OK;
+    }
+
+    _unit_enviii_sketch_bin_add( sketch, ( int32_t )ceilf( logf( ( float )shifted ) / sketch->log_gamma ), 1 );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_sketch_merge( unit_enviii_sketch_t *into, const unit_enviii_sketch_t *from )
+{
+    if ( into == NULL || from == NULL || into->alpha != from->alpha || into->offset != from->offset )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( from->count == 0 )
+        return ESP_OK;
+
+    if ( from->min < into->min )
+        into->min = from->min;
+    if ( from->max > into->max )
+        into->max = from->max;
+    into->count += from->count;
+    into->zero_count += from->zero_count;
+
+    if ( from->first_index == SKETCH_EMPTY )
+        return ESP_OK;
+
+    for ( int32_t i = 0; i < UNIT_ENVIII_SKETCH_BINS; i++ )
+    {
+        if ( from->bins[ i ] )
+            _unit_enviii_sketch_bin_add( into, from->first_index + i, from->bins[ i ] );
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_sketch_quantile_get( const unit_enviii_sketch_t *sketch, float quantile, int32_t *value )
+{
+    if ( sketch == NULL || value == NULL || !( quantile >= 0.0f && quantile <= 1.0f ) )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( sketch->count == 0 )
+        return ESP_ERR_INVALID_STATE;
+
+    float rank = quantile * ( sketch->count - 1 );
+    float cumulative = sketch->zero_count;
+    if ( rank < cumulative || sketch->first_index == SKETCH_EMPTY )
+    {
+        *value = sketch->min;
+        return ESP_OK;
+    }
+
+    int32_t i = 0;
+    for ( ; i < UNIT_ENVIII_SKETCH_BINS - 1; i++ )
+    {
+        cumulative += sketch->bins[ i ];
+        if ( rank < cumulative )
+            break;
+    }
+
+    // bin k holds ( gamma^(k-1), gamma^k ], its midpoint in relative error terms is 2 gamma^k / ( gamma + 1 )
+    float gamma = expf( sketch->log_gamma );
+    float estimate = 2.0f * expf( ( sketch->first_index + i ) * sketch->log_gamma ) / ( gamma + 1.0f );
+    int64_t result = ( int64_t )lroundf( estimate ) - sketch->offset;
+
+    if ( result < sketch->min )
+        result = sketch->min;
+    if ( result > sketch->max )
+        result = sketch->max;
+    *value = ( int32_t )result;
+
+    return ESP_OK;
+}
+
+/*
+ * Layout, little endian:
+ *  version u8, reserved u8, bin count u16, alpha f32, offset i32, min i32,
+ *  max i32, count u32, zero count u32, index of the first bin i32,
+ *  then one unsigned LEB128 varint per bin
+ */
+esp_err_t unit_enviii_sketch_serialize( const unit_enviii_sketch_t *sketch, uint8_t *buffer, size_t size, size_t *written )
+{
+    int32_t low = 0, high = -1;
+
+    if ( sketch == NULL || buffer == NULL || written == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( sketch->first_index != SKETCH_EMPTY )
+    {
+        low = 0;
+        while ( low < UNIT_ENVIII_SKETCH_BINS && sketch->bins[ low ] == 0 )
+            low++;
+        high = UNIT_ENVIII_SKETCH_BINS - 1;
+        while ( high >= low && sketch->bins[ high ] == 0 )
+            high--;
+    }
+
+    if ( size < SKETCH_HEADER_SIZE )
+        return ESP_ERR_INVALID_SIZE;
+
+    uint16_t bins = ( high >= low ) ? ( uint16_t )( high - low + 1 ) : 0;
+    uint32_t alpha;
+    memcpy( &alpha, &sketch->alpha, sizeof( alpha ) );
+
+    buffer[ 0 ] = UNIT_ENVIII_SKETCH_VERSION;
+    buffer[ 1 ] = 0;
+    buffer[ 2 ] = bins & 0xFF;
+    buffer[ 3 ] = bins >> 8;
+    _unit_enviii_sketch_u32_put( buffer + 4, alpha );
+    _unit_enviii_sketch_u32_put( buffer + 8, ( uint32_t )sketch->offset );
+    _unit_enviii_sketch_u32_put( buffer + 12, ( uint32_t )sketch->min );
+    _unit_enviii_sketch_u32_put( buffer + 16, ( uint32_t )sketch->max );
+    _unit_enviii_sketch_u32_put( buffer + 20, sketch->count );
+    _unit_enviii_sketch_u32_put( buffer + 24, sketch->zero_count );
+    _unit_enviii_sketch_u32_put( buffer + 28, ( uint32_t )( bins ? sketch->first_index + low : SKETCH_EMPTY ) );
+
+    size_t position = SKETCH_HEADER_SIZE;
+    for ( int32_t i = low; i <= high; i++ )
+    {
+        uint32_t count = sketch->bins[ i ];
+        do
+        {
+            if ( position >= size )
+                return ESP_ERR_INVALID_SIZE;
+            uint8_t byte = count & 0x7F;
+            count >>= 7;
+            buffer[ position++ ] = byte | ( count ? 0x80 : 0 );
+        } while ( count );
+    }
+    *written = position;
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_sketch_deserialize( unit_enviii_sketch_t *sketch, const uint8_t *buffer, size_t size )
+{
+    float alpha;
+
+    if ( sketch == NULL || buffer == NULL || size < SKETCH_HEADER_SIZE )
+        return ESP_ERR_INVALID_ARG;
+
+    if ( buffer[ 0 ] != UNIT_ENVIII_SKETCH_VERSION )
+        return ESP_ERR_INVALID_VERSION;
+
+    uint16_t bins = buffer[ 2 ] | ( buffer[ 3 ] << 8 );
+    uint32_t alpha_bits = _unit_enviii_sketch_u32_get( buffer + 4 );
+    memcpy( &alpha, &alpha_bits, sizeof( alpha ) );
+
+    if ( bins > UNIT_ENVIII_SKETCH_BINS || unit_enviii_sketch_init( sketch, alpha, ( int32_t )_unit_enviii_sketch_u32_get( buffer + 8 ) ) != ESP_OK )
+        return ESP_ERR_INVALID_ARG;
+
+    sketch->min = ( int32_t )_unit_enviii_sketch_u32_get( buffer + 12 );
+    sketch->max = ( int32_t )_unit_enviii_sketch_u32_get( buffer + 16 );
+    sketch->count = _unit_enviii_sketch_u32_get( buffer + 20 );
+    sketch->zero_count = _unit_enviii_sketch_u32_get( buffer + 24 );
+    if ( bins )
+        sketch->first_index = ( int32_t )_unit_enviii_sketch_u32_get( buffer + 28 );
+
+    size_t position = SKETCH_HEADER_SIZE;
+    for ( uint16_t i = 0; i < bins; i++ )
+    {
+        uint32_t count = 0;
+        uint8_t shift = 0, byte;
+        do
+        {
+            if ( position >= size || shift > 28 )
+                return ESP_ERR_INVALID_ARG;
+            byte = buffer[ position++ ];
+            count |= ( uint32_t )( byte & 0x7F ) << shift;
+            shift += 7;
+        } while ( byte & 0x80 );
+        sketch->bins[ i ] = count;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_sketch_stage_init( unit_enviii_sketch_stage_t *stage )
+{
+    if ( stage == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    unit_enviii_sketch_init( &stage->sketch[ UNIT_ENVIII_CHANNEL_TEMPERATURE ], SKETCH_TEMPERATURE_ALPHA, SKETCH_TEMPERATURE_OFFSET );
+    unit_enviii_sketch_init( &stage->sketch[ UNIT_ENVIII_CHANNEL_HUMIDITY ], SKETCH_HUMIDITY_ALPHA, SKETCH_HUMIDITY_OFFSET );
+    unit_enviii_sketch_init( &stage->sketch[ UNIT_ENVIII_CHANNEL_PRESSURE ], SKETCH_PRESSURE_ALPHA, SKETCH_PRESSURE_OFFSET );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_sketch_stage_process( unit_enviii_sample_t *sample, void *context )
+{
+    unit_enviii_sketch_stage_t *stage = ( unit_enviii_sketch_stage_t * )context;
+
+    if ( sample == NULL || stage == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    for ( uint8_t channel = 0; channel < UNIT_ENVIII_CHANNEL_MAX; channel++ )
+    {
+        if ( sample->channels & UNIT_ENVIII_CHANNEL_BIT( channel ) )
+            unit_enviii_sketch_add( &stage->sketch[ channel ], sample->value[ channel ] );
+    }
+
+    return ESP_OK;
+}
+
+static void _unit_enviii_sketch_u32_put( uint8_t *buffer, uint32_t value )
+{
+    buffer[ 0 ] = value & 0xFF;
+    buffer[ 1 ] = ( value >> 8 ) & 0xFF;
+    buffer[ 2 ] = ( value >> 16 ) & 0xFF;
+    buffer[ 3 ] = value >> 24;
+}
+
+static uint32_t _unit_enviii_sketch_u32_get( const uint8_t *buffer )
+{
+    return buffer[ 0 ] | ( buffer[ 1 ] << 8 ) | ( buffer[ 2 ] << 16 ) | ( ( uint32_t )buffer[ 3 ] << 24 );
+}
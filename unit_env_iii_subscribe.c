@@ -0,0 +1,208 @@
+/*!
+ * @brief Subscriptions of in-process consumers to ENV III samples
+ * @copyright Copyright (c) 2023 by Rashed Talukder[https://rashedtalukder.com]
+ *  
+ * @license SPDX-License-Identifier: Apache 2.0
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @Links [ENV III](https://docs.m5stack.com/en/unit/envIII)
+ * @version  V0.0.1
+ * @date  2023-04-03
+ */
+
+#include <string.h>
+#include <esp_log.h>
+#include "unit_env_iii_subscribe.h"
+#include "unit_env_iii_noheap.h"
+
+typedef struct
+{
+    unit_enviii_subscription_t subscription;
+    unit_enviii_subscribe_stats_t stats;
+    int64_t last_us;
+    bool used;
+    bool started;
+} _unit_enviii_subscribe_slot_t;
+
+static const unit_enviii_sample_t *_unit_enviii_subscribe_record_take( const unit_enviii_sample_t *sample );
+static void _unit_enviii_subscribe_record_put( const unit_enviii_sample_t *record );
+static portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+static _unit_enviii_subscribe_slot_t _slots[ UNIT_ENVIII_SUBSCRIBE_MAX ];
+static unit_enviii_sample_t _records[ UNIT_ENVIII_SUBSCRIBE_RECORDS ];
+static uint8_t _references[ UNIT_ENVIII_SUBSCRIBE_RECORDS ];
+static const char *_TAG = "UNIT_ENV_III_SUBSCRIBE";
+
+esp_err_t unit_enviii_subscribe( const unit_enviii_subscription_t *subscription, uint8_t *id )
+{
+    if ( subscription == NULL || id == NULL || ( subscription->callback == NULL && subscription->queue == NULL ) ||
+         ( subscription->channels & UNIT_ENVIII_CHANNEL_ALL ) == 0 )
+        return ESP_ERR_INVALID_ARG;
+
+    portENTER_CRITICAL( &_lock );
+    for ( uint8_t i = 0; i < UNIT_ENVIII_SUBSCRIBE_MAX; i++ )
+    {
+        if ( _slots[ i ].used )
+            continue;
+
+        memset( &_slots[ i ], 0, sizeof( _unit_enviii_subscribe_slot_t ) );
+        _slots[ i ].subscription = *subscription;
+        _slots[ i ].used = true;
+        portEXIT_CRITICAL( &_lock );
+        *id = i;
+        return ESP_OK;
+    }
+    portEXIT_CRITICAL( &_lock );
+    ESP_LOGW( _TAG, "No free subscription slot" );
+
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t unit_enviii_unsubscribe( uint8_t id )
+{
+    if ( id >= UNIT_ENVIII_SUBSCRIBE_MAX )
+        return ESP_ERR_INVALID_ARG;
+
+    portENTER_CRITICAL( &_lock );
+    bool used = _slots[ id ].used;
+    _slots[ id ].used = false;
+    portEXIT_CRITICAL( &_lock );
+
+    return used ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t unit_enviii_subscribe_release( const unit_enviii_sample_t *sample )
+{
+    if ( sample < _records || sample >= _records + UNIT_ENVIII_SUBSCRIBE_RECORDS )
+        return ESP_ERR_INVALID_ARG;
+
+    _unit_enviii_subscribe_record_put( sample );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_subscribe_dispatch( const unit_enviii_sample_t *sample )
+{
+    const unit_enviii_sample_t *record = NULL;
+    unit_enviii_subscription_t subscription;
+
+    if ( sample == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    for ( uint8_t i = 0; i < UNIT_ENVIII_SUBSCRIBE_MAX; i++ )
+    {
+        _unit_enviii_subscribe_slot_t *slot = &_slots[ i ];
+        bool delivered = false;
+        esp_err_t err = ESP_OK;
+
+        portENTER_CRITICAL( &_lock );
+        if ( !slot->used || !( sample->channels & slot->subscription.channels ) )
+        {
+            portEXIT_CRITICAL( &_lock );
+            continue;
+        }
+        if ( slot->started && sample->timestamp_us - slot->last_us < ( int64_t )slot->subscription.min_interval_ms * 1000 )
+        {
+            slot->stats.skipped++;
+            portEXIT_CRITICAL( &_lock );
+            continue;
+        }
+        // callbacks and queue sends run outside the lock
+        subscription = slot->subscription;
+        portEXIT_CRITICAL( &_lock );
+
+        if ( subscription.callback != NULL )
+        {
+            err = subscription.callback( sample, subscription.user );
+            delivered = true;
+        }
+        else
+        {
+            // one copy for all the queues, taken when the first one needs it
+            if ( record == NULL )
+                record = _unit_enviii_subscribe_record_take( sample );
+            if ( record != NULL )
+            {
+                // count the queue's reference first, its consumer may release the record as soon as it is queued
+                portENTER_CRITICAL( &_lock );
+                _references[ record - _records ]++;
+                portEXIT_CRITICAL( &_lock );
+                if ( xQueueSend( subscription.queue, &record, 0 ) == pdTRUE )
+                    delivered = true;
+                else
+                    _unit_enviii_subscribe_record_put( record );
+            }
+        }
+
+        portENTER_CRITICAL( &_lock );
+        if ( delivered )
+        {
+            slot->stats.delivered++;
+            slot->last_us = sample->timestamp_us;
+            slot->started = true;
+            if ( err != ESP_OK )
+                slot->stats.errors++;
+        }
+        else
+        {
+            slot->stats.dropped++;
+        }
+        portEXIT_CRITICAL( &_lock );
+    }
+
+    // drop the hold of the dispatch, the record is free again if no queue took it
+    if ( record != NULL )
+        _unit_enviii_subscribe_record_put( record );
+
+    return ESP_OK;
+}
+
+esp_err_t unit_enviii_subscribe_stats_get( uint8_t id, unit_enviii_subscribe_stats_t *stats )
+{
+    if ( id >= UNIT_ENVIII_SUBSCRIBE_MAX || stats == NULL )
+        return ESP_ERR_INVALID_ARG;
+
+    portENTER_CRITICAL( &_lock );
+    bool used = _slots[ id ].used;
+    *stats = _slots[ id ].stats;
+    portEXIT_CRITICAL( &_lock );
+
+    return used ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+/* Copies the sample into a free record held by the dispatch, NULL if all are in use */
+static const unit_enviii_sample_t *_unit_enviii_subscribe_record_take( const unit_enviii_sample_t *sample )
+{
+    portENTER_CRITICAL( &_lock );
+    for ( uint8_t i = 0; i < UNIT_ENVIII_SUBSCRIBE_RECORDS; i++ )
+    {
+        if ( _references[ i ] > 0 )
+            continue;
+
+        _references[ i ] = 1;
+        portEXIT_CRITICAL( &_lock );
+        _records[ i ] = *sample;
+        return &_records[ i ];
+    }
+    portEXIT_CRITICAL( &_lock );
+    ESP_LOGD( _TAG, "No free record, queue subscribers miss a sample" );
+
+    return NULL;
+}
+
+static void _unit_enviii_subscribe_record_put( const unit_enviii_sample_t *record )
+{
+    portENTER_CRITICAL( &_lock );
+    if ( _references[ record - _records ] > 0 )
+        _references[ record - _records ]--;
+    portEXIT_CRITICAL( &_lock );
+}